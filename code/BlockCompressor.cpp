@@ -0,0 +1,245 @@
+#include "BlockCompressor.h"
+#include <algorithm>
+#include <climits>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_SSE2
+#endif
+
+// How many steps around the best endpoints HIGH quality searches, on each endpoint
+static const int SEARCH_RADIUS = 2;
+
+// Encodes the texels a layer and a row of blocks at a time, as tasks on the thread pool
+void BlockCompressor::encode(const unsigned char* texels, int width, int height, int layers, int channels, int firstChannel, int channelCount, unsigned char* blocks) {
+    ThreadPool& threads = pool ? *pool : ThreadPool::shared();
+    const int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    const size_t blockBytes = (size_t)8 * channelCount;
+
+    threads.run(layers * blocksHigh, [&](int task) {
+        const int layer = task / blocksHigh, by = task % blocksHigh;
+        unsigned char* out = blocks + ((size_t)layer * blocksHigh + by) * blocksWide * blockBytes;
+
+        for (int bx = 0; bx < blocksWide; bx++) {
+            for (int c = 0; c < channelCount; c++, out += 8) {
+                // The block's texels of this channel, repeating the last row and column of the texture past its edges
+                unsigned char values[16];
+                for (int y = 0; y < 4; y++) {
+                    const int sy = std::min(by * 4 + y, height - 1);
+                    for (int x = 0; x < 4; x++) {
+                        const int sx = std::min(bx * 4 + x, width - 1);
+                        values[y * 4 + x] = texels[(((size_t)layer * height + sy) * width + sx) * channels + firstChannel + c];
+                    }
+                }
+                encodeBlock(values, out);
+            }
+        }
+    });
+}
+
+// Decodes a BC4 block into its 16 texels, in rows of 4
+void BlockCompressor::decodeBlock(const unsigned char* block, unsigned char* texels) {
+    int values[8];
+    palette(block[0], block[1], values);
+    unsigned long long bits = 0;
+    for (int i = 0; i < 6; i++)
+        bits |= (unsigned long long)block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++)
+        texels[i] = (unsigned char)values[(bits >> (3 * i)) & 7];
+}
+
+// Encodes the 16 values of a block into a BC4 block, trying harder to reduce its squared error at each quality level
+void BlockCompressor::encodeBlock(const unsigned char* values, unsigned char* block) {
+    unsigned char indices[16];
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++) {
+        low = std::min(low, (int)values[i]);
+        high = std::max(high, (int)values[i]);
+    }
+
+    // A flat block is its one value exactly
+    if (low == high) {
+        std::fill(indices, indices + 16, 0);
+        packBlock(high, low, indices, block);
+        return;
+    }
+
+    if (quality == FAST) {
+        interpolatedIndices(values, high, low, indices);
+        packBlock(high, low, indices, block);
+        return;
+    }
+
+    // Start from the smallest and largest values, with each texel taking its nearest value
+    int best0 = high, best1 = low;
+    int bestError = chooseIndices(values, best0, best1, indices);
+
+    // Least squares refinement: with the texels' indices fixed, each texel is w * endpoint0 + (1 - w) * endpoint1 for its index's weight w,
+    // so the endpoints that minimize the squared error solve a 2x2 linear system
+    double aa = 0, ab = 0, bb = 0, av = 0, bv = 0;
+    for (int i = 0; i < 16; i++) {
+        double w = indices[i] == 0 ? 1.0 : indices[i] == 1 ? 0.0 : (8 - indices[i]) / 7.0;
+        aa += w * w;
+        ab += w * (1 - w);
+        bb += (1 - w) * (1 - w);
+        av += w * values[i];
+        bv += (1 - w) * values[i];
+    }
+    double determinant = aa * bb - ab * ab;
+    if (determinant > 1e-9) {
+        int e0 = std::clamp((int)((av * bb - bv * ab) / determinant + 0.5), 0, 255);
+        int e1 = std::clamp((int)((bv * aa - av * ab) / determinant + 0.5), 0, 255);
+        unsigned char refined[16];
+        if (e0 > e1) {
+            int error = chooseIndices(values, e0, e1, refined);
+            if (error < bestError) {
+                bestError = error;
+                best0 = e0;
+                best1 = e1;
+            }
+        }
+    }
+
+    // The 6-value mode stores 0 and 255 exactly, so blocks reaching either can spend all 6 other values on the rest of the texels
+    if (low == 0 || high == 255) {
+        int innerLow = 255, innerHigh = 0;
+        for (int i = 0; i < 16; i++) {
+            if (values[i] != 0 && values[i] != 255) {
+                innerLow = std::min(innerLow, (int)values[i]);
+                innerHigh = std::max(innerHigh, (int)values[i]);
+            }
+        }
+        if (innerLow > innerHigh)
+            innerLow = innerHigh = 0;
+        unsigned char extremes[16];
+        int error = chooseIndices(values, innerLow, innerHigh, extremes);
+        if (error < bestError) {
+            bestError = error;
+            best0 = innerLow;
+            best1 = innerHigh;
+        }
+    }
+
+    // Search the endpoints around the best pair, staying in its mode (endpoint0 > endpoint1 for 8 values, <= for 6)
+    if (quality == HIGH) {
+        const bool eightValues = best0 > best1;
+        const int center0 = best0, center1 = best1;
+        for (int d0 = -SEARCH_RADIUS; d0 <= SEARCH_RADIUS && bestError > 0; d0++) {
+            for (int d1 = -SEARCH_RADIUS; d1 <= SEARCH_RADIUS; d1++) {
+                const int e0 = center0 + d0, e1 = center1 + d1;
+                if (e0 < 0 || e0 > 255 || e1 < 0 || e1 > 255 || (e0 > e1) != eightValues)
+                    continue;
+                unsigned char candidate[16];
+                int error = chooseIndices(values, e0, e1, candidate);
+                if (error < bestError) {
+                    bestError = error;
+                    best0 = e0;
+                    best1 = e1;
+                }
+            }
+        }
+    }
+
+    chooseIndices(values, best0, best1, indices);
+    packBlock(best0, best1, indices, block);
+}
+
+// Stores the endpoints and the 16 3-bit indices (texel 0 in the lowest bits) of a BC4 block
+void BlockCompressor::packBlock(int endpoint0, int endpoint1, const unsigned char* indices, unsigned char* block) {
+    block[0] = (unsigned char)endpoint0;
+    block[1] = (unsigned char)endpoint1;
+    unsigned long long bits = 0;
+    for (int i = 0; i < 16; i++)
+        bits |= (unsigned long long)(indices[i] & 7) << (3 * i);
+    for (int i = 0; i < 6; i++)
+        block[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// The 8 values a block with these endpoints decodes to, by index; returns # of values between the endpoints (8 or 6)
+int BlockCompressor::palette(int endpoint0, int endpoint1, int* values) {
+    values[0] = endpoint0;
+    values[1] = endpoint1;
+    if (endpoint0 > endpoint1) {
+        for (int i = 2; i < 8; i++)
+            values[i] = ((8 - i) * endpoint0 + (i - 1) * endpoint1 + 3) / 7;
+        return 8;
+    }
+    for (int i = 2; i < 6; i++)
+        values[i] = ((6 - i) * endpoint0 + (i - 1) * endpoint1 + 2) / 5;
+    values[6] = 0;
+    values[7] = 255;
+    return 6;
+}
+
+// Gives each value the index of its nearest value in the palette of these endpoints; returns the block's squared error
+// Ties go to the lowest index. With SSE2 the 16 values are compared against each palette value at once, by their absolute byte differences
+int BlockCompressor::chooseIndices(const unsigned char* values, int endpoint0, int endpoint1, unsigned char* indices) {
+    int decoded[8];
+    palette(endpoint0, endpoint1, decoded);
+#ifdef BLOCK_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_loadu_si128((const __m128i*)values);
+    __m128i bestDifference = _mm_set1_epi8((char)0xFF), bestIndex = zero;
+    for (int j = 0; j < 8; j++) {
+        const __m128i decodedValue = _mm_set1_epi8((char)decoded[j]);
+        __m128i difference = _mm_or_si128(_mm_subs_epu8(bytes, decodedValue), _mm_subs_epu8(decodedValue, bytes));
+
+        // Only a strictly smaller difference takes the index, as in the scalar loop (index 0 wins any tie with the starting 255)
+        __m128i notCloser = _mm_cmpeq_epi8(_mm_subs_epu8(bestDifference, difference), zero);
+        bestIndex = _mm_or_si128(_mm_and_si128(notCloser, bestIndex), _mm_andnot_si128(notCloser, _mm_set1_epi8((char)j)));
+        bestDifference = _mm_min_epu8(bestDifference, difference);
+    }
+    _mm_storeu_si128((__m128i*)indices, bestIndex);
+
+    // Square and sum the differences, 8 16-bit lanes at a time
+    __m128i low = _mm_unpacklo_epi8(bestDifference, zero), high = _mm_unpackhi_epi8(bestDifference, zero);
+    __m128i sums = _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high));
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sums);
+#else
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+        int bestError = INT_MAX;
+        for (int j = 0; j < 8; j++) {
+            int difference = values[i] - decoded[j];
+            if (difference * difference < bestError) {
+                bestError = difference * difference;
+                indices[i] = (unsigned char)j;
+            }
+        }
+        total += bestError;
+    }
+    return total;
+#endif
+}
+
+// Gives each value the index of the 8-value palette from high (endpoint0) to low (endpoint1) that it's nearest to, by rounding its position
+// between them to one of 8 levels: level 7 is index 0, level 0 index 1, and the levels in between indices 8 - level
+// Positions are rounded half up by adding 0.5 and truncating, on both paths, so both encode alike
+// With SSE2 the 16 values are converted and rounded 4 at a time, and mapped to indices 8 at a time
+void BlockCompressor::interpolatedIndices(const unsigned char* values, int high, int low, unsigned char* indices) {
+    const float scale = 7.0f / (high - low);
+#ifdef BLOCK_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_loadu_si128((const __m128i*)values);
+    const __m128i words[2] = { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+    const __m128 lowValue = _mm_set1_ps((float)low), scales = _mm_set1_ps(scale), half = _mm_set1_ps(0.5f);
+    __m128i levels[2];
+    for (int h = 0; h < 2; h++) {
+        __m128i first = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words[h], zero)), lowValue), scales), half));
+        __m128i second = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(words[h], zero)), lowValue), scales), half));
+        __m128i level = _mm_packs_epi32(first, second);
+
+        // (8 - level) & 7 gives the in-between indices, and 0 and 1 swapped at the ends, which are flipped back by their lowest bit
+        __m128i index = _mm_and_si128(_mm_sub_epi16(_mm_set1_epi16(8), level), _mm_set1_epi16(7));
+        __m128i ends = _mm_or_si128(_mm_cmpeq_epi16(level, zero), _mm_cmpeq_epi16(level, _mm_set1_epi16(7)));
+        levels[h] = _mm_xor_si128(index, _mm_and_si128(ends, _mm_set1_epi16(1)));
+    }
+    _mm_storeu_si128((__m128i*)indices, _mm_packus_epi16(levels[0], levels[1]));
+#else
+    for (int i = 0; i < 16; i++) {
+        int level = (int)((values[i] - low) * scale + 0.5f);
+        indices[i] = (unsigned char)(level == 7 ? 0 : level == 0 ? 1 : 8 - level);
+    }
+#endif
+}
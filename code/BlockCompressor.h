@@ -0,0 +1,53 @@
+#ifndef BLOCKCOMPRESSOR_H
+#define BLOCKCOMPRESSOR_H
+#include <cstddef>
+#include "ThreadPool.h"
+
+// A class for compressing single and two-channel textures (such as noise layers) into the BC4 and BC5 block formats
+// (GL_COMPRESSED_RED_RGTC1 and GL_COMPRESSED_RG_RGTC2), which the GPU samples directly at 4 and 8 bits per texel
+// Each 4x4 block of a channel is stored as two 8-bit endpoints and a 3-bit index per texel picking one of 8 values between them
+// (or 6 values plus 0 and 255, when the first endpoint is the smaller one); BC5 is two BC4 blocks, one per channel
+// Blocks are independent, so rows of blocks are encoded in parallel on a thread pool, and each block's 16 indices are picked with SSE2
+// (the FAST path by rounding their positions between the endpoints, the others by comparing them against every palette value)
+class BlockCompressor {
+    public:
+        // How hard the encoder tries to reduce the error of each block:
+        // FAST uses the block's smallest and largest values as the endpoints
+        // NORMAL also refines the endpoints by least squares on the texels' chosen values, and tries the 6-value mode on blocks that
+        //   reach 0 or 255 (where the ends can be stored exactly), keeping whichever is best
+        // HIGH also searches endpoints a few steps around the best ones found, keeping the pair with the smallest squared error
+        enum Quality { FAST, NORMAL, HIGH };
+
+        // Constructor
+        // Blocks are encoded on the shared thread pool unless setThreadPool() picks another one
+        explicit BlockCompressor(Quality quality) : quality(quality), pool(nullptr) {}
+
+        // Methods
+        void setQuality(Quality encoderQuality) { quality = encoderQuality; }
+        void setThreadPool(ThreadPool* threadPool) { pool = threadPool; }
+
+        // Encodes layers layers of width x height texels of channels bytes each into BC4 blocks of channel firstChannel (channelCount 1),
+        // or BC5 blocks of channels firstChannel and firstChannel + 1 (channelCount 2), one layer of blocks after another
+        // Textures whose sides aren't multiples of 4 have their edge texels repeated to fill the last blocks, as the GPU expects
+        void encode(const unsigned char* texels, int width, int height, int layers, int channels, int firstChannel, int channelCount, unsigned char* blocks);
+
+        // Bytes of the blocks of a width x height layer with channelCount channels (BC4 for 1, BC5 for 2)
+        static size_t compressedBytes(int width, int height, int channelCount) { return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8 * channelCount; }
+
+        // Decodes a BC4 block into its 16 texels, in rows of 4
+        static void decodeBlock(const unsigned char* block, unsigned char* texels);
+
+    private:
+        // Helper methods
+        void encodeBlock(const unsigned char* values, unsigned char* block);
+        static void packBlock(int endpoint0, int endpoint1, const unsigned char* indices, unsigned char* block);
+        static int palette(int endpoint0, int endpoint1, int* values);
+        static int chooseIndices(const unsigned char* values, int endpoint0, int endpoint1, unsigned char* indices);
+        static void interpolatedIndices(const unsigned char* values, int high, int low, unsigned char* indices);
+
+        // Instance variables
+        Quality quality;
+        ThreadPool* pool;  // Thread pool the blocks are encoded on (nullptr for ThreadPool::shared())
+};
+
+#endif
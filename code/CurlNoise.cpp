@@ -0,0 +1,32 @@
+#include "CurlNoise.h"
+
+// Offsets of the three potential components in noise space, whole numbers of cells so each component tiles with the same period as the first
+// and far enough apart that the components are unrelated
+const double POTENTIAL_OFFSETS[3][3] = { { 0.0, 0.0, 0.0 }, { 31.0, 67.0, 13.0 }, { 89.0, 7.0, 43.0 } };
+
+// Constructor
+CurlNoise::CurlNoise(NoiseSource* noiseSource) : noise(noiseSource), period(4), strength(1.0) {}
+
+// Curl noise function
+// Velocity of the field at a point, the curl of the potential (P1, P2, P3): (dP3/dy - dP2/dz, dP1/dz - dP3/dx, dP2/dx - dP1/dy) * strength
+// Derivatives are with respect to noise space, so a velocity of 1 crosses one noise cell per unit of time
+// Parameters: xyz are coordinates of the point, in units of the tile (the field repeats every 1 when the period is whole); velocity receives the 3 components
+void CurlNoise::generate(double x, double y, double z, double* velocity) {
+    // Partial derivatives of each potential component: d[component][axis]
+    double d[3][3];
+    for (int c = 0; c < 3; c++) {
+        noise->generateNoiseD(x * period + POTENTIAL_OFFSETS[c][0], y * period + POTENTIAL_OFFSETS[c][1], z * period + POTENTIAL_OFFSETS[c][2],
+                              period, &d[c][0], &d[c][1], &d[c][2]);
+    }
+
+    velocity[0] = (d[2][1] - d[1][2]) * strength;
+    velocity[1] = (d[0][2] - d[2][0]) * strength;
+    velocity[2] = (d[1][0] - d[0][1]) * strength;
+}
+
+// Curl noise row function
+// Velocities of the row of count points (x0 + i*dx, y, z), written as interleaved x, y, z components (3 per point)
+void CurlNoise::generateRow(double y, double z, double x0, double dx, int count, double* velocity) {
+    for (int i = 0; i < count; i++)
+        generate(x0 + i * dx, y, z, velocity + 3 * i);
+}
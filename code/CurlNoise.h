@@ -0,0 +1,33 @@
+#ifndef CURLNOISE_H
+#define CURLNOISE_H
+#include "NoiseSource.h"
+
+// A class for generating curl noise (Bridson et al., "Curl-Noise for Procedural Fluid Flow"): a velocity field that is the curl of a vector
+// potential made of three independent noise fields. The curl of any field is divergence-free, so fog moved along it swirls around without
+// bunching up or thinning out like it does when the noise coordinates are simply rescaled
+// The partial derivatives of the potential come from the noise source's generateNoiseD(), which is analytic for Perlin noise,
+// so each velocity costs 3 noise evaluations rather than the 18 central differences would need
+class CurlNoise {
+    public:
+        // Constructor
+        // Defaults to a potential with 4 noise cells across a unit of space, tiling every unit, and strength 1
+        explicit CurlNoise(NoiseSource* noiseSource);
+
+        // Methods
+        void setNoiseSource(NoiseSource* noiseSource) { noise = noiseSource; }
+        void setPeriod(int cells) { period = cells; }
+        void setStrength(double value) { strength = value; }
+        int getPeriod() { return period; }
+        double getStrength() { return strength; }
+
+        void generate(double x, double y, double z, double* velocity);
+        void generateRow(double y, double z, double x0, double dx, int count, double* velocity);
+
+    private:
+        // Instance variables
+        NoiseSource* noise;
+        int period;         // # of noise cells across a unit of space, after which the field repeats
+        double strength;    // Velocity scale
+};
+
+#endif
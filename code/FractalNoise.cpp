@@ -0,0 +1,165 @@
+#include "FractalNoise.h"
+#include <algorithm>
+#include <cmath>
+
+// # of points evaluated together per octave, small enough for the chunk's coordinates and sums to stay in L1 cache
+const int FRACTAL_CHUNK = 256;
+
+// Constructor
+FractalNoise::FractalNoise(NoiseSource* noiseSource)
+    : noise(noiseSource), type(FBM), octaves(4), lacunarity(2.0), persistence(0.5), gain(2.0),
+      warpStrength(0.0), warpFrequency(1.0), outputBits(0) {
+    updateCutoff();
+}
+
+void FractalNoise::setOctaves(int octaveCount) {
+    octaves = std::max(octaveCount, 1);
+    updateCutoff();
+}
+
+void FractalNoise::setPersistence(double value) {
+    persistence = value;
+    updateCutoff();
+}
+
+// Turns domain warping on (strength > 0) or off (strength 0)
+// Parameters: strength is how far points are displaced, in noise space units; frequency is the frequency of the displacing noise
+void FractalNoise::setWarp(double strength, double frequency) {
+    warpStrength = strength;
+    warpFrequency = frequency;
+}
+
+// Sets the precision of the output the result will be quantized to, e.g. 8 for 8-bit texels (0 turns the octave cutoff off)
+void FractalNoise::setOutputBits(int bits) {
+    outputBits = bits;
+    updateCutoff();
+}
+
+// Works out how many octaves have to be evaluated
+// Every octave adds amplitude * (a value in [0,1]) to the sum, so if the octaves from k on are skipped and replaced by their midpoint
+// (half their amplitude), the result is off by at most 0.5 * (amplitude of octaves k and up) / amplitudeSum
+// Octaves are skipped from the first k where that is below half a step of the output (0.5 / (2^bits - 1)), so a quantized texel can only
+// differ from the full result where the full result sits within that error of a rounding boundary
+// The cutoff doesn't depend on the point, so it's computed once here rather than per point, and keeps the octave loops branch-free
+// e.g. with persistence 0.5, 32 octaves need only 8 to be evaluated for an 8-bit output
+void FractalNoise::updateCutoff() {
+    // Sum the amplitudes in the same order generate() applies them
+    double amplitude = 1.0;
+    amplitudeSum = 0.0;
+    for (int i = 0; i < octaves; i++) {
+        amplitudeSum += amplitude;
+        amplitude *= persistence;
+    }
+
+    evaluatedOctaves = octaves;
+    skippedAmplitude = 0.0;
+    if (outputBits <= 0)
+        return;
+
+    const double tolerance = 0.5 / (std::pow(2.0, outputBits) - 1);
+    amplitude = 1.0;
+    double remaining = amplitudeSum;
+    for (int i = 0; i < octaves; i++) {
+        if (0.5 * remaining / amplitudeSum < tolerance) {
+            evaluatedOctaves = i;
+            skippedAmplitude = remaining;
+            return;
+        }
+        remaining -= amplitude;
+        amplitude *= persistence;
+    }
+}
+
+// Fractal noise value of a single point, in range [0,1]
+// Parameters: xyz are coordinates of point in 3D space
+double FractalNoise::generate(double x, double y, double z) {
+    double out;
+    generateBatch(&x, &y, &z, &out, 1);
+    return out;
+}
+
+// Fractal noise values of count points given as structure-of-arrays coordinates, in range [0,1]
+// Points are processed a chunk at a time, and within a chunk an octave at a time, so each octave is one batch call into the noise source
+// and the combining loops below have no branches inside them
+// Parameters: xyz are the coordinates; out receives the noise values
+void FractalNoise::generateBatch(const double* x, const double* y, const double* z, double* out, int count) {
+    double px[FRACTAL_CHUNK], py[FRACTAL_CHUNK], pz[FRACTAL_CHUNK];   // Chunk's (warped) coordinates
+    double sx[FRACTAL_CHUNK], sy[FRACTAL_CHUNK], sz[FRACTAL_CHUNK];   // Coordinates scaled to the current octave's frequency
+    double values[FRACTAL_CHUNK], total[FRACTAL_CHUNK], weight[FRACTAL_CHUNK];
+
+    for (int start = 0; start < count; start += FRACTAL_CHUNK) {
+        const int n = std::min(FRACTAL_CHUNK, count - start);
+        for (int i = 0; i < n; i++) {
+            px[i] = x[start + i];
+            py[i] = y[start + i];
+            pz[i] = z[start + i];
+            total[i] = 0.0;
+            weight[i] = 1.0;
+        }
+
+        if (warpStrength != 0.0)
+            warpChunk(px, py, pz, n);
+
+        double frequency = 1.0;
+        double amplitude = 1.0;
+        for (int o = 0; o < evaluatedOctaves; o++) {
+            for (int i = 0; i < n; i++) {
+                sx[i] = px[i] * frequency;
+                sy[i] = py[i] * frequency;
+                sz[i] = pz[i] * frequency;
+            }
+            noise->generateNoiseBatch(sx, sy, sz, values, n, 0);
+
+            switch (type) {
+                case FBM:
+                    for (int i = 0; i < n; i++)
+                        total[i] += values[i] * amplitude;
+                    break;
+                case TURBULENCE:
+                    for (int i = 0; i < n; i++)
+                        total[i] += std::fabs(2.0 * values[i] - 1.0) * amplitude;
+                    break;
+                case RIDGED:
+                    for (int i = 0; i < n; i++) {
+                        double signal = 1.0 - std::fabs(2.0 * values[i] - 1.0);
+                        signal *= signal * weight[i];
+                        weight[i] = std::clamp(signal * gain, 0.0, 1.0);
+                        total[i] += signal * amplitude;
+                    }
+                    break;
+            }
+
+            amplitude *= persistence;
+            frequency *= lacunarity;
+        }
+
+        // Skipped octaves count as their midpoint, then normalize to [0,1]
+        const double tail = 0.5 * skippedAmplitude;
+        for (int i = 0; i < n; i++)
+            out[start + i] = (total[i] + tail) / amplitudeSum;
+    }
+}
+
+// Domain warping: displaces each point by a vector of noise values before the octaves are evaluated, which bends the fractal's features
+// into swirls. The three components come from the same noise at far-apart offsets so they are uncorrelated
+// Parameters: xyz are the chunk's coordinates, updated in place; count is the # of points in the chunk
+void FractalNoise::warpChunk(double* x, double* y, double* z, int count) {
+    const double offsets[3][3] = { { 0.0, 0.0, 0.0 }, { 5.2, 1.3, 7.1 }, { 1.7, 9.2, 3.4 } };
+    double sx[FRACTAL_CHUNK], sy[FRACTAL_CHUNK], sz[FRACTAL_CHUNK];
+    double warp[3][FRACTAL_CHUNK];
+
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < count; i++) {
+            sx[i] = x[i] * warpFrequency + offsets[c][0];
+            sy[i] = y[i] * warpFrequency + offsets[c][1];
+            sz[i] = z[i] * warpFrequency + offsets[c][2];
+        }
+        noise->generateNoiseBatch(sx, sy, sz, warp[c], count, 0);
+    }
+
+    for (int i = 0; i < count; i++) {
+        x[i] += warpStrength * (2.0 * warp[0][i] - 1.0);
+        y[i] += warpStrength * (2.0 * warp[1][i] - 1.0);
+        z[i] += warpStrength * (2.0 * warp[2][i] - 1.0);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef FRACTALNOISE_H
+#define FRACTALNOISE_H
+#include "NoiseSource.h"
+
+// A class for generating fractal noise: layers (octaves) of a noise source at increasing frequency and decreasing amplitude
+// Supports plain fBm, turbulence (absolute value of signed noise) and ridged multifractal noise, each optionally with domain warping
+// Octaves are evaluated with the noise source's batch function, a whole chunk of points per octave
+// When the result only feeds an 8-bit or 16-bit texel, octaves whose combined amplitude is below half an output step are skipped entirely
+class FractalNoise {
+    public:
+        // How the octaves are combined
+        // FBM: sum of amplitude * noise
+        // TURBULENCE: sum of amplitude * |signed noise|, which gives billowy creases where the noise crosses zero
+        // RIDGED: Musgrave's ridged multifractal, sum of amplitude * (1 - |signed noise|)^2 with each octave weighted by the previous one (through gain),
+        // giving sharp ridges with smooth valleys
+        enum Type { FBM, TURBULENCE, RIDGED };
+
+        // Constructor
+        // Defaults to 4 octaves of fBm with lacunarity 2, persistence 0.5, gain 2, no warping and no octave cutoff
+        explicit FractalNoise(NoiseSource* noiseSource);
+
+        // Methods
+        void setNoiseSource(NoiseSource* noiseSource) { noise = noiseSource; }
+        void setType(Type fractalType) { type = fractalType; }
+        void setOctaves(int octaveCount);
+        void setLacunarity(double value) { lacunarity = value; }
+        void setPersistence(double value);
+        void setGain(double value) { gain = value; }
+        void setWarp(double strength, double frequency);
+        void setOutputBits(int bits);
+        int getOctaves() { return octaves; }
+        int getEvaluatedOctaves() { return evaluatedOctaves; }
+
+        double generate(double x, double y, double z);
+        void generateBatch(const double* x, const double* y, const double* z, double* out, int count);
+
+    private:
+        // Helper methods
+        void updateCutoff();
+        void warpChunk(double* x, double* y, double* z, int count);
+
+        // Instance variables
+        NoiseSource* noise;
+        Type type;
+        int octaves;
+        double lacunarity;         // Frequency multiplier between octaves
+        double persistence;        // Amplitude multiplier between octaves
+        double gain;               // Ridged multifractal only: how strongly each octave's value weights the next octave
+        double warpStrength;       // Domain warping: how far points are displaced (0 turns warping off)
+        double warpFrequency;      // Domain warping: frequency of the noise that displaces the points
+        int outputBits;            // Precision of the output the result is quantized to (0 means full precision, no cutoff)
+        int evaluatedOctaves;      // # of octaves actually evaluated after the cutoff
+        double amplitudeSum;       // Sum of the amplitudes of all octaves, for normalizing the result to [0,1]
+        double skippedAmplitude;   // Sum of the amplitudes of the octaves skipped by the cutoff
+};
+
+#endif
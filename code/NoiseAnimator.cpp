@@ -0,0 +1,305 @@
+#include "NoiseAnimator.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+
+// Octave layers stored in the r, g, b and a channels of a slice, the same layers as the static noise texture
+const int SLICE_OCTAVES[4] = { 4, 8, 16, 32 };
+
+// # of PBOs in the ring: one the workers are filling, the others possibly still being read by uploads in flight
+const int RING_SIZE = 3;
+
+// Constructor
+NoiseAnimator::NoiseAnimator(int width, int height, int depth)
+    : width(width), height(height), depth(depth), sliceSize((size_t)width * height * depth * 4), initialized(false),
+      newest(0), newestArrival(0.0), nextSlice(0), fillingSlot(-1), previousUnit(0), currentUnit(0),
+      quit(false), jobGeneration(0), jobData(nullptr), jobTime(0.0), noise(nullptr), activeWorkers(0), nextRow(0), rowsDone(0) {
+    textures[0] = textures[1] = textures[2] = 0;
+}
+
+// Destructor, shutdown() should already have been called while the OpenGL context was still current
+NoiseAnimator::~NoiseAnimator() {
+    shutdown();
+}
+
+// Creates the slice textures and the PBO ring, generates the first two slices and starts the worker threads
+// Parameters: noiseSource is the algorithm to evaluate; currentTime is the time in seconds (glfwGetTime()); previousUnit and currentUnit are
+// the texture units the two most recent slices are bound to (the units of the shader's previousSlice and currentSlice samplers)
+void NoiseAnimator::init(NoiseSource* noiseSource, double currentTime, int previousTextureUnit, int currentTextureUnit) {
+    if (initialized)
+        return;
+
+    noise = noiseSource;
+    previousUnit = previousTextureUnit;
+    currentUnit = currentTextureUnit;
+
+    // Three slice textures are kept rather than two, so an upload never overwrites a texture that frames still in flight are sampling
+    // The first two slices are generated right away, so there is something to blend between from the first frame
+    // They are created through the current slice's unit, which bindTextures() sets up properly afterwards
+    std::vector<unsigned char> data(sliceSize);
+    GLint activeUnit;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+    glActiveTexture(GL_TEXTURE0 + currentUnit);
+    glGenTextures(3, textures);
+    for (int i = 0; i < 3; i++) {
+        if (i < 2)
+            generateRows(data.data(), sliceTime(i), noise, 0, height * depth);
+
+        glBindTexture(GL_TEXTURE_3D, textures[i]);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);   // No mipmaps, as they would have to be rebuilt for every slice
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, depth, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+    }
+    glActiveTexture(activeUnit);
+    newest = 1;
+    newestArrival = currentTime;
+    nextSlice = 2;
+    bindTextures();
+
+    // The PBO ring, allocated once at the size of a slice
+    slots.resize(RING_SIZE);
+    for (UploadSlot& slot : slots) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, sliceSize, nullptr, GL_STREAM_DRAW);
+        slot.fence = nullptr;
+        slot.state = FREE;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Leave a core for the render thread
+    int workerCount = std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 4);
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&NoiseAnimator::workerLoop, this);
+
+    initialized = true;
+}
+
+// Stops the worker threads and deletes the textures and PBOs
+void NoiseAnimator::shutdown() {
+    if (!initialized)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+    quit = false;
+
+    // The workers are gone, so a PBO they were filling can be unmapped safely
+    for (UploadSlot& slot : slots) {
+        if (slot.state == FILLING) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        if (slot.fence)
+            glDeleteSync((GLsync)slot.fence);
+        glDeleteBuffers(1, &slot.pbo);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    slots.clear();
+    fillingSlot = -1;
+
+    glDeleteTextures(3, textures);
+    initialized = false;
+}
+
+// Changes the noise algorithm, taking effect from the next slice that is started
+void NoiseAnimator::setNoiseSource(NoiseSource* noiseSource) {
+    std::lock_guard<std::mutex> lock(mutex);
+    noise = noiseSource;
+}
+
+// Advances the animation, called once per frame on the render thread
+// Nothing in here waits: fences are polled with a zero timeout, a finished slice is only uploaded (from its PBO, so asynchronously)
+// once the shader has fully blended to the current slice, and the next slice is handed to the workers as soon as a PBO is free
+// Parameters: currentTime is the time in seconds (glfwGetTime())
+void NoiseAnimator::update(double currentTime) {
+    if (!initialized)
+        return;
+
+    // Free the PBOs of uploads the GPU has finished
+    for (UploadSlot& slot : slots) {
+        if (slot.state != UPLOADING)
+            continue;
+
+        GLenum status = glClientWaitSync((GLsync)slot.fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            glDeleteSync((GLsync)slot.fence);
+            slot.fence = nullptr;
+            slot.state = FREE;
+        }
+    }
+
+    // Upload the slice the workers finished, if the blend to the current slice is complete
+    // If the workers are late the shader keeps showing the current slice, so the animation slows down rather than the frame rate
+    if (fillingSlot >= 0 && currentTime - newestArrival >= SLICE_INTERVAL && sliceFinished()) {
+        UploadSlot& slot = slots[fillingSlot];
+        uploadSlice(slot.pbo);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.state = UPLOADING;
+        fillingSlot = -1;
+        newestArrival = currentTime;
+    }
+
+    // Start generating the next slice into a free PBO
+    if (fillingSlot < 0) {
+        for (int i = 0; i < (int)slots.size(); i++) {
+            if (slots[i].state != FREE)
+                continue;
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots[i].pbo);
+            void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, sliceSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            if (data) {
+                submitSlice((unsigned char*)data, sliceTime(nextSlice++));
+                slots[i].state = FILLING;
+                fillingSlot = i;
+            }
+            break;
+        }
+    }
+}
+
+// How far the shader should blend from the previous slice to the current one, in range [0,1]
+// Parameters: currentTime is the time in seconds (glfwGetTime())
+float NoiseAnimator::getSliceBlend(double currentTime) {
+    double blend = (currentTime - newestArrival) / SLICE_INTERVAL;
+    return (float)std::clamp(blend, 0.0, 1.0);
+}
+
+// Position of slice # slice along the noise's time axis
+double NoiseAnimator::sliceTime(long slice) {
+    return slice * SLICE_INTERVAL * TIME_SCALE;
+}
+
+// Binds the previous and current slice textures to their texture units, leaving the active unit as it was
+void NoiseAnimator::bindTextures() {
+    GLint activeUnit;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+
+    glActiveTexture(GL_TEXTURE0 + previousUnit);
+    glBindTexture(GL_TEXTURE_3D, textures[(newest + 2) % 3]);
+    glActiveTexture(GL_TEXTURE0 + currentUnit);
+    glBindTexture(GL_TEXTURE_3D, textures[newest]);
+
+    glActiveTexture(activeUnit);
+}
+
+// Copies a finished slice from its PBO into the oldest slice texture, which then becomes the current slice
+// With a PBO bound to GL_PIXEL_UNPACK_BUFFER, glTexSubImage3D takes an offset into the PBO instead of a pointer and returns without waiting for the copy
+void NoiseAnimator::uploadSlice(unsigned int pbo) {
+    newest = (newest + 1) % 3;
+
+    GLint activeUnit;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+    glActiveTexture(GL_TEXTURE0 + currentUnit);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindTexture(GL_TEXTURE_3D, textures[newest]);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, width, height, depth, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glActiveTexture(activeUnit);
+    bindTextures();
+}
+
+// Hands a slice to the workers
+// Only called once the previous slice is finished and no worker is inside it any more, so the row counters can be reset
+// Parameters: data is where the slice is written (a mapped PBO); w is the slice's position along the noise's time axis
+void NoiseAnimator::submitSlice(unsigned char* data, double w) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobData = data;
+        jobTime = w;
+        nextRow = 0;
+        rowsDone = 0;
+        jobGeneration++;
+    }
+    jobReady.notify_all();
+}
+
+// Whether the workers have finished the slice they were given
+// Checking activeWorkers under the lock also makes everything the workers wrote visible to the render thread before the PBO is unmapped
+bool NoiseAnimator::sliceFinished() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rowsDone == height * depth && activeWorkers == 0;
+}
+
+// Body of each worker thread: sleeps until a slice is submitted, then takes rows of it one at a time until there are none left,
+// so faster workers simply do more rows
+void NoiseAnimator::workerLoop() {
+    long seenGeneration = 0;
+    const int rowCount = height * depth;
+
+    while (true) {
+        unsigned char* data;
+        double w;
+        NoiseSource* source;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [&] { return quit || jobGeneration != seenGeneration; });
+            if (quit)
+                return;
+
+            // A worker that wakes up after every row of the slice has been handed out stays out of it: the slice may already be finished and
+            // its PBO unmapped, and once submitSlice() resets the counters it would take a row of the next slice and write it to the old PBO
+            // Joining only while rows are left keeps activeWorkers above 0 until the worker is out, so the slice can't finish under it
+            seenGeneration = jobGeneration;
+            if (nextRow >= rowCount)
+                continue;
+
+            data = jobData;
+            w = jobTime;
+            source = noise;
+            activeWorkers++;
+        }
+
+        int row;
+        while ((row = nextRow++) < rowCount) {
+            generateRows(data, w, source, row, row + 1);
+            rowsDone++;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        activeWorkers--;
+    }
+}
+
+// Generates rows [firstRow, lastRow) of a slice, where row r is row r % height of layer r / height
+// Each texel holds the 4 octave layers, sampled the same way as TextureGenerator::generatePerlinTexture() but with time as the 4th coordinate
+// A row is assembled in a local buffer and copied out whole, since a mapped PBO is usually write-combined memory that is slow to write byte by byte
+// Parameters: data is the slice; w is the slice's position along the noise's time axis; source is the noise algorithm
+void NoiseAnimator::generateRows(unsigned char* data, double w, NoiseSource* source, int firstRow, int lastRow) {
+    std::vector<double> x(width), y(width), z(width), t(width, w), values(width);
+    std::vector<unsigned char> texels(width * 4);
+
+    for (int row = firstRow; row < lastRow; row++) {
+        int j = row % height;
+        int k = row / height;
+
+        for (int c = 0; c < 4; c++) {
+            const int octaves = SLICE_OCTAVES[c];
+            for (int i = 0; i < width; i++) {
+                x[i] = (double)i / width * octaves;
+                y[i] = (double)j / height * octaves;
+                z[i] = (double)k / depth * octaves;
+            }
+
+            // Tiling at octaves cells keeps the slice seamless under GL_REPEAT, like the static noise textures
+            source->generateNoise4DBatch(x.data(), y.data(), z.data(), t.data(), values.data(), width, octaves);
+            for (int i = 0; i < width; i++)
+                texels[i * 4 + c] = (unsigned char)(values[i] * 255);
+        }
+
+        memcpy(data + (size_t)row * width * 4, texels.data(), texels.size());
+    }
+}
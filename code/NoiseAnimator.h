@@ -0,0 +1,83 @@
+#ifndef NOISEANIMATOR_H
+#define NOISEANIMATOR_H
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "NoiseSource.h"
+
+// A class for animating the fog with noise that evolves over time instead of noise textures whose coordinates are rescaled
+// Worker threads evaluate 4D noise (x, y, z, t) to produce time slices of the octave volumes: each slice is one RGBA texture holding the
+// 4, 8, 16 and 32 octave layers in its r, g, b and a channels. The fragment shader blends between the two most recent slices
+// Slices reach the GPU through a ring of pixel buffer objects (PBOs): workers write straight into a mapped PBO, glTexSubImage3D then copies
+// from the PBO asynchronously, and a fence tells us when the PBO can be reused, so the render thread never waits on the GPU or on a worker
+// The CPU and upload budget is fixed: one slice is generated per SLICE_INTERVAL seconds and at most one slice is uploaded per frame
+class NoiseAnimator {
+    public:
+        // Constructor
+        // Parameters: width, height and depth are the dimensions of a slice in texels
+        NoiseAnimator(int width, int height, int depth);
+        ~NoiseAnimator();
+
+        NoiseAnimator(const NoiseAnimator&) = delete;
+        NoiseAnimator& operator=(const NoiseAnimator&) = delete;
+
+        // Methods
+        // init() and shutdown() create and destroy the textures, PBOs and worker threads, and need the OpenGL context to be current
+        void init(NoiseSource* noiseSource, double currentTime, int previousTextureUnit, int currentTextureUnit);
+        void shutdown();
+        void setNoiseSource(NoiseSource* noiseSource);
+        void update(double currentTime);
+        float getSliceBlend(double currentTime);
+
+        // Seconds between two slices, and how far the slices move along the noise's time axis per second
+        static constexpr double SLICE_INTERVAL = 0.25;
+        static constexpr double TIME_SCALE = 0.4;
+
+    private:
+        // State of a PBO in the ring
+        enum SlotState { FREE, FILLING, UPLOADING };
+
+        struct UploadSlot {
+            unsigned int pbo;
+            void* fence;       // GLsync of the upload that last read from the PBO
+            SlotState state;
+        };
+
+        // Helper methods
+        double sliceTime(long slice);
+        void bindTextures();
+        void uploadSlice(unsigned int pbo);
+        void submitSlice(unsigned char* data, double w);
+        bool sliceFinished();
+        void workerLoop();
+        void generateRows(unsigned char* data, double w, NoiseSource* source, int firstRow, int lastRow);
+
+        // Instance variables
+        int width, height, depth;
+        size_t sliceSize;                 // Bytes per slice
+        bool initialized;
+        unsigned int textures[3];         // The two most recent slices, plus the one the next slice is uploaded into
+        int newest;                       // Index into textures of the most recent slice, the one before it is at (newest + 2) % 3
+        double newestArrival;             // Time the most recent slice was uploaded, which the blend factor is measured from
+        long nextSlice;                   // # of the next slice to generate
+        std::vector<UploadSlot> slots;    // The PBO ring
+        int fillingSlot;                  // Slot the workers are generating into, or -1
+        int previousUnit, currentUnit;    // Texture units of the shader's previousSlice and currentSlice samplers
+
+        // Worker threads and the slice they are generating, guarded by mutex
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable jobReady;
+        bool quit;
+        long jobGeneration;               // Bumped for each new slice so sleeping workers notice it
+        unsigned char* jobData;
+        double jobTime;
+        NoiseSource* noise;
+        int activeWorkers;                // Workers still inside a slice, a new slice can't start until this reaches 0
+        std::atomic<int> nextRow;         // Next row of the slice to hand out
+        std::atomic<int> rowsDone;
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include "NoiseCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Maps the whole file at path read-only, leaving the mapping empty if it can't be opened or mapped (or is empty)
+// The file itself is closed straight away, the mapping keeps its contents available until it's unmapped
+MappedFile::MappedFile(const std::string& path) : bytes(nullptr), size(0) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view) {
+                bytes = static_cast<const unsigned char*>(view);
+                size = (size_t)fileSize.QuadPart;
+            }
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return;
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view != MAP_FAILED) {
+            bytes = static_cast<const unsigned char*>(view);
+            size = (size_t)status.st_size;
+        }
+    }
+    close(file);
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : bytes(other.bytes), size(other.size) {
+    other.bytes = nullptr;
+    other.size = 0;
+}
+
+// Unmaps the current file first, then takes over other's mapping
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        std::swap(bytes, other.bytes);
+        std::swap(size, other.size);
+    }
+    return *this;
+}
+
+// Unmaps the file, leaving the mapping empty
+void MappedFile::unmap() {
+    if (bytes) {
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+#else
+        munmap(const_cast<unsigned char*>(bytes), size);
+#endif
+    }
+    bytes = nullptr;
+    size = 0;
+}
+
+// Multipliers of the checksum, odd 64-bit constants with well mixed bits
+static const unsigned long long CHECKSUM_PRIME1 = 0x9E3779B185EBCA87ull;
+static const unsigned long long CHECKSUM_PRIME2 = 0xC2B2AE3D27D4EB4Full;
+
+static unsigned long long rotateLeft(unsigned long long value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Constructor
+Checksum::Checksum(unsigned long long seed) : pendingBytes(0), length(0) {
+    lanes[0] = seed + CHECKSUM_PRIME1 + CHECKSUM_PRIME2;
+    lanes[1] = seed + CHECKSUM_PRIME2;
+    lanes[2] = seed;
+    lanes[3] = seed - CHECKSUM_PRIME1;
+}
+
+// Feeds byteCount more bytes in, completing the pending block first and keeping whatever doesn't fill a block for the next call
+void Checksum::update(const void* data, size_t byteCount) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    length += byteCount;
+
+    if (pendingBytes > 0) {
+        size_t taken = std::min(byteCount, sizeof(pending) - pendingBytes);
+        memcpy(pending + pendingBytes, bytes, taken);
+        pendingBytes += taken;
+        bytes += taken;
+        byteCount -= taken;
+        if (pendingBytes < sizeof(pending))
+            return;
+        block(pending);
+        pendingBytes = 0;
+    }
+
+    for (; byteCount >= sizeof(pending); bytes += sizeof(pending), byteCount -= sizeof(pending))
+        block(bytes);
+
+    memcpy(pending, bytes, byteCount);
+    pendingBytes = byteCount;
+}
+
+// Checksum of everything fed in so far: the lanes are merged, the bytes short of a whole block are mixed in one at a time,
+// and the result is scrambled so that every input bit affects every output bit
+unsigned long long Checksum::value() const {
+    unsigned long long hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+    hash ^= length;
+    for (size_t i = 0; i < pendingBytes; i++)
+        hash = rotateLeft(hash ^ (pending[i] * CHECKSUM_PRIME1), 11) * CHECKSUM_PRIME2;
+
+    hash ^= hash >> 33;
+    hash *= CHECKSUM_PRIME2;
+    hash ^= hash >> 29;
+    hash *= CHECKSUM_PRIME1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Checksum of one block of bytes
+unsigned long long Checksum::of(const void* data, size_t byteCount, unsigned long long seed) {
+    Checksum checksum(seed);
+    checksum.update(data, byteCount);
+    return checksum.value();
+}
+
+// Mixes a 32-byte block into the lanes, 8 bytes per lane
+void Checksum::block(const unsigned char* data) {
+    for (int i = 0; i < 4; i++) {
+        unsigned long long word;
+        memcpy(&word, data + i * 8, sizeof(word));
+        lanes[i] = rotateLeft(lanes[i] + word * CHECKSUM_PRIME2, 31) * CHECKSUM_PRIME1;
+    }
+}
+
+// Constructor
+NoiseCache::NoiseCache(const std::string& directory) : directory(directory) {}
+
+// Maps the entry of key into texels if there's a valid one of byteCount bytes, deleting an invalid one
+bool NoiseCache::load(unsigned long long key, size_t byteCount, MappedFile& texels) {
+    const std::string path = entryPath(key);
+    MappedFile file(path);
+    if (file.empty())
+        return false;
+
+    Header header;
+    bool valid = file.getSize() == HEADER_BYTES + byteCount;
+    if (valid) {
+        memcpy(&header, file.data(), sizeof(header));
+        valid = memcmp(header.magic, "FOGNOISE", sizeof(header.magic)) == 0 && header.formatVersion == FORMAT_VERSION &&
+                header.headerBytes == HEADER_BYTES && header.key == key && header.texelBytes == byteCount &&
+                header.checksum == Checksum::of(file.data() + HEADER_BYTES, byteCount, key);
+    }
+    if (!valid) {
+        file.unmap();
+        std::remove(path.c_str());
+        return false;
+    }
+
+    texels = std::move(file);
+    return true;
+}
+
+// Starts writing the entry of key, which must end up with byteCount bytes of texels
+// The header is written as a placeholder and filled in by commit(), once the checksum is known
+NoiseCache::Writer NoiseCache::store(unsigned long long key, size_t byteCount) {
+    Writer writer;
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    writer.finalPath = entryPath(key);
+    writer.tempPath = writer.finalPath + ".tmp";
+    writer.key = key;
+    writer.expectedBytes = byteCount;
+    writer.checksum = Checksum(key);
+    writer.file = std::fopen(writer.tempPath.c_str(), "wb");
+
+    unsigned char placeholder[HEADER_BYTES] = {};
+    if (writer.file && std::fwrite(placeholder, 1, HEADER_BYTES, writer.file) != HEADER_BYTES)
+        writer.discard();
+    return writer;
+}
+
+// Path of the entry of key: its 16 hex digits in the cache directory
+std::string NoiseCache::entryPath(unsigned long long key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.fognoise", key);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+NoiseCache::Writer::Writer(Writer&& other) noexcept
+    : file(other.file), tempPath(std::move(other.tempPath)), finalPath(std::move(other.finalPath)), key(other.key),
+      expectedBytes(other.expectedBytes), writtenBytes(other.writtenBytes), checksum(other.checksum) {
+    other.file = nullptr;
+}
+
+// An entry that wasn't committed is dropped
+NoiseCache::Writer::~Writer() {
+    discard();
+}
+
+// Appends the next byteCount bytes of texels
+void NoiseCache::Writer::append(const void* data, size_t byteCount) {
+    if (!file)
+        return;
+    if (writtenBytes + byteCount > expectedBytes || std::fwrite(data, 1, byteCount, file) != byteCount) {
+        discard();
+        return;
+    }
+    checksum.update(data, byteCount);
+    writtenBytes += byteCount;
+}
+
+// Fills in the header and moves the finished entry into place; returns whether the entry was stored
+bool NoiseCache::Writer::commit() {
+    if (!file || writtenBytes != expectedBytes) {
+        discard();
+        return false;
+    }
+
+    unsigned char bytes[HEADER_BYTES] = {};
+    Header header;
+    memcpy(header.magic, "FOGNOISE", sizeof(header.magic));
+    header.formatVersion = FORMAT_VERSION;
+    header.headerBytes = HEADER_BYTES;
+    header.key = key;
+    header.texelBytes = expectedBytes;
+    header.checksum = checksum.value();
+    memcpy(bytes, &header, sizeof(header));
+
+    bool written = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(bytes, 1, HEADER_BYTES, file) == HEADER_BYTES;
+    written = std::fclose(file) == 0 && written;
+    file = nullptr;
+
+    // Renaming over an existing file fails on some systems, so any old entry is removed first
+    std::error_code error;
+    if (written) {
+        std::filesystem::remove(finalPath, error);
+        std::filesystem::rename(tempPath, finalPath, error);
+        written = !error;
+    }
+    if (!written)
+        std::remove(tempPath.c_str());
+    return written;
+}
+
+// Closes and deletes the temporary file of an unfinished entry
+void NoiseCache::Writer::discard() {
+    if (file) {
+        std::fclose(file);
+        std::remove(tempPath.c_str());
+    }
+    file = nullptr;
+}
@@ -0,0 +1,127 @@
+#ifndef NOISECACHE_H
+#define NOISECACHE_H
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// A read-only memory mapping of a whole file, unmapped when destroyed (move-only, so it's unmapped exactly once)
+class MappedFile {
+    public:
+        // Constructors: an empty mapping, or a mapping of the file at path (empty if it can't be opened or mapped)
+        MappedFile() : bytes(nullptr), size(0) {}
+        explicit MappedFile(const std::string& path);
+        ~MappedFile() { unmap(); }
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Methods
+        const unsigned char* data() const { return bytes; }
+        size_t getSize() const { return size; }
+        bool empty() const { return bytes == nullptr; }
+        void unmap();
+
+    private:
+        // Instance variables
+        const unsigned char* bytes;  // Start of the mapping, or nullptr
+        size_t size;                 // # of bytes mapped (the whole file)
+};
+
+// A 64-bit checksum of a stream of bytes that can be fed in pieces of any size: the bytes are read 8 at a time into 4 independent lanes
+// (so the multiplies overlap and it runs at several GB/s), which are mixed together with the length at the end
+// Not cryptographic: it catches truncated, corrupted and mixed-up files, not deliberate tampering
+class Checksum {
+    public:
+        // Constructor
+        explicit Checksum(unsigned long long seed = 0);
+
+        // Methods
+        void update(const void* data, size_t byteCount);
+        unsigned long long value() const;
+
+        // Checksum of one block of bytes
+        static unsigned long long of(const void* data, size_t byteCount, unsigned long long seed = 0);
+
+    private:
+        // Helper methods
+        void block(const unsigned char* data);
+
+        // Instance variables
+        unsigned long long lanes[4];
+        unsigned char pending[32];    // Bytes not yet making up a whole 32-byte block
+        size_t pendingBytes;
+        unsigned long long length;    // Total # of bytes fed in
+};
+
+// An on-disk cache of generated noise textures, so a texture that was generated once is loaded instead of generated on later runs
+// Entries are content addressed: the key is a hash of everything the texels depend on (see TextureGenerator::fieldVolumeKey()), so a change
+// of size, noise algorithm, seed or generator version simply looks up another entry, and stale entries are never used
+// Each entry is one file, <key>.fognoise, holding a fixed-size header (format version, key, # of texel bytes and a checksum of the texels)
+// followed by the texels, which are memory mapped and handed to the upload straight from the mapping, without copying them
+// An entry that fails any check (wrong size, format version, key or checksum) is deleted and reported as a miss, so it's regenerated
+// Entries are written to a temporary file that is only renamed into place once complete, so a run that stops halfway never leaves a bad entry
+class NoiseCache {
+    public:
+        // Constructor
+        // Parameters: directory holds the cache files (created when the first entry is stored)
+        explicit NoiseCache(const std::string& directory);
+
+        // Writes an entry a piece at a time (e.g. each slab of a streamed volume), and puts it in place on commit()
+        // Any failure to write just drops the entry, as the cache is only an optimization
+        class Writer {
+            public:
+                Writer() : file(nullptr), key(0), expectedBytes(0), writtenBytes(0), checksum(0) {}
+                ~Writer();
+                Writer(Writer&& other) noexcept;
+                Writer(const Writer&) = delete;
+                Writer& operator=(const Writer&) = delete;
+                Writer& operator=(Writer&&) = delete;
+
+                void append(const void* data, size_t byteCount);
+                bool commit();
+
+            private:
+                friend class NoiseCache;
+                void discard();
+
+                std::FILE* file;
+                std::string tempPath, finalPath;
+                unsigned long long key;
+                size_t expectedBytes;   // # of texel bytes the entry must end up with
+                size_t writtenBytes;
+                Checksum checksum;
+        };
+
+        // Methods
+        // Maps the entry of key into texels if there's a valid one of byteCount bytes; returns whether there was
+        // The texels start texelOffset() bytes into the mapping
+        bool load(unsigned long long key, size_t byteCount, MappedFile& texels);
+        Writer store(unsigned long long key, size_t byteCount);
+
+        static size_t texelOffset() { return HEADER_BYTES; }
+
+        // Version of the file format, changed whenever the header's layout changes
+        static constexpr unsigned int FORMAT_VERSION = 1;
+
+    private:
+        // Header at the start of each entry, padded to HEADER_BYTES so the texels start cache-line aligned
+        struct Header {
+            char magic[8];                 // "FOGNOISE"
+            unsigned int formatVersion;
+            unsigned int headerBytes;
+            unsigned long long key;
+            unsigned long long texelBytes;
+            unsigned long long checksum;   // Checksum of the texels, seeded with the key
+        };
+        static constexpr size_t HEADER_BYTES = 64;
+
+        // Helper methods
+        std::string entryPath(unsigned long long key);
+
+        // Instance variables
+        std::string directory;
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include "NoiseRefiner.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+
+// # of PBOs in the ring: one or two the thread is filling, the others possibly still being read by uploads in flight
+const int RING_SIZE = 3;
+
+// Pixel formats of volumes of 1 to 4 fields
+const GLenum FIELD_FORMATS[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+// Constructor
+NoiseRefiner::NoiseRefiner(int textureUnit, size_t stagingBytes)
+    : unit(textureUnit), staging(stagingBytes), slotBytes(0), refining(false), texelRate(0.0), volumeFields(nullptr), volumeFieldCount(0),
+      volumeWidth(0), volumeHeight(0), volumeDepth(0), pixelFormat(GL_RGBA), mipFilter(TextureGenerator::BOX_MIPS), finished(false), cancelled(false) {
+    generator.setCancelFlag(&cancelled);
+}
+
+// Destructor, stops the thread; shutdown() should already have been called while the OpenGL context was still current to delete the PBOs
+NoiseRefiner::~NoiseRefiner() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelled = true;
+        }
+        slotReady.notify_all();
+        worker.join();
+    }
+}
+
+// Uploads the preview of the noise volume into the noise texture and starts refining it to full resolution, cancelling any refinement in progress
+// The texture must already be bound to the unit given to the constructor with storage for all its levels, and its base level at 0
+// A texture no larger than the preview is simply generated whole, with nothing left to refine
+// Parameters: noiseSource is the algorithm to evaluate, or nullptr for the default Perlin noise (see TextureGenerator::usesDefaultNoise());
+// fields (which must stay valid until the refinement ends), fieldCount and the dimensions are as in TextureGenerator::streamTileableFieldVolume();
+// filter picks how the mip levels are built; entry is the volume's noise cache entry, which the full-resolution chain is written to and
+// committed once it's complete
+void NoiseRefiner::start(NoiseSource* noiseSource, const NoiseField* fields, int fieldCount, int width, int height, int depth,
+                         TextureGenerator::MipFilter filter, NoiseCache::Writer entry) {
+    cancel();
+
+    volumeFields = fields;
+    volumeFieldCount = fieldCount;
+    volumeWidth = width;
+    volumeHeight = height;
+    volumeDepth = depth;
+    pixelFormat = FIELD_FORMATS[fieldCount - 1];
+    mipFilter = filter;
+    cancelled = false;
+
+    // Leave a core for the render thread
+    if (!pool) {
+        pool = std::make_unique<ThreadPool>(std::clamp((int)std::thread::hardware_concurrency() - 1, 1, ThreadPool::MAX_SHARED_THREADS));
+        generator.setThreadPool(pool.get());
+    }
+    generator.setNoiseSource(noiseSource);
+
+    // The preview is the volume's procedural mip levels from the first one no larger than PREVIEW_SIZE down (whichever filter the full chain
+    // uses, as they're the ones that can be generated without the levels above)
+    int previewLevel = 0;
+    while (std::max({ TextureGenerator::mipSize(width, previewLevel), TextureGenerator::mipSize(height, previewLevel),
+                      TextureGenerator::mipSize(depth, previewLevel) }) > PREVIEW_SIZE)
+        previewLevel++;
+
+    GLint activeUnit;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    auto uploadLevel = [&](int level, int firstLayer, int layerCount, const unsigned char* texels) {
+        glTexSubImage3D(GL_TEXTURE_3D, level, 0, 0, firstLayer, TextureGenerator::mipSize(width, level), TextureGenerator::mipSize(height, level),
+                        layerCount, pixelFormat, GL_UNSIGNED_BYTE, texels);
+    };
+    if (previewLevel == 0) {
+        generator.streamTileableFieldMips(width, height, depth, fields, fieldCount, staging, filter,
+            [&](int level, int firstLayer, int layerCount, const unsigned char* texels) {
+                uploadLevel(level, firstLayer, layerCount, texels);
+                entry.append(texels, (size_t)TextureGenerator::mipSize(width, level) * TextureGenerator::mipSize(height, level) * fieldCount * layerCount);
+            });
+        entry.commit();
+        texelRate = generator.getTexelRate();
+        glActiveTexture(activeUnit);
+        return;
+    }
+    generator.streamProceduralMips(width, height, depth, fields, fieldCount, previewLevel, uploadLevel);
+    setBaseLevel(previewLevel);
+    glActiveTexture(activeUnit);
+
+    // The PBO ring, (re)allocated at the size of a slab of this volume
+    slotBytes = std::max(staging, (size_t)width * height * fieldCount);
+    if (slots.empty()) {
+        slots.resize(RING_SIZE);
+        for (UploadSlot& slot : slots) {
+            glGenBuffers(1, &slot.pbo);
+            slot.fence = nullptr;
+        }
+    }
+    for (UploadSlot& slot : slots) {
+        if (slot.fence)
+            glDeleteSync((GLsync)slot.fence);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, slotBytes, nullptr, GL_STREAM_DRAW);
+        slot.fence = nullptr;
+        slot.data = nullptr;
+        slot.state = FREE;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    finished = false;
+    refining = true;
+    worker = std::thread([this, entry = std::move(entry)]() mutable { refine(std::move(entry)); });
+}
+
+// Stops the refinement in progress, if any, leaving the noise texture at whatever it has been refined to (the preview, at least)
+// The thread stops after the slab it's generating, and the slabs it hasn't uploaded yet are dropped along with its cache entry
+void NoiseRefiner::cancel() {
+    if (!refining)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+    }
+    slotReady.notify_all();
+    worker.join();
+    releaseSlots();
+    refining = false;
+}
+
+// Advances the refinement, called once per frame on the render thread; returns true on the frame the full-resolution texture is complete
+// Nothing in here waits: fences are polled with a zero timeout, filled PBOs are uploaded asynchronously, and free PBOs are mapped for the thread
+bool NoiseRefiner::update() {
+    if (!refining)
+        return false;
+
+    // Free the PBOs of uploads the GPU has finished
+    for (UploadSlot& slot : slots) {
+        if (slot.state != UPLOADING)
+            continue;
+
+        GLenum status = glClientWaitSync((GLsync)slot.fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            glDeleteSync((GLsync)slot.fence);
+            slot.fence = nullptr;
+            slot.state = FREE;
+        }
+    }
+
+    // Upload the slabs the thread filled. The thread only finishes after its last slab is filled, so once it's finished and they're all
+    // uploaded, the whole chain is in
+    std::deque<int> filled;
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        filled.swap(filledSlots);
+        done = finished;
+    }
+    GLint activeUnit;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int s : filled)
+        uploadSlot(slots[s]);
+
+    if (done) {
+        worker.join();
+        texelRate = generator.getTexelRate();
+        releaseSlots();
+        setBaseLevel(0);
+        refining = false;
+    }
+    glActiveTexture(activeUnit);
+    if (done)
+        return true;
+
+    // Hand the free PBOs to the thread
+    for (int i = 0; i < (int)slots.size(); i++) {
+        if (slots[i].state != FREE)
+            continue;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots[i].pbo);
+        void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slotBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (data) {
+            slots[i].data = (unsigned char*)data;
+            slots[i].state = MAPPED;
+            std::lock_guard<std::mutex> lock(mutex);
+            mappedSlots.push_back(i);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    slotReady.notify_all();
+    return false;
+}
+
+// Cancels any refinement and deletes the PBOs
+void NoiseRefiner::shutdown() {
+    cancel();
+    for (UploadSlot& slot : slots) {
+        if (slot.fence)
+            glDeleteSync((GLsync)slot.fence);
+        glDeleteBuffers(1, &slot.pbo);
+    }
+    slots.clear();
+}
+
+// Body of the thread: generates the full-resolution chain and copies each slab into a mapped PBO, splitting slabs larger than a PBO,
+// and appends it to the cache entry, which is committed if the chain is complete
+void NoiseRefiner::refine(NoiseCache::Writer entry) {
+    generator.streamTileableFieldMips(volumeWidth, volumeHeight, volumeDepth, volumeFields, volumeFieldCount, staging, mipFilter,
+        [&](int level, int firstLayer, int layerCount, const unsigned char* texels) {
+            const size_t layerBytes = (size_t)TextureGenerator::mipSize(volumeWidth, level) * TextureGenerator::mipSize(volumeHeight, level) * volumeFieldCount;
+            const int slotLayers = (int)std::max<size_t>(1, slotBytes / layerBytes);
+            for (int layer = 0; layer < layerCount; layer += slotLayers) {
+                const int slotIndex = acquireSlot();
+                if (slotIndex < 0)
+                    return;
+
+                UploadSlot& slot = slots[slotIndex];
+                const int count = std::min(slotLayers, layerCount - layer);
+                memcpy(slot.data, texels + layer * layerBytes, count * layerBytes);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                slot.level = level;
+                slot.firstLayer = firstLayer + layer;
+                slot.layerCount = count;
+                filledSlots.push_back(slotIndex);
+            }
+            entry.append(texels, layerBytes * layerCount);
+        });
+    if (!cancelled)
+        entry.commit();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+}
+
+// Waits for a mapped PBO to fill; returns its index, or -1 if the refinement was cancelled
+int NoiseRefiner::acquireSlot() {
+    std::unique_lock<std::mutex> lock(mutex);
+    slotReady.wait(lock, [&] { return cancelled || !mappedSlots.empty(); });
+    if (cancelled)
+        return -1;
+
+    const int slotIndex = mappedSlots.front();
+    mappedSlots.pop_front();
+    return slotIndex;
+}
+
+// Copies a filled PBO's layers into its mip level of the noise texture, which must be bound to the active unit
+// With a PBO bound to GL_PIXEL_UNPACK_BUFFER, glTexSubImage3D takes an offset into the PBO instead of a pointer and returns without waiting for the copy
+void NoiseRefiner::uploadSlot(UploadSlot& slot) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glTexSubImage3D(GL_TEXTURE_3D, slot.level, 0, 0, slot.firstLayer, TextureGenerator::mipSize(volumeWidth, slot.level),
+                    TextureGenerator::mipSize(volumeHeight, slot.level), slot.layerCount, pixelFormat, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.data = nullptr;
+    slot.state = UPLOADING;
+}
+
+// Sets the first mip level the shader samples of the noise texture, which must be bound to the active unit
+void NoiseRefiner::setBaseLevel(int level) {
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, level);
+}
+
+// Unmaps the PBOs that are mapped, filled or not, once the thread has stopped, and frees them
+void NoiseRefiner::releaseSlots() {
+    for (UploadSlot& slot : slots) {
+        if (slot.state == MAPPED) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            slot.data = nullptr;
+            slot.state = FREE;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    mappedSlots.clear();
+    filledSlots.clear();
+}
@@ -0,0 +1,90 @@
+#ifndef NOISEREFINER_H
+#define NOISEREFINER_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "NoiseCache.h"
+#include "TextureGenerator.h"
+
+// A class for generating the noise volume progressively, so the fog shows up straight away instead of after the whole volume is generated
+// start() generates a coarse preview, the volume's procedural mip levels from the first one at most PREVIEW_SIZE texels across down (see
+// TextureGenerator::streamProceduralMips()), and uploads them into the noise texture, whose base level is raised to the preview's top level
+// so the shader samples the preview as if it were the whole texture
+// A background thread then generates the full-resolution chain on its own thread pool and streams it to the render thread a slab at a time
+// through a ring of pixel buffer objects (PBOs), like NoiseAnimator: the thread copies each slab into a mapped PBO, update() uploads it from there
+// with glTexSubImage3D without waiting for the copy, and a fence tells when the PBO can be reused. Once every level is in, the base level goes
+// back to 0 and the fog is sampled at full resolution
+// The preview's size doesn't depend on the texture's, so the time until the first frame stays the same however large the noise texture is
+class NoiseRefiner {
+    public:
+        // Constructor
+        // Parameters: textureUnit is the unit the noise texture is bound to; stagingBytes is the size limit of a slab (and of each PBO)
+        NoiseRefiner(int textureUnit, size_t stagingBytes);
+        ~NoiseRefiner();
+
+        NoiseRefiner(const NoiseRefiner&) = delete;
+        NoiseRefiner& operator=(const NoiseRefiner&) = delete;
+
+        // Methods
+        // start(), cancel(), update() and shutdown() are called on the render thread, and need the OpenGL context to be current
+        void start(NoiseSource* noiseSource, const NoiseField* fields, int fieldCount, int width, int height, int depth,
+                   TextureGenerator::MipFilter filter, NoiseCache::Writer entry);
+        void cancel();
+        bool update();
+        void shutdown();
+        bool isRefining() { return refining; }
+        double getTexelRate() { return texelRate; }
+
+        // Size of the preview along the texture's largest side
+        static constexpr int PREVIEW_SIZE = 32;
+
+    private:
+        // State of a PBO in the ring: MAPPED PBOs are the thread's until it hands them back filled, and stay MAPPED until they're uploaded
+        enum SlotState { FREE, MAPPED, UPLOADING };
+
+        struct UploadSlot {
+            unsigned int pbo;
+            void* fence;            // GLsync of the upload that last read from the PBO
+            unsigned char* data;    // Where the PBO is mapped, while it's MAPPED
+            SlotState state;
+            int level, firstLayer, layerCount;  // Layers of the mip level the PBO holds, once it's filled
+        };
+
+        // Helper methods
+        void refine(NoiseCache::Writer entry);
+        int acquireSlot();
+        void uploadSlot(UploadSlot& slot);
+        void setBaseLevel(int level);
+        void releaseSlots();
+
+        // Instance variables
+        int unit;
+        size_t staging;
+        size_t slotBytes;                     // Size of each PBO: the staging size, or one layer of level 0 if that's larger
+        bool refining;
+        double texelRate;                     // Mtexels/s of the last full-resolution generation
+        std::unique_ptr<ThreadPool> pool;     // Threads the full-resolution chain is generated on, started with the first refinement
+        TextureGenerator generator;
+        std::vector<UploadSlot> slots;        // The PBO ring
+
+        // The volume being refined, set by start() before the thread is started
+        const NoiseField* volumeFields;
+        int volumeFieldCount, volumeWidth, volumeHeight, volumeDepth;
+        unsigned int pixelFormat;
+        TextureGenerator::MipFilter mipFilter;
+
+        // Background thread and the PBOs it's handed, guarded by mutex
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable slotReady;
+        std::deque<int> mappedSlots;          // Mapped PBOs the thread can fill
+        std::deque<int> filledSlots;          // Filled PBOs, in the order they were filled
+        bool finished;                        // Whether the thread has streamed the whole chain
+        std::atomic<bool> cancelled;
+};
+
+#endif
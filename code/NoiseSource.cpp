@@ -0,0 +1,62 @@
+#include "NoiseSource.h"
+#include "FractalNoise.h"
+#include <cstddef>
+#include <vector>
+
+// Generic derivative function
+// Estimates the partial derivatives with central differences, which costs 6 extra noise evaluations
+// Parameters: xyz are coordinates of point in 3D space; repeat is as in generateNoise(); dx, dy and dz receive the partial derivatives
+double NoiseSource::generateNoiseD(double x, double y, double z, int repeat, double* dx, double* dy, double* dz) {
+    // Step size, small compared to a lattice cell but large enough to avoid cancellation
+    const double h = 1e-4;
+
+    *dx = (generateNoise(x + h, y, z, repeat) - generateNoise(x - h, y, z, repeat)) / (2 * h);
+    *dy = (generateNoise(x, y + h, z, repeat) - generateNoise(x, y - h, z, repeat)) / (2 * h);
+    *dz = (generateNoise(x, y, z + h, repeat) - generateNoise(x, y, z - h, repeat)) / (2 * h);
+    return generateNoise(x, y, z, repeat);
+}
+
+// Generic batch function, evaluates each point in turn
+void NoiseSource::generateNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    for (int i = 0; i < count; i++)
+        out[i] = generateNoise(x[i], y[i], z[i], repeat);
+}
+
+// Generic 4D batch function, evaluates each point in turn
+void NoiseSource::generateNoise4DBatch(const double* x, const double* y, const double* z, const double* w, double* out, int count, int repeat) {
+    for (int i = 0; i < count; i++)
+        out[i] = generateNoise4D(x[i], y[i], z[i], w[i], repeat);
+}
+
+// Generic row function, evaluates each point of the row in turn
+void NoiseSource::evaluateRow2D(double y, double x0, double dx, int count, double* out, int repeat) {
+    for (int i = 0; i < count; i++)
+        out[i] = generateNoise(x0 + i * dx, y, 0.0, repeat);
+}
+
+// Generic multi-field row function, evaluates the row of each field as a batch and interleaves the results
+void NoiseSource::evaluateRowFields(double y, double z, double x0, double dx, int count, const NoiseField* fields, int fieldCount, double* out) {
+    std::vector<double> xs(count), ys(count), zs(count), values(count);
+    for (int f = 0; f < fieldCount; f++) {
+        const NoiseField& field = fields[f];
+        for (int i = 0; i < count; i++) {
+            xs[i] = (x0 + i * dx) * field.frequency + field.offset;
+            ys[i] = y * field.frequency + field.offset;
+            zs[i] = z * field.frequency + field.offset;
+        }
+        generateNoiseBatch(xs.data(), ys.data(), zs.data(), values.data(), count, field.repeat);
+        for (int i = 0; i < count; i++)
+            out[(size_t)i * fieldCount + f] = values[i];
+    }
+}
+
+// Octaves function
+// Used to produce a more complex/detailed noise pattern by generating layers of noise at different frequencies and amplitudes, and then combining them
+// Parameters: xyz are point coordinates in 3D space; octaves denotes the # of octaves to use in generating the noise; persistence denotes the degree by which the amplitude changes between octaves
+// This is plain fBm with doubling frequency; FractalNoise offers the other fractal types and settings
+double NoiseSource::generateOctaves(double x, double y, double z, int octaves, double persistence) {
+    FractalNoise fractal(this);
+    fractal.setOctaves(octaves);
+    fractal.setPersistence(persistence);
+    return fractal.generate(x, y, z);
+}
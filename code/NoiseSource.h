@@ -0,0 +1,57 @@
+#ifndef NOISESOURCE_H
+#define NOISESOURCE_H
+#include <cmath>
+
+// One of several noise fields evaluated together by NoiseSource::evaluateRowFields()
+// The field is the noise sampled at (coordinates * frequency + offset), tiling every repeat cells: different frequencies give the octaves of a fractal,
+// different offsets give independent-looking fields of the same algorithm (integer offsets act as seeds for lattice noise such as Perlin noise)
+struct NoiseField {
+    double frequency;  // Noise cells per unit of the shared coordinates
+    double offset;     // Added to each coordinate after scaling
+    int repeat;        // Tiling period in noise cells, as in NoiseSource::generateNoise() (0 for none)
+};
+
+// An interface for noise generators, so texture generation and the fractal (octave) code can switch between noise algorithms (Perlin, Simplex, ...)
+// All noise values are in the range [0,1]
+// Only the single-point 3D and 4D functions have to be implemented; the batch, row and derivative functions have generic versions
+// built on them, which implementations override when they have something faster
+class NoiseSource {
+    public:
+        virtual ~NoiseSource() {}
+
+        // Methods
+        // Readable name of the algorithm, for the UI
+        virtual const char* name() = 0;
+
+        // Whether the algorithm honours the repeat parameter; only these can be baked into the noise textures, which repeat under GL_REPEAT
+        virtual bool tiles() { return true; }
+
+        // Noise value of a point in 3D space; repeat is # times the noise function is repeated in each dimension before wrapping around (tiling), if the algorithm supports tiling
+        virtual double generateNoise(double x, double y, double z, int repeat) = 0;
+
+        // Noise value of a point in 4D space (e.g. 3D space + time); repeat tiles the xyz axes as in generateNoise(), w never wraps
+        virtual double generateNoise4D(double x, double y, double z, double w, int repeat) = 0;
+
+        // Noise value along with its partial derivatives d/dx, d/dy and d/dz (generic version uses central differences)
+        virtual double generateNoiseD(double x, double y, double z, int repeat, double* dx, double* dy, double* dz);
+
+        // Noise values of count points given as structure-of-arrays coordinates
+        virtual void generateNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat);
+        virtual void generateNoise4DBatch(const double* x, const double* y, const double* z, const double* w, double* out, int count, int repeat);
+
+        // Noise values of the row of count points (x0 + i*dx, y, 0), as used to bake 2D textures
+        virtual void evaluateRow2D(double y, double x0, double dx, int count, double* out, int repeat);
+
+        // Largest magnitude of the third derivative along x or y of the noise on the z = 0 plane (the noise evaluateRow2D() samples), in units of
+        // noise cells, which bounds the error of interpolating it; infinity (the generic version) when the algorithm doesn't guarantee one
+        virtual double thirdDerivativeBound2D() { return INFINITY; }
+
+        // Noise values of fieldCount fields along the row of count points (x0 + i*dx, y, z), interleaved so out[i*fieldCount + f] is field f at point i
+        // (e.g. four fields fill the r,g,b,a channels of a row of texels); implementations share as much of the per-point work between fields as they can
+        virtual void evaluateRowFields(double y, double z, double x0, double dx, int count, const NoiseField* fields, int fieldCount, double* out);
+
+        // Layers octaves of noise at doubling frequencies, with the amplitude changing by persistence between octaves; result is in range [0,1]
+        double generateOctaves(double x, double y, double z, int octaves, double persistence);
+};
+
+#endif
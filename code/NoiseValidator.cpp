@@ -0,0 +1,480 @@
+#include "NoiseValidator.h"
+#include "PerlinSIMD.h"
+#include "TextureGenerator.h"
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Points per row for the row variants, and the spacings between them: a fraction of a cell (texture baking), a step that lands at a different
+// spot of each cell, and a step longer than a cell
+const int ROW_LENGTH = 24;
+const double ROW_STEPS[3] = { 1.0 / 64.0, 0.173, 4.0 / 3.0 };
+
+// Tiling periods of the repeat input sets, including 1 (every cell is the same), one that doesn't divide 256 and one past the permutation table
+const int REPEATS[4] = { 1, 7, 256, 300 };
+
+// # of bins of the output histograms
+const int HISTOGRAM_BINS = 16;
+
+// Constructor
+NoiseValidator::NoiseValidator(unsigned int randomSeed, int pointsPerSet) : state(randomSeed * 2654435761ull + 1), points(pointsPerSet) {
+    hashedPerlin.setLatticeHash(Perlin::INTEGER_HASH, 1234);
+    addInputSets();
+}
+
+// Runs every check and prints the results as a table
+// Returns # of variants that went over their bound, so it can be used as the exit code
+int NoiseValidator::run() {
+    printf("Noise validation: %d points per input set, widest SIMD level %s\n", points, PerlinSIMD::levelName(PerlinSIMD::detectLevel()));
+    printf("%-28s %-10s %12s %12s %14s %8s %12s  %s\n", "variant", "inputs", "max abs", "mean abs", "max ULP", "drift", "bound", "result");
+
+    int failures = 0;
+    failures += checkBatchLevels();
+    failures += checkRows();
+    failures += checkFixedPointRows();
+    failures += checkFields();
+    failures += checkDerivatives();
+    failures += checkWorley();
+    failures += checkApproximateTexture();
+
+    if (failures == 0)
+        printf("All variants within their bounds\n");
+    else
+        printf("%d variant(s) over their bound\n", failures);
+    return failures;
+}
+
+// Builds the input sets
+// Random points are spread over several permutation table periods around the origin; the adversarial sets are aimed at the places where a
+// fast path is most likely to differ from the reference: floor() and the lattice index at whole coordinates, rounding of negative numbers,
+// loss of the fractional part and integer overflow at huge coordinates, and wrapping at multiples of the tiling period
+void NoiseValidator::addInputSets() {
+    InputSet uniform = { "random", 0, {}, {}, {} };
+    for (int i = 0; i < points; i++)
+        addPoint(uniform, random(-600, 600), random(-600, 600), random(-600, 600));
+    sets.push_back(uniform);
+
+    // Whole coordinates and the doubles right next to them, in each axis separately and all at once
+    InputSet lattice = { "lattice", 0, {}, {}, {} };
+    for (int i = 0; lattice.x.size() < (size_t)points; i++) {
+        double c[3];
+        for (int a = 0; a < 3; a++) {
+            c[a] = std::floor(random(-520, 520));
+            int side = (int)random(0, 3);
+            if (side == 1)
+                c[a] = std::nextafter(c[a], -INFINITY);
+            else if (side == 2)
+                c[a] = std::nextafter(c[a], INFINITY);
+        }
+        if (i % 4 == 0)
+            c[1] = std::floor(c[1]);
+        addPoint(lattice, c[0], c[1], c[2]);
+    }
+    sets.push_back(lattice);
+
+    InputSet negative = { "negative", 0, {}, {}, {} };
+    for (int i = 0; i < points; i++)
+        addPoint(negative, random(-1.0e4, 0), random(-1.0e4, 0), random(-1.0e4, 0));
+    sets.push_back(negative);
+
+    // Around 1e9, 2^31 and 2^32 (where lattice indices no longer fit in an int) on both sides of the origin
+    const double HUGE_CENTERS[3] = { 1.0e9, 2147483648.0, 4294967296.0 };
+    InputSet huge = { "huge", 0, {}, {}, {} };
+    for (int i = 0; i < points; i++) {
+        double center = HUGE_CENTERS[i % 3] * (i % 2 ? -1 : 1);
+        addPoint(huge, center + random(-8, 8), center + random(-8, 8), random(-8, 8));
+    }
+    sets.push_back(huge);
+
+    // Multiples of the period and their neighbouring doubles, mixed with random points a few periods around the origin
+    static char names[4][16];
+    for (int r = 0; r < 4; r++) {
+        int repeat = REPEATS[r];
+        snprintf(names[r], sizeof(names[r]), "repeat %d", repeat);
+        InputSet wrapped = { names[r], repeat, {}, {}, {} };
+        for (int i = 0; i < points; i++) {
+            if (i % 2) {
+                addPoint(wrapped, random(-3.0 * repeat, 3.0 * repeat), random(-3.0 * repeat, 3.0 * repeat), random(-3.0 * repeat, 3.0 * repeat));
+            } else {
+                double multiple = std::floor(random(-3, 4)) * repeat;
+                double x = i % 6 == 0 ? multiple : std::nextafter(multiple, i % 6 == 2 ? -INFINITY : INFINITY);
+                addPoint(wrapped, x, random(-3.0 * repeat, 3.0 * repeat), std::floor(random(-3, 4)) * repeat);
+            }
+        }
+        sets.push_back(wrapped);
+    }
+}
+
+// Appends a point to an input set
+void NoiseValidator::addPoint(InputSet& set, double x, double y, double z) {
+    set.x.push_back(x);
+    set.y.push_back(y);
+    set.z.push_back(z);
+}
+
+// Uniform random number in [low,high), from a 64-bit linear congruential generator so the inputs are the same on every platform
+double NoiseValidator::random(double low, double high) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return low + (high - low) * ((state >> 11) * (1.0 / 9007199254740992.0));
+}
+
+// Reference values of an input set: the scalar noise function at each point
+void NoiseValidator::reference(Perlin& noise, const InputSet& set, std::vector<double>& values) {
+    values.resize(set.x.size());
+    for (size_t i = 0; i < set.x.size(); i++)
+        values[i] = noise.generatePerlinNoise(set.x[i], set.y[i], set.z[i], set.repeat);
+}
+
+// Reference Worley values of an input set for the given output: every point's distances to the feature points of all 27 cells of its 3x3x3 block,
+// hashed from scratch, with none of Worley::evaluateCell()'s pruning or the distance kernels, so the fast search is checked against a plain one
+void NoiseValidator::worleyReference(Worley::Output output, const InputSet& set, std::vector<double>& values) {
+    values.resize(set.x.size());
+    const unsigned int start = latticeHashStart(worley.getSeed());
+    for (size_t i = 0; i < set.x.size(); i++) {
+        double p[3] = { set.x[i], set.y[i], set.z[i] };
+        double fl[3];
+        for (int a = 0; a < 3; a++) {
+            if (set.repeat > 0) {
+                p[a] = std::fmod(p[a], set.repeat);
+                if (p[a] < 0)
+                    p[a] += set.repeat;
+                if (p[a] >= set.repeat)
+                    p[a] = 0.0;
+            }
+            fl[a] = std::floor(p[a]);
+        }
+
+        // Squared distances to the nearest and second nearest feature points
+        double f1 = INFINITY, f2 = INFINITY;
+        for (int oz = -1; oz <= 1; oz++) {
+            for (int oy = -1; oy <= 1; oy++) {
+                for (int ox = -1; ox <= 1; ox++) {
+                    const int o[3] = { ox, oy, oz };
+                    unsigned int h = start;
+                    for (int a = 0; a < 3; a++) {
+                        // Cell coordinates wrap with the tiling period, or mod 2^32 without one
+                        unsigned int c = set.repeat > 0 ? (unsigned int)(((long long)fl[a] + o[a] + set.repeat) % set.repeat)
+                                                        : (unsigned int)(long long)(fl[a] - 4294967296.0 * std::floor(fl[a] / 4294967296.0)) + (unsigned int)o[a];
+                        h = latticeHashStep(h, c);
+                    }
+                    h = latticeHashFinal(h);
+
+                    double distance = 0.0;
+                    for (int a = 0; a < 3; a++) {
+                        double d = (((h >> (10 * a)) & 1023) + 0.5) / 1024 + o[a] - (p[a] - fl[a]);
+                        distance += d * d;
+                    }
+                    if (distance < f1) {
+                        f2 = f1;
+                        f1 = distance;
+                    }
+                    else if (distance < f2) {
+                        f2 = distance;
+                    }
+                }
+            }
+        }
+
+        double value;
+        if (output == Worley::F1)
+            value = std::sqrt(f1) / Worley::F1_RANGE;
+        else if (output == Worley::F2)
+            value = std::sqrt(f2) / Worley::F2_RANGE;
+        else
+            value = (std::sqrt(f2) - std::sqrt(f1)) / Worley::F2_MINUS_F1_RANGE;
+        values[i] = value < 1.0 ? value : 1.0;
+    }
+}
+
+// Compares a variant's values with the expected ones, prints a line of the table and returns true when the variant is within its bound
+// Parameters: variant and inputs name the table line; expected and actual hold the values; bound is the largest allowed absolute error
+bool NoiseValidator::check(const char* variant, const char* inputs, const std::vector<double>& expected, const std::vector<double>& actual, double bound) {
+    double maxError = 0, sumError = 0;
+    long long maxUlps = 0;
+    int expectedBins[HISTOGRAM_BINS] = {}, actualBins[HISTOGRAM_BINS] = {};
+    bool valid = true;
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        // NaN never compares, so it's caught explicitly
+        if (std::isnan(actual[i]))
+            valid = false;
+        double error = std::fabs(actual[i] - expected[i]);
+        maxError = error > maxError ? error : maxError;
+        sumError += error;
+        long long ulps = ulpDistance(actual[i], expected[i]);
+        maxUlps = ulps > maxUlps ? ulps : maxUlps;
+
+        int e = (int)(expected[i] * HISTOGRAM_BINS), a = (int)(actual[i] * HISTOGRAM_BINS);
+        expectedBins[e < 0 ? 0 : e >= HISTOGRAM_BINS ? HISTOGRAM_BINS - 1 : e]++;
+        actualBins[a < 0 ? 0 : a >= HISTOGRAM_BINS ? HISTOGRAM_BINS - 1 : a]++;
+    }
+
+    // Histogram drift: half the summed difference between the histograms, as a fraction of the values
+    int moved = 0;
+    for (int b = 0; b < HISTOGRAM_BINS; b++)
+        moved += std::abs(expectedBins[b] - actualBins[b]);
+    double drift = expected.empty() ? 0 : moved * 0.5 / expected.size();
+
+    bool passed = valid && maxError <= bound;
+    printf("%-28s %-10s %12.3e %12.3e %14lld %8.5f %12.3e  %s\n", variant, inputs, maxError, expected.empty() ? 0 : sumError / expected.size(),
+           maxUlps, drift, bound, passed ? "pass" : "FAIL");
+    return passed;
+}
+
+// # of representable doubles between a and b, from their bit patterns mapped to integers in the same order as the doubles
+long long NoiseValidator::ulpDistance(double a, double b) {
+    long long ia, ib;
+    memcpy(&ia, &a, sizeof(a));
+    memcpy(&ib, &b, sizeof(b));
+    if (ia < 0)
+        ia = LLONG_MIN - ia;
+    if (ib < 0)
+        ib = LLONG_MIN - ib;
+    // Differences too large for a long long only happen between values of opposite signs far apart, which no bound here allows anyway
+    double distance = (double)ia - (double)ib;
+    return std::fabs(distance) >= 9.2e18 ? LLONG_MAX : std::llabs(ia - ib);
+}
+
+// Batch function at every SIMD level the CPU has, for both lattice modes: bit-identical to the scalar function
+int NoiseValidator::checkBatchLevels() {
+    int failures = 0;
+    PerlinSIMD::Level previous = PerlinSIMD::activeLevel();
+    std::vector<double> expected, actual;
+    char variant[64];
+
+    for (int hashed = 0; hashed < 2; hashed++) {
+        Perlin& noise = hashed ? hashedPerlin : perlin;
+        for (const InputSet& set : sets) {
+            reference(noise, set, expected);
+            actual.resize(expected.size());
+            for (int level = PerlinSIMD::SCALAR; level <= PerlinSIMD::detectLevel(); level++) {
+                PerlinSIMD::forceLevel((PerlinSIMD::Level)level);
+                noise.generatePerlinNoiseBatch(set.x.data(), set.y.data(), set.z.data(), actual.data(), (int)actual.size(), set.repeat);
+                snprintf(variant, sizeof(variant), "%sbatch %s", hashed ? "hashed " : "", PerlinSIMD::levelName((PerlinSIMD::Level)level));
+                failures += !check(variant, set.name, expected, actual, 0.0);
+            }
+        }
+    }
+
+    PerlinSIMD::forceLevel(previous);
+    return failures;
+}
+
+// Row functions: each input point starts a row of ROW_LENGTH points
+int NoiseValidator::checkRows() {
+    int failures = 0;
+    std::vector<double> expected, actual, expected2D, actual2D, row(ROW_LENGTH);
+
+    for (int hashed = 0; hashed < 2; hashed++) {
+        Perlin& noise = hashed ? hashedPerlin : perlin;
+        for (const InputSet& set : sets) {
+            expected.clear();
+            actual.clear();
+            expected2D.clear();
+            actual2D.clear();
+            for (size_t r = 0; r < set.x.size() / ROW_LENGTH; r++) {
+                double dx = ROW_STEPS[r % 3];
+                noise.evaluateRow(set.y[r], set.z[r], set.x[r], dx, ROW_LENGTH, row.data(), set.repeat);
+                actual.insert(actual.end(), row.begin(), row.end());
+                noise.evaluateRow2D(set.y[r], set.x[r], dx, ROW_LENGTH, row.data(), set.repeat);
+                actual2D.insert(actual2D.end(), row.begin(), row.end());
+                for (int i = 0; i < ROW_LENGTH; i++) {
+                    expected.push_back(noise.generatePerlinNoise(set.x[r] + i * dx, set.y[r], set.z[r], set.repeat));
+                    expected2D.push_back(noise.generatePerlinNoise(set.x[r] + i * dx, set.y[r], 0.0, set.repeat));
+                }
+            }
+            failures += !check(hashed ? "hashed evaluateRow" : "evaluateRow", set.name, expected, actual, 0.0);
+            failures += !check(hashed ? "hashed evaluateRow2D" : "evaluateRow2D", set.name, expected2D, actual2D, 0.0);
+        }
+    }
+    return failures;
+}
+
+// Fixed-point rows, in units of the noise value: within one texel step of the truncated reference, or two with dithering (see Perlin.cpp)
+int NoiseValidator::checkFixedPointRows() {
+    int failures = 0;
+    std::vector<double> expected8, expected16, actual8, actual16, dithered;
+    unsigned char texels8[ROW_LENGTH];
+    unsigned short texels16[ROW_LENGTH];
+
+    for (const InputSet& set : sets) {
+        expected8.clear();
+        expected16.clear();
+        actual8.clear();
+        actual16.clear();
+        dithered.clear();
+        for (size_t r = 0; r < set.x.size() / ROW_LENGTH; r++) {
+            double dx = ROW_STEPS[r % 3];
+            for (int i = 0; i < ROW_LENGTH; i++) {
+                double value = perlin.generatePerlinNoise(set.x[r] + i * dx, set.y[r], set.z[r], set.repeat);
+                expected8.push_back((int)(value * 255) / 255.0);
+                expected16.push_back((int)(value * 65535) / 65535.0);
+            }
+
+            perlin.evaluateRow8(set.y[r], set.z[r], set.x[r], dx, ROW_LENGTH, texels8, 1, set.repeat, Perlin::NO_DITHER);
+            for (int i = 0; i < ROW_LENGTH; i++)
+                actual8.push_back(texels8[i] / 255.0);
+            perlin.evaluateRow8(set.y[r], set.z[r], set.x[r], dx, ROW_LENGTH, texels8, 1, set.repeat, (int)r);
+            for (int i = 0; i < ROW_LENGTH; i++)
+                dithered.push_back(texels8[i] / 255.0);
+            perlin.evaluateRow16(set.y[r], set.z[r], set.x[r], dx, ROW_LENGTH, texels16, 1, set.repeat);
+            for (int i = 0; i < ROW_LENGTH; i++)
+                actual16.push_back(texels16[i] / 65535.0);
+        }
+
+        // A hair of slack for the division by 255 or 65535 of both sides
+        failures += !check("evaluateRow8", set.name, expected8, actual8, 1.0 / 255 + 1.0e-12);
+        failures += !check("evaluateRow8 dithered", set.name, expected8, dithered, 2.0 / 255 + 1.0e-12);
+        failures += !check("evaluateRow16", set.name, expected16, actual16, 1.0 / 65535 + 1.0e-12);
+    }
+    return failures;
+}
+
+// Multi-field rows, against each field evaluated on its own at its scaled and offset coordinates
+// The fields of the shared path (same frequency and period, whole offsets) and of the general path are checked separately. The fields compute their
+// coordinates as x * frequency + offset, which may round differently from the reference point, so the bound allows for that rounding (relative
+// to the size of the coordinates) times the steepest slope of the noise
+int NoiseValidator::checkFields() {
+    int failures = 0;
+    std::vector<double> expected, actual, row(ROW_LENGTH * 4);
+
+    for (const InputSet& set : sets) {
+        for (int shared = 1; shared >= 0; shared--) {
+            NoiseField fields[4];
+            for (int f = 0; f < 4; f++) {
+                const double SHARED_OFFSETS[4] = { 0.0, 17.0, -40.0, 101.0 };
+                fields[f].frequency = shared ? 1.0 : 1 << f;
+                fields[f].offset = shared ? SHARED_OFFSETS[f] : 0.25 * f;
+                fields[f].repeat = set.repeat * (shared ? 1 : 1 << f);
+            }
+
+            expected.clear();
+            actual.clear();
+            double largest = 1.0;
+            for (size_t r = 0; r < set.x.size() / ROW_LENGTH; r++) {
+                double dx = ROW_STEPS[r % 3];
+                perlin.evaluateRowFields(set.y[r], set.z[r], set.x[r], dx, ROW_LENGTH, fields, 4, row.data());
+                actual.insert(actual.end(), row.begin(), row.end());
+                for (int i = 0; i < ROW_LENGTH; i++) {
+                    double x = set.x[r] + i * dx;
+                    for (int f = 0; f < 4; f++) {
+                        const NoiseField& field = fields[f];
+                        expected.push_back(perlin.generatePerlinNoise(x * field.frequency + field.offset, set.y[r] * field.frequency + field.offset,
+                                                                      set.z[r] * field.frequency + field.offset, field.repeat));
+                        largest = std::fmax(largest, std::fabs(x * field.frequency) + std::fabs(field.offset));
+                    }
+                }
+            }
+            failures += !check(shared ? "evaluateRowFields shared" : "evaluateRowFields general", set.name, expected, actual, largest * 1.0e-14);
+        }
+    }
+    return failures;
+}
+
+// Analytic derivatives: the value is the reference, and the derivatives match central differences
+// Central differences lose precision as the coordinates grow, so the huge set is left out
+int NoiseValidator::checkDerivatives() {
+    int failures = 0;
+    const double h = 1.0e-5;
+    std::vector<double> expected, actual, expectedD, actualD;
+
+    for (const InputSet& set : sets) {
+        if (strcmp(set.name, "huge") == 0)
+            continue;
+        expected.clear();
+        actual.clear();
+        expectedD.clear();
+        actualD.clear();
+        for (size_t i = 0; i < set.x.size(); i++) {
+            double x = set.x[i], y = set.y[i], z = set.z[i], d[3];
+            actual.push_back(perlin.generatePerlinNoiseD(x, y, z, set.repeat, &d[0], &d[1], &d[2]));
+            expected.push_back(perlin.generatePerlinNoise(x, y, z, set.repeat));
+
+            actualD.insert(actualD.end(), d, d + 3);
+            expectedD.push_back((perlin.generatePerlinNoise(x + h, y, z, set.repeat) - perlin.generatePerlinNoise(x - h, y, z, set.repeat)) / (2 * h));
+            expectedD.push_back((perlin.generatePerlinNoise(x, y + h, z, set.repeat) - perlin.generatePerlinNoise(x, y - h, z, set.repeat)) / (2 * h));
+            expectedD.push_back((perlin.generatePerlinNoise(x, y, z + h, set.repeat) - perlin.generatePerlinNoise(x, y, z - h, set.repeat)) / (2 * h));
+        }
+        failures += !check("noiseD value", set.name, expected, actual, 0.0);
+        // Truncation error of about h^2 times the third derivative, plus the rounding of the noise values divided by 2h
+        failures += !check("noiseD derivatives", set.name, expectedD, actualD, 1.0e-7);
+    }
+    return failures;
+}
+
+// Worley scalar function against the brute-force reference, then its batch function at every SIMD level and its row function against the
+// scalar function, for each output
+int NoiseValidator::checkWorley() {
+    int failures = 0;
+    PerlinSIMD::Level previous = PerlinSIMD::activeLevel();
+    std::vector<double> brute, expected, actual, expected2D, actual2D, row(ROW_LENGTH);
+    const char* OUTPUT_NAMES[3] = { "F1", "F2", "F2-F1" };
+    char variant[64];
+
+    for (int output = Worley::F1; output <= Worley::F2_MINUS_F1; output++) {
+        worley.setOutput((Worley::Output)output);
+        for (const InputSet& set : sets) {
+            expected.resize(set.x.size());
+            actual.resize(set.x.size());
+            for (size_t i = 0; i < set.x.size(); i++)
+                expected[i] = worley.generateWorleyNoise(set.x[i], set.y[i], set.z[i], set.repeat);
+
+            // The pruned search finds the same feature points as the brute-force one; only the rounding of the distances may differ
+            worleyReference((Worley::Output)output, set, brute);
+            snprintf(variant, sizeof(variant), "worley %s 27 cells", OUTPUT_NAMES[output]);
+            failures += !check(variant, set.name, brute, expected, 1.0e-12);
+            for (int level = PerlinSIMD::SCALAR; level <= PerlinSIMD::detectLevel(); level++) {
+                PerlinSIMD::forceLevel((PerlinSIMD::Level)level);
+                worley.generateWorleyNoiseBatch(set.x.data(), set.y.data(), set.z.data(), actual.data(), (int)actual.size(), set.repeat);
+                snprintf(variant, sizeof(variant), "worley %s batch %s", OUTPUT_NAMES[output], PerlinSIMD::levelName((PerlinSIMD::Level)level));
+                failures += !check(variant, set.name, expected, actual, 0.0);
+            }
+            PerlinSIMD::forceLevel(previous);
+
+            expected2D.clear();
+            actual2D.clear();
+            for (size_t r = 0; r < set.x.size() / ROW_LENGTH; r++) {
+                double dx = ROW_STEPS[r % 3];
+                worley.evaluateRow2D(set.y[r], set.x[r], dx, ROW_LENGTH, row.data(), set.repeat);
+                actual2D.insert(actual2D.end(), row.begin(), row.end());
+                for (int i = 0; i < ROW_LENGTH; i++)
+                    expected2D.push_back(worley.generateWorleyNoise(set.x[r] + i * dx, set.y[r], 0.0, set.repeat));
+            }
+            snprintf(variant, sizeof(variant), "worley %s evaluateRow2D", OUTPUT_NAMES[output]);
+            failures += !check(variant, set.name, expected2D, actual2D, 0.0);
+        }
+    }
+
+    worley.setOutput(Worley::F1);
+    return failures;
+}
+
+// Approximate textures against the exact texture, at a few octave counts: within the error bound they report (which is at most the requested
+// error), plus one step for the truncation to 8 bits. The texture is large enough for the interpolation to be used below 16 octaves
+int NoiseValidator::checkApproximateTexture() {
+    int failures = 0;
+    const int SIZE = 1024;
+    const double MAX_ERROR = 2.0 / 255;
+    TextureGenerator generator;
+    TextureImage exactImage, approximateImage;
+    char inputs[32];
+
+    for (int octaves = 1; octaves <= 16; octaves *= 4) {
+        generator.generatePerlinTexture(SIZE, SIZE, octaves, exactImage);
+        double errorBound = 0;
+        generator.generateApproximateTexture(SIZE, SIZE, octaves, MAX_ERROR, &errorBound, approximateImage);
+        const unsigned char* exact = exactImage.data();
+        const unsigned char* approximate = approximateImage.data();
+
+        std::vector<double> expected(SIZE * SIZE), actual(SIZE * SIZE);
+        for (int i = 0; i < SIZE * SIZE; i++) {
+            expected[i] = exact[i * 4] / 255.0;
+            actual[i] = approximate[i * 4] / 255.0;
+        }
+        snprintf(inputs, sizeof(inputs), "%d octaves", octaves);
+        failures += !check("approximate texture", inputs, expected, actual, errorBound + 1.0 / 255 + 1.0e-12);
+    }
+    return failures;
+}
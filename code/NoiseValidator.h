@@ -0,0 +1,57 @@
+#ifndef NOISEVALIDATOR_H
+#define NOISEVALIDATOR_H
+#include <vector>
+#include "Perlin.h"
+#include "Worley.h"
+
+// A class for checking the fast noise paths against the double precision reference, Perlin::generatePerlinNoise()
+// Every variant (the SIMD kernels at each instruction set level, the row, multi-field and fixed-point row functions, the hashed
+// lattice, the analytic derivatives, the Worley distance kernels and approximate textures) is run over the same sets of random and adversarial
+// points: lattice points and their neighbouring doubles, negative coordinates, huge coordinates and points on and around the tiling period
+// Each variant declares the largest absolute error it may have, and fails when it goes over it. The report also gives the mean absolute error,
+// the largest error in units in the last place (ULPs) and the histogram drift (fraction of values that moved to another of 16 bins)
+// Run with the --validate command line option
+class NoiseValidator {
+    public:
+        // Constructor
+        // Parameters: randomSeed picks the random points; pointsPerSet is # of random points in each input set
+        NoiseValidator(unsigned int randomSeed, int pointsPerSet);
+
+        // Methods
+        // Runs every variant on every input set it applies to and prints a table of the results; returns # of variants that went over their bound
+        int run();
+
+    private:
+        // Points to evaluate the noise at, tiling every repeat cells
+        struct InputSet {
+            const char* name;
+            int repeat;
+            std::vector<double> x, y, z;
+        };
+
+        // Helper methods
+        void addInputSets();
+        void addPoint(InputSet& set, double x, double y, double z);
+        double random(double low, double high);
+        void reference(Perlin& noise, const InputSet& set, std::vector<double>& values);
+        void worleyReference(Worley::Output output, const InputSet& set, std::vector<double>& values);
+        bool check(const char* variant, const char* inputs, const std::vector<double>& expected, const std::vector<double>& actual, double bound);
+        long long ulpDistance(double a, double b);
+        int checkBatchLevels();
+        int checkRows();
+        int checkFixedPointRows();
+        int checkFields();
+        int checkDerivatives();
+        int checkWorley();
+        int checkApproximateTexture();
+
+        // Instance variables
+        unsigned long long state;      // State of the random number generator
+        int points;                    // # of random points per input set
+        std::vector<InputSet> sets;    // Input sets shared by all variants
+        Perlin perlin;                 // Reference noise (permutation table)
+        Perlin hashedPerlin;           // Reference noise for the hashed lattice
+        Worley worley;                 // Worley noise, checked against a brute-force search (see worleyReference()) and its own scalar path
+};
+
+#endif
@@ -1,25 +1,15 @@
 #include "Perlin.h"
+#include "PerlinSIMD.h"
 
 // Constructor
-Perlin::Perlin() {
-    // Permutation table, as defined by Ken Perlin
-    // It's an array of random values from 0 - 255 inclusive, will be used in a hash function to determine gradient vector
-    int permutation[512] = {
-        151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,190,
-        6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,88,237,149,56,87,174,20,125,136,
-        171,168,68,175,74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,
-        55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,200,196,135,130,116,
-        188,159,86,164,100,109,198,173,186,3,64,52,217,226,250,124,123,5,202,38,147,118,126,255,82,85,212,207,
-        206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,119,248,152,2,44,154,163,70,221,153,101,155,167,
-        43,172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,218,246,97,228,251,34,242,193,238,
-        210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,49,192,214,31,181,199,106,157,184,84,204,176,
-        115,121,50,45,127,4,150,254,138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
-    };
-
-    // Doubling permutation array to 512 to avoid having to perform modulo arithmetic when indexing the array
-    // p[] will then be used in a hash function to determine gradient vector
-    for (int i = 0; i < 512; i++)
-        p[i] = permutation[i%256];
+// The permutation table is the shared compile-time table from PerlinTables.h, so nothing needs to be copied into the object
+Perlin::Perlin() : p(PERLIN_PERMUTATION.values), latticeHash(PERMUTATION_TABLE), seed(0) {}
+
+// Chooses how lattice points are hashed (see LatticeHash)
+// Parameters: mode is the hash; hashSeed selects the noise field when mode is INTEGER_HASH, and is ignored by the permutation table
+void Perlin::setLatticeHash(LatticeHash mode, unsigned int hashSeed) {
+    latticeHash = mode;
+    seed = hashSeed;
 }
 
 // Fade function, defined by Ken Perlin
@@ -30,6 +20,13 @@ double Perlin::fade(double t) {
     return 6*t*t*t*t*t - 15*t*t*t*t + 10*t*t*t; // 6t^5 - 15t^4 + 10t^3
 }
 
+// Fade derivative function
+// Derivative of fade(), used for the analytic derivatives of the noise
+// Parameter: t is a value between 0 and 1
+double Perlin::fadeDerivative(double t) {
+    return 30*t*t*(t-1)*(t-1); // 30t^4 - 60t^3 + 30t^2
+}
+
 // Increment function 
 // Helper function used to ensure that the noise function generates same value for a given coordinate regardless of its position within the tile, which helps to maintain a level of predictability to make the noise more natural-looking
 // Parameters: val is the value we want to make sure falls within the repeating interval; repeat is # times the noise function is repeated in each dimension before wrapping around (tiling)
@@ -44,36 +41,38 @@ int Perlin::increment(int val, int repeat) {
     return val;
 }
 
+// Wrap function
+// Helper function used to bring a coordinate into the repeating interval [0,repeat), including negative coordinates
+// Parameters: val is the coordinate to wrap; repeat is # times the noise function is repeated in each dimension before wrapping around (tiling), must be > 0
+double Perlin::wrap(double val, int repeat) {
+    // Coordinates that are already inside the interval are returned untouched, which is the common case and skips the fmod
+    if (val >= 0 && val < repeat)
+        return val;
+
+    val = fmod(val,repeat);
+    if (val < 0)
+        val += repeat;
+
+    // Adding repeat to a tiny negative value can round up to repeat itself, which belongs to the start of the next tile
+    if (val >= repeat)
+        val = 0.0;
+
+    return val;
+}
+
 // Gradient function
 // Used for generating a gradient vector for calculating the noise value at a specific point in 3D space
 // This gradient vector determines the direction and magnitude of the change in noise
 // Parameters: hash is used to randomly select one of 16 possibile gradient vectors (each corresponding to a different edge of the cube), xyz are the 3D point's coordinates
 double Perlin::gradient(int hash, double x, double y, double z) {
     // Selection of the gradient vector is based on hash value
-    // Value of hash is always between 0 and 15 to allow the selection of one of the 16 gradient vectors
-    switch(hash % 16)
-    {
-        case 0: return  x + y;
-        case 1: return -x + y;
-        case 2: return  x - y;  
-        case 3: return -x - y;  
-        case 4: return  x + z; 
-        case 5: return -x + z;
-        case 6: return  x - z;
-        case 7: return -x - z;
-        case 8: return  y + z;
-        case 9: return -y + z;
-        case 10: return  y - z; 
-        case 11: return -y - z;
-        case 12: return  y + x;
-        case 13: return -y + z;
-        case 14: return  y - x;
-        case 15: return -y - z;
-        default: return 0;       // Impossible case
-
-        // Example: if we compare a gradient vector A that points in positive x-direction with large magnitude to gradient vector B that points in the negative x-direction with small magnitude, 
-        // we'd see more change in A's noise value at a given point in that direction compared to B
-    }    
+    // Value of hash & 15 is always between 0 and 15 to allow the selection of one of the 16 gradient vectors from PERLIN_GRADIENTS
+    // Looking the vector up and taking the dot product with xyz replaces a 16-way switch whose branches were impossible to predict
+    // Example: hash 0 selects (1,1,0) so the result is x + y; hash 13 selects (0,-1,1) so the result is -y + z
+    // Example: if we compare a gradient vector A that points in positive x-direction with large magnitude to gradient vector B that points in the negative x-direction with small magnitude, 
+    // we'd see more change in A's noise value at a given point in that direction compared to B
+    const int* g = PERLIN_GRADIENTS[hash & 15];
+    return g[0]*x + g[1]*y + g[2]*z;
 }
 
 // Lerp function
@@ -90,26 +89,24 @@ double Perlin::generatePerlinNoise(double x, double y, double z, int repeat) {
     // If repeat <= 0, we don't repeat the noise function, and if repeat > 0, apply the repeat value to the point coordinates
     // Take the mod of each coordinate with the repeat value to wrap the noise function in each dimension
     if (repeat > 0) {
-        x = fmod(x,repeat);  // x ranges from [0,repeat)
-        y = fmod(y,repeat);  // y ranges from [0,repeat)
-        z = fmod(z,repeat);  // z ranges from [0,repeat)
+        x = wrap(x,repeat);  // x ranges from [0,repeat)
+        y = wrap(y,repeat);  // y ranges from [0,repeat)
+        z = wrap(z,repeat);  // z ranges from [0,repeat)
     }
 
     // Calculating the unit cube the the x,y,z point will be located in
-
-    // Compute int part of point coordinates, which are used for permutation table lookup, so we map the coordinates 
-    // to the range [0,255] to match the permutation table range which can be achieved by taking coordinate mod 256
-    int xi = (int)fmod(x,256.0);  // xi ranges from [0,1]
-    int yi = (int)fmod(y,256.0);  // yi ranges from [0,1]
-    int zi = (int)fmod(z,256.0);  // zi ranges from [0,1]
+    // floor() is used rather than an int cast so that negative coordinates land in the correct cube
+    double xfl = floor(x);
+    double yfl = floor(y);
+    double zfl = floor(z);
 
     // Compute decimal part of point coordinates, which are used for interpolation and should be in the range [0,1]
-    double xd = x-(int)x;  // xd ranges from [0,1]
-    double yd = y-(int)y;  // yd ranges from [0,1]
-    double zd = z-(int)z;  // zd ranges from [0,1]
+    double xd = x-xfl;  // xd ranges from [0,1]
+    double yd = y-yfl;  // yd ranges from [0,1]
+    double zd = z-zfl;  // zd ranges from [0,1]
 
     // Example: point(1.8, 2.6, 3.4)
-    // Integer parts -> 1,2,3   so we look up indices 1, 2 and 3 in permutation table
+    // Integer parts -> 1,2,3   so the corners of the cube are hashed from lattice points (1,2,3) to (2,3,4)
     // Fractional parts -> 0.8, 0.6, 0.4   so we use these for interpolation
 
     // Use these decimal parts of point coordinates to interpolate between values, essentially to smoothly blend between values on the grid
@@ -118,24 +115,17 @@ double Perlin::generatePerlinNoise(double x, double y, double z, int repeat) {
     double yf = fade(yd);  // yd ranges from [0,1] so passing yd to fade() creates a value yf that varies smoothly still ranging from [0,1]
     double zf = fade(zd);  // zd ranges from [0,1] so passing zd to fade() creates a value zf that varies smoothly still ranging from [0,1]
 
-    // Hash function for Perlin Noise that uses permutation (p[]) table
-    // The following lines select random gradient vectors for each of the 8 corner points of a cube in 3D space
-    // These 8 corner points form the unit cube that the point of interest is located in
-    // For each of the 8 corners of the unit cube, 3 ints are computed based on the point coordinates, which are used to index into p[] to get an int value that maps to a gradient vector
-    int x0y0z0 = p[p[p[xi]+yi]+zi];
-    int x0y1z0 = p[p[p[xi]+increment(yi,repeat)]+zi];
-    int x0y0z1 = p[p[p[xi]+yi]+increment(zi,repeat)];
-    int x0y1z1 = p[p[p[xi]+increment(yi,repeat)]+increment(zi,repeat)];
-    int x1y0z0 = p[p[p[increment(xi,repeat)]+yi]+zi];
-    int x1y1z0 = p[p[p[increment(xi,repeat)]+increment(yi,repeat)]+zi];
-    int x1y0z1 = p[p[p[increment(xi,repeat)]+yi]+increment(zi,repeat)];
-    int x1y1z1 = p[p[p[increment(xi,repeat)]+increment(yi,repeat)]+increment(zi,repeat)];
-
-    // Example: int x0y0z0 = p[p[p[xi]+yi]+zi]
-    // 1. We get int value at this index xi in p[]
-    // 2. Add yi to the int value from step 1, and then get the int value at this new index in p[]
-    // 3. Add zi to the int value from step 2, and then get the int value at this new index in p[]
-    // Resulting int is a value that maps to a gradient vector in 3D space that' randomly chosen from the permutation table
+    // Hash the 8 corners of the unit cube the point lies in, each hash selects the corner's gradient vector (see cornerHashes())
+    int hashes[8];
+    cornerHashes(xfl,yfl,zfl,repeat,hashes);
+    int x0y0z0 = hashes[0];
+    int x1y0z0 = hashes[1];
+    int x0y1z0 = hashes[2];
+    int x1y1z0 = hashes[3];
+    int x0y0z1 = hashes[4];
+    int x1y0z1 = hashes[5];
+    int x0y1z1 = hashes[6];
+    int x1y1z1 = hashes[7];
 
     // Use linear interpolation to blend together the gradient values for the 8 corners of the cube surrounding the input point to generate a smooth value for that point
     // We're essentially measuring how much the gradient vector and the input vector point in the same direction, and use this to calculate a weighted contribution for the final noise value
@@ -150,28 +140,811 @@ double Perlin::generatePerlinNoise(double x, double y, double z, int repeat) {
     x1 = lerp(gradient(x0y0z1,xd,yd,zd-1), gradient(x1y0z1,xd-1,yd,zd-1), xf);
     // x2 = linear interpolation between gradient vectors at corners (xd,yd-1,zd-1) and (xd-1,yd-1,zd-1) to the final value at the point being evaluated. The contribution is linearly interpolated using xf as the weight, so it ranges from value at (xd,yd-1,zd-1) when xf = 0 to value at (xd-1,yd-1,zd-1) when xf = 1  
     x2 = lerp(gradient(x0y1z1,xd,yd-1,zd-1), gradient(x1y1z1,xd-1,yd-1,zd-1), xf);
-    // y2 = final Perlin noise value for the given point, mapped to range [0,1] instead of [-1,1] for convenience
-    double y2 = (lerp(y1,y2,zf)+1)/2;
-    // cout << y2 << endl;
+    // y2 = interpolates between x1 and x2 based on weight yf, for the far (zd-1) face of the cube
+    double y2 = lerp(x1,x2,yf);
+    // Final Perlin noise value for the given point is the interpolation between the two faces, mapped to range [0,1] instead of [-1,1] for convenience
     return (lerp(y1,y2,zf)+1)/2;
 }
 
+// Perlin noise batch function
+// Evaluates the Perlin noise function for count points at once, using the widest SIMD kernel (AVX-512, AVX2 or SSE4.2) the CPU supports
+// Results are bit-identical to calling generatePerlinNoise() on each point in turn, which is also what the scalar fallback does
+// Parameters: x, y and z are arrays (structure-of-arrays) holding the coordinates of each point; out is the array the count noise values are written to; repeat is as in generatePerlinNoise()
+void Perlin::generatePerlinNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    // The table kernels find neighbouring lattice points after reducing mod 256, which is only periodic for periods up to 256
+    // (the hashed kernels work on the full lattice coordinates, so they handle any period)
+    PerlinSIMD::Level level = repeat > 256 && latticeHash == PERMUTATION_TABLE ? PerlinSIMD::SCALAR : PerlinSIMD::activeLevel();
+    int lanes = PerlinSIMD::laneWidth(level);
+
+    // The kernels expect coordinates that are already wrapped into [0,repeat), so points are staged through small buffers in chunks
+    const int CHUNK = 256;
+    double xs[CHUNK], ys[CHUNK], zs[CHUNK];
+
+    for (int start = 0; start < count; start += CHUNK) {
+        int n = count - start < CHUNK ? count - start : CHUNK;
+        const double* cx = x + start;
+        const double* cy = y + start;
+        const double* cz = z + start;
+
+        if (repeat > 0) {
+            for (int i = 0; i < n; i++) {
+                xs[i] = wrap(cx[i], repeat);
+                ys[i] = wrap(cy[i], repeat);
+                zs[i] = wrap(cz[i], repeat);
+            }
+            cx = xs;
+            cy = ys;
+            cz = zs;
+        }
+
+        // Full vectors go through the SIMD kernel, the leftover points go through the scalar function
+        int vectorCount = n - n % lanes;
+        if (level != PerlinSIMD::SCALAR && latticeHash == INTEGER_HASH)
+            PerlinSIMD::generateHashedNoise(level, seed, cx, cy, cz, out + start, vectorCount, repeat);
+        else if (level != PerlinSIMD::SCALAR)
+            PerlinSIMD::generatePerlinNoise(level, p, cx, cy, cz, out + start, vectorCount, repeat);
+        else
+            vectorCount = 0;
+
+        for (int i = vectorCount; i < n; i++)
+            out[start + i] = generatePerlinNoise(cx[i], cy[i], cz[i], repeat);
+    }
+}
+
+// 2D Gradient function
+// Same as gradient() for a point with z = 0: the z component of the gradient vector drops out, leaving a 2D dot product
+// Parameters: hash selects one of the 16 gradient vectors; xy are the 2D point's coordinates
+double Perlin::gradient2D(int hash, double x, double y) {
+    const int* g = PERLIN_GRADIENTS[hash & 15];
+    return g[0]*x + g[1]*y;
+}
+
+// 2D Perlin noise function
+// Returns exactly the same value as generatePerlinNoise(x, y, 0.0, repeat), but only visits the 4 corners of the unit square the point lies in
+// instead of the 8 corners of a unit cube, since on the z = 0 plane the far face of the cube has a weight of 0
+// Parameters: xy are coordinates of point in 2D space; repeat is # times the noise function is repeated in each dimension before wrapping around (tiling)
+double Perlin::generatePerlinNoise2D(double x, double y, int repeat) {
+    // Wrap the coordinates for tiling, same as generatePerlinNoise()
+    if (repeat > 0) {
+        x = wrap(x,repeat);  // x ranges from [0,repeat)
+        y = wrap(y,repeat);  // y ranges from [0,repeat)
+    }
+
+    // Unit square containing the point
+    double xfl = floor(x);
+    double yfl = floor(y);
+
+    // Decimal parts of the coordinates, and their faded interpolation weights
+    double xd = x-xfl;
+    double yd = y-yfl;
+    double xf = fade(xd);
+    double yf = fade(yd);
+
+    // Hash the 4 corners of the square, with the z = 0 step of the 3D hash so the 2D noise is identical to the z = 0 plane of the 3D noise
+    int hashes[4];
+    cornerHashes2D(xfl,yfl,repeat,hashes);
+    int x0y0 = hashes[0];
+    int x1y0 = hashes[1];
+    int x0y1 = hashes[2];
+    int x1y1 = hashes[3];
+
+    // Blend the gradient contributions along x for both edges of the square, then along y
+    double x1 = lerp(gradient2D(x0y0,xd,yd), gradient2D(x1y0,xd-1,yd), xf);
+    double x2 = lerp(gradient2D(x0y1,xd,yd-1), gradient2D(x1y1,xd-1,yd-1), xf);
+
+    // Final noise value, mapped to range [0,1]
+    return (lerp(x1,x2,yf)+1)/2;
+}
+
+// 2D Perlin noise batch function
+// The 2D counterpart of generatePerlinNoiseBatch(), bit-identical to calling generatePerlinNoise2D() on each point in turn
+// Parameters: x and y are arrays holding the coordinates of each point; out is the array the count noise values are written to; repeat is as in generatePerlinNoise2D()
+void Perlin::generatePerlinNoise2DBatch(const double* x, const double* y, double* out, int count, int repeat) {
+    // The table kernels find neighbouring lattice points after reducing mod 256, which is only periodic for periods up to 256
+    // (the hashed kernels work on the full lattice coordinates, so they handle any period)
+    PerlinSIMD::Level level = repeat > 256 && latticeHash == PERMUTATION_TABLE ? PerlinSIMD::SCALAR : PerlinSIMD::activeLevel();
+    int lanes = PerlinSIMD::laneWidth(level);
+
+    // Same chunked wrapping of the coordinates as generatePerlinNoiseBatch()
+    const int CHUNK = 256;
+    double xs[CHUNK], ys[CHUNK];
+
+    for (int start = 0; start < count; start += CHUNK) {
+        int n = count - start < CHUNK ? count - start : CHUNK;
+        const double* cx = x + start;
+        const double* cy = y + start;
+
+        if (repeat > 0) {
+            for (int i = 0; i < n; i++) {
+                xs[i] = wrap(cx[i], repeat);
+                ys[i] = wrap(cy[i], repeat);
+            }
+            cx = xs;
+            cy = ys;
+        }
+
+        int vectorCount = n - n % lanes;
+        if (level != PerlinSIMD::SCALAR && latticeHash == INTEGER_HASH)
+            PerlinSIMD::generateHashedNoise2D(level, seed, cx, cy, out + start, vectorCount, repeat);
+        else if (level != PerlinSIMD::SCALAR)
+            PerlinSIMD::generatePerlinNoise2D(level, p, cx, cy, out + start, vectorCount, repeat);
+        else
+            vectorCount = 0;
+
+        for (int i = vectorCount; i < n; i++)
+            out[start + i] = generatePerlinNoise2D(cx[i], cy[i], repeat);
+    }
+}
+
+// Perlin noise with derivatives function
+// Returns the same value as generatePerlinNoise() along with the analytic partial derivatives of that value, from a single pass over the unit cube
+// Each corner's contribution is its gradient vector dotted with the offset to the point, so the derivative of the blend is the blend of the gradient
+// vectors plus the change in blend weights (from fadeDerivative()) times the differences between corner contributions
+// This replaces the 4-6 extra noise evaluations that finite differences would need
+// Parameters: xyz are coordinates of point in 3D space; repeat is as in generatePerlinNoise(); dx, dy and dz receive the partial derivatives d/dx, d/dy and d/dz
+double Perlin::generatePerlinNoiseD(double x, double y, double z, int repeat, double* dx, double* dy, double* dz) {
+    if (repeat > 0) {
+        x = wrap(x,repeat);
+        y = wrap(y,repeat);
+        z = wrap(z,repeat);
+    }
+
+    // Unit cube containing the point and the point's position inside it, as in generatePerlinNoise()
+    double xfl = floor(x);
+    double yfl = floor(y);
+    double zfl = floor(z);
+    double xd = x-xfl;
+    double yd = y-yfl;
+    double zd = z-zfl;
+
+    // Blend weights and their derivatives
+    double u = fade(xd), du = fadeDerivative(xd);
+    double v = fade(yd), dv = fadeDerivative(yd);
+    double w = fade(zd), dw = fadeDerivative(zd);
+
+    // Gradient vectors of the 8 corners, same hashes as generatePerlinNoise()
+    int hashes[8];
+    cornerHashes(xfl,yfl,zfl,repeat,hashes);
+    const int* g000 = PERLIN_GRADIENTS[hashes[0] & 15];
+    const int* g100 = PERLIN_GRADIENTS[hashes[1] & 15];
+    const int* g010 = PERLIN_GRADIENTS[hashes[2] & 15];
+    const int* g110 = PERLIN_GRADIENTS[hashes[3] & 15];
+    const int* g001 = PERLIN_GRADIENTS[hashes[4] & 15];
+    const int* g101 = PERLIN_GRADIENTS[hashes[5] & 15];
+    const int* g011 = PERLIN_GRADIENTS[hashes[6] & 15];
+    const int* g111 = PERLIN_GRADIENTS[hashes[7] & 15];
+
+    // Contribution of each corner, computed exactly like gradient() so the noise value matches generatePerlinNoise()
+    double n000 = g000[0]*xd + g000[1]*yd + g000[2]*zd;
+    double n100 = g100[0]*(xd-1) + g100[1]*yd + g100[2]*zd;
+    double n010 = g010[0]*xd + g010[1]*(yd-1) + g010[2]*zd;
+    double n110 = g110[0]*(xd-1) + g110[1]*(yd-1) + g110[2]*zd;
+    double n001 = g001[0]*xd + g001[1]*yd + g001[2]*(zd-1);
+    double n101 = g101[0]*(xd-1) + g101[1]*yd + g101[2]*(zd-1);
+    double n011 = g011[0]*xd + g011[1]*(yd-1) + g011[2]*(zd-1);
+    double n111 = g111[0]*(xd-1) + g111[1]*(yd-1) + g111[2]*(zd-1);
+
+    // Noise value, blended in the same order as generatePerlinNoise()
+    double y1 = lerp(lerp(n000,n100,u), lerp(n010,n110,u), v);
+    double y2 = lerp(lerp(n001,n101,u), lerp(n011,n111,u), v);
+    double value = (lerp(y1,y2,w)+1)/2;
+
+    // Coefficients of the trilinear blend written as a polynomial in the weights: k0 + k1 u + k2 v + k3 w + k4 uv + k5 vw + k6 wu + k7 uvw
+    double k1 = n100 - n000;
+    double k2 = n010 - n000;
+    double k3 = n001 - n000;
+    double k4 = n000 - n100 - n010 + n110;
+    double k5 = n000 - n010 - n001 + n011;
+    double k6 = n000 - n100 - n001 + n101;
+    double k7 = -n000 + n100 + n010 - n110 + n001 - n101 - n011 + n111;
+
+    // Each partial derivative = blend of that component of the gradient vectors + (derivative of the weight) * (how much the blend changes with that weight)
+    // Halved because the noise value is mapped from [-1,1] to [0,1]
+    double gx = lerp(lerp(lerp(g000[0],g100[0],u), lerp(g010[0],g110[0],u), v), lerp(lerp(g001[0],g101[0],u), lerp(g011[0],g111[0],u), v), w);
+    double gy = lerp(lerp(lerp(g000[1],g100[1],u), lerp(g010[1],g110[1],u), v), lerp(lerp(g001[1],g101[1],u), lerp(g011[1],g111[1],u), v), w);
+    double gz = lerp(lerp(lerp(g000[2],g100[2],u), lerp(g010[2],g110[2],u), v), lerp(lerp(g001[2],g101[2],u), lerp(g011[2],g111[2],u), v), w);
+    *dx = (gx + du*(k1 + k4*v + k6*w + k7*v*w))/2;
+    *dy = (gy + dv*(k2 + k5*w + k4*u + k7*w*u))/2;
+    *dz = (gz + dw*(k3 + k6*u + k5*v + k7*u*v))/2;
+
+    return value;
+}
+
+// Lattice index function
+// Maps the integer part of a coordinate (already floored) to the range [0,255] used to index the permutation table
+// The mod is done in floating point (exact for whole numbers) so huge and negative coordinates map correctly
+// Parameter: fl is the floored coordinate
+int Perlin::latticeIndex(double fl) {
+    return (int)(fl - 256.0*floor(fl/256.0));
+}
+
+// Next lattice index function
+// Permutation table index of the lattice point after fl along an axis, wrapped back to 0 at the end of a tile
+// The wrap is applied to the lattice coordinate itself, before it's reduced to [0,255] for hashing, so the noise is exactly periodic for any
+// period, including periods above 256 (wrapping the reduced index would join cell 255 to cell 0 in the middle of the tile)
+// For periods up to 256 this is the same as increment(latticeIndex(fl), repeat)
+// Parameters: fl is the floored coordinate, already wrapped into [0,repeat) when repeat > 0; repeat is as in generatePerlinNoise()
+int Perlin::nextLatticeIndex(double fl, int repeat) {
+    if (repeat > 0)
+        return increment((int)fl, repeat) & 255;
+    return latticeIndex(fl) + 1;
+}
+
+// Hash lattice index function
+// The integer hash's counterpart of latticeIndex(): the floored coordinate mod 2^32, so the lattice only wraps around after 2^32 cells
+// Parameter: fl is the floored coordinate
+unsigned int Perlin::hashLatticeIndex(double fl) {
+    return (unsigned int)(long long)(fl - 4294967296.0*floor(fl/4294967296.0));
+}
+
+// Next hash lattice index function
+// The integer hash's counterpart of nextLatticeIndex(), wrapped back to 0 at the end of a tile for any period
+// Parameters: fl is the floored coordinate, already wrapped into [0,repeat) when repeat > 0; repeat is as in generatePerlinNoise()
+unsigned int Perlin::nextHashLatticeIndex(double fl, int repeat) {
+    if (repeat > 0)
+        return (unsigned int)increment((int)fl, repeat);
+    return hashLatticeIndex(fl) + 1;
+}
+
+// Corner hash function
+// Hashes the 8 corners of the unit cube whose lowest corner is (xfl, yfl, zfl), in the order x0y0z0, x1y0z0, x0y1z0, x1y1z0, x0y0z1, x1y0z1,
+// x0y1z1, x1y1z1 (x varies fastest); the low bits of each hash select the corner's gradient vector
+// With the permutation table, each corner's 3 lattice indices are chained through p[]: e.g. for x0y0z0 = p[p[p[xi]+yi]+zi]
+// 1. We get int value at this index xi in p[]
+// 2. Add yi to the int value from step 1, and then get the int value at this new index in p[]
+// 3. Add zi to the int value from step 2, and then get the int value at this new index in p[]
+// With the integer hash, the seed and the 3 full lattice coordinates are mixed arithmetically (see PerlinTables.h)
+// Parameters: xfl, yfl and zfl are the floored coordinates, already wrapped when repeat > 0; repeat is as in generatePerlinNoise(); hashes receives the 8 hashes
+void Perlin::cornerHashes(double xfl, double yfl, double zfl, int repeat, int* hashes) {
+    if (latticeHash == INTEGER_HASH) {
+        unsigned int xs[2] = { hashLatticeIndex(xfl), nextHashLatticeIndex(xfl,repeat) };
+        unsigned int ys[2] = { hashLatticeIndex(yfl), nextHashLatticeIndex(yfl,repeat) };
+        unsigned int zs[2] = { hashLatticeIndex(zfl), nextHashLatticeIndex(zfl,repeat) };
+        unsigned int start = latticeHashStart(seed);
+        for (int c = 0; c < 8; c++)
+            hashes[c] = (int)(latticeHashFinal(latticeHashStep(latticeHashStep(latticeHashStep(start, xs[c & 1]), ys[(c >> 1) & 1]), zs[c >> 2])) & 255);
+        return;
+    }
+
+    // Map the lattice coordinates to the range [0,255] of the permutation table (see latticeIndex() and nextLatticeIndex())
+    int xi = latticeIndex(xfl);
+    int yi = latticeIndex(yfl);
+    int zi = latticeIndex(zfl);
+    int xi1 = nextLatticeIndex(xfl,repeat);
+    int yi1 = nextLatticeIndex(yfl,repeat);
+    int zi1 = nextLatticeIndex(zfl,repeat);
+
+    int a = p[xi], b = p[xi1];
+    int aa = p[a+yi], ab = p[a+yi1], ba = p[b+yi], bb = p[b+yi1];
+    hashes[0] = p[aa+zi];
+    hashes[1] = p[ba+zi];
+    hashes[2] = p[ab+zi];
+    hashes[3] = p[bb+zi];
+    hashes[4] = p[aa+zi1];
+    hashes[5] = p[ba+zi1];
+    hashes[6] = p[ab+zi1];
+    hashes[7] = p[bb+zi1];
+}
+
+// 2D corner hash function
+// Hashes the 4 corners of the unit square whose lowest corner is (xfl, yfl), in the order x0y0, x1y0, x0y1, x1y1
+// Each hash is the z = 0 hash of cornerHashes(), which keeps the 2D noise identical to the z = 0 plane of the 3D noise
+// Parameters: xfl and yfl are the floored coordinates, already wrapped when repeat > 0; repeat is as in generatePerlinNoise2D(); hashes receives the 4 hashes
+void Perlin::cornerHashes2D(double xfl, double yfl, int repeat, int* hashes) {
+    if (latticeHash == INTEGER_HASH) {
+        unsigned int xs[2] = { hashLatticeIndex(xfl), nextHashLatticeIndex(xfl,repeat) };
+        unsigned int ys[2] = { hashLatticeIndex(yfl), nextHashLatticeIndex(yfl,repeat) };
+        unsigned int start = latticeHashStart(seed);
+        for (int c = 0; c < 4; c++)
+            hashes[c] = (int)(latticeHashFinal(latticeHashStep(latticeHashStep(latticeHashStep(start, xs[c & 1]), ys[c >> 1]), 0)) & 255);
+        return;
+    }
+
+    int xi = latticeIndex(xfl);
+    int yi = latticeIndex(yfl);
+    int xi1 = nextLatticeIndex(xfl,repeat);
+    int yi1 = nextLatticeIndex(yfl,repeat);
+    int a = p[xi], b = p[xi1];
+    hashes[0] = p[p[a+yi]];
+    hashes[1] = p[p[b+yi]];
+    hashes[2] = p[p[a+yi1]];
+    hashes[3] = p[p[b+yi1]];
+}
+
+// Perlin noise row function
+// Evaluates a row of count points (x0 + i*dx, y, z), the way textures are baked, much faster than evaluating each point separately
+// Neighbouring points mostly fall in the same unit cube, so the work that only depends on the cube (hashing the 8 corners, looking up their
+// gradient vectors and the y/z parts of the gradient dot products) is done once per cube, and so is all the work that only depends on y and z
+// Each value is bit-identical to generatePerlinNoise(x0 + i*dx, y, z, repeat)
+// Parameters: y and z are shared by the whole row; x0 is the x coordinate of the first point and dx the spacing between points; out receives the count noise values; repeat is as in generatePerlinNoise()
+void Perlin::evaluateRow(double y, double z, double x0, double dx, int count, double* out, int repeat) {
+    if (repeat > 0) {
+        y = wrap(y,repeat);
+        z = wrap(z,repeat);
+    }
+
+    // Everything that depends on y and z only is computed once for the whole row
+    double yfl = floor(y);
+    double zfl = floor(z);
+    double yd = y-yfl;
+    double zd = z-zfl;
+    double yf = fade(yd);
+    double zf = fade(zd);
+
+    // Constants of the unit cube currently being filled, for each corner in the order x0y0z0, x1y0z0, x0y1z0, x1y1z0, x0y0z1, x1y0z1, x0y1z1, x1y1z1:
+    // the x component of its gradient vector, and the y and z terms of its gradient dot product
+    double gx[8], gy[8], gz[8];
+    double cellFloor = NAN;  // Floored x coordinate of the current cube (NAN until the first cube is set up)
+
+    // The row is processed in chunks: first the x position of every point is worked out, then each run of points that share a cube is blended
+    const int CHUNK = 256;
+    double xfl[CHUNK], xd[CHUNK];
+
+    for (int start = 0; start < count; start += CHUNK) {
+        int n = count - start < CHUNK ? count - start : CHUNK;
+
+        for (int i = 0; i < n; i++) {
+            double x = x0 + (start + i) * dx;
+            if (repeat > 0)
+                x = wrap(x,repeat);
+            xfl[i] = floor(x);
+            xd[i] = x - xfl[i];
+        }
+
+        int i = 0;
+        while (i < n) {
+            // Find the run of points [i,end) that lie in the same cube
+            int end = i + 1;
+            while (end < n && xfl[end] == xfl[i])
+                end++;
+
+            // Crossing into a new cube: hash its corners (same hash function as generatePerlinNoise()) and look up their gradient vectors
+            if (xfl[i] != cellFloor) {
+                cellFloor = xfl[i];
+                int hashes[8];
+                cornerHashes(cellFloor,yfl,zfl,repeat,hashes);
+
+                for (int c = 0; c < 8; c++) {
+                    const int* g = PERLIN_GRADIENTS[hashes[c] & 15];
+                    gx[c] = g[0];
+                    gy[c] = g[1] * ((c & 2) ? yd-1 : yd);
+                    gz[c] = g[2] * ((c & 4) ? zd-1 : zd);
+                }
+            }
+
+            // Blend the run. This loop is plain arithmetic with no lookups or branches, which the compiler can vectorize
+            // The dot products are summed in the same order as gradient() so the results match generatePerlinNoise() exactly
+            for (int k = i; k < end; k++) {
+                double xd0 = xd[k];
+                double xd1 = xd0-1;
+                double xf = fade(xd0);
+                double x1 = lerp((gx[0]*xd0 + gy[0]) + gz[0], (gx[1]*xd1 + gy[1]) + gz[1], xf);
+                double x2 = lerp((gx[2]*xd0 + gy[2]) + gz[2], (gx[3]*xd1 + gy[3]) + gz[3], xf);
+                double y1 = lerp(x1,x2,yf);
+                x1 = lerp((gx[4]*xd0 + gy[4]) + gz[4], (gx[5]*xd1 + gy[5]) + gz[5], xf);
+                x2 = lerp((gx[6]*xd0 + gy[6]) + gz[6], (gx[7]*xd1 + gy[7]) + gz[7], xf);
+                double y2 = lerp(x1,x2,yf);
+                out[start + k] = (lerp(y1,y2,zf)+1)/2;
+            }
+
+            i = end;
+        }
+    }
+}
+
+// Perlin noise multi-field row function
+// Evaluates several fields along the same row (see NoiseSource::evaluateRowFields()), e.g. four seeds of one field in the channels of an RGBA texture
+// When the fields only differ by integer offsets (seeds), every field's points sit at the same place inside their cubes, so the fractional
+// positions, fade weights and run boundaries are worked out once for all fields, and only the corner hashes and blending are done per field
+// (four fields are blended together by PerlinSIMD::blendFields4, one vector lane per field, straight into interleaved texels)
+// Each field is then the noise at (xyz * frequency + offset) with the offset added to the lattice cell rather than to the coordinate, which
+// matches evaluating the fields separately to within rounding. Fields at different frequencies are evaluated row by row with evaluateRow(),
+// since their points sit at different places in different cubes and leave nothing to share. That includes the noise volume's octave layers
+// (NOISE_LAYERS in main.cpp, at 4, 8, 16 and 32 cells across), so the shared path only runs for callers whose fields share a frequency; it's
+// checked against separate evaluation by NoiseValidator::checkFields()
+// Parameters: as in NoiseSource::evaluateRowFields()
+void Perlin::evaluateRowFields(double y, double z, double x0, double dx, int count, const NoiseField* fields, int fieldCount, double* out) {
+    const double frequency = fields[0].frequency;
+    const int repeat = fields[0].repeat;
+
+    // Integer lattice shift of each field relative to the first one, or fall back to one row per field if the fields don't line up
+    std::vector<double> shifts(fieldCount);
+    bool shared = true;
+    for (int f = 0; f < fieldCount; f++) {
+        shifts[f] = fields[f].offset - fields[0].offset;
+        if (fields[f].frequency != frequency || fields[f].repeat != repeat || shifts[f] != floor(shifts[f]))
+            shared = false;
+    }
+
+    if (!shared) {
+        std::vector<double> values(count);
+        for (int f = 0; f < fieldCount; f++) {
+            const NoiseField& field = fields[f];
+            evaluateRow(y * field.frequency + field.offset, z * field.frequency + field.offset, x0 * field.frequency + field.offset,
+                        dx * field.frequency, count, values.data(), field.repeat);
+            for (int i = 0; i < count; i++)
+                out[(size_t)i * fieldCount + f] = values[i];
+        }
+        return;
+    }
+
+    // The first field's coordinates, which all fields share apart from their lattice shift
+    y = y * frequency + fields[0].offset;
+    z = z * frequency + fields[0].offset;
+    x0 = x0 * frequency + fields[0].offset;
+    dx *= frequency;
+    if (repeat > 0) {
+        y = wrap(y,repeat);
+        z = wrap(z,repeat);
+    }
+
+    double yfl = floor(y);
+    double zfl = floor(z);
+    double yd = y-yfl;
+    double zd = z-zfl;
+    double yf = fade(yd);
+    double zf = fade(zd);
+
+    // Lattice cell of a field shifted by shift cells, wrapped back into the tile (whole numbers, so the shift is exact)
+    auto shiftCell = [&](double fl, double shift) { return repeat > 0 ? wrap(fl + shift, repeat) : fl + shift; };
+
+    // evaluateRow()'s cube constants for every field, laid out corner by corner with the fields of a corner next to each other (gx[c*fieldCount + f]),
+    // so the fields of one point are blended side by side and come out already interleaved
+    const int CHUNK = 256;
+    std::vector<double> gx(fieldCount * 8), gy(fieldCount * 8), gz(fieldCount * 8);
+    double cellFloor = NAN;
+    double xd[CHUNK], xf[CHUNK], xfl[CHUNK];
+    PerlinSIMD::Level level = PerlinSIMD::activeLevel();
+
+    for (int start = 0; start < count; start += CHUNK) {
+        int n = count - start < CHUNK ? count - start : CHUNK;
+
+        // Positions and fade weights, shared by every field
+        for (int i = 0; i < n; i++) {
+            double x = x0 + (start + i) * dx;
+            if (repeat > 0)
+                x = wrap(x,repeat);
+            xfl[i] = floor(x);
+            xd[i] = x - xfl[i];
+            xf[i] = fade(xd[i]);
+        }
+
+        int i = 0;
+        while (i < n) {
+            int end = i + 1;
+            while (end < n && xfl[end] == xfl[i])
+                end++;
+
+            // Crossing into a new cube, which is a new cube for every field at once
+            if (xfl[i] != cellFloor) {
+                cellFloor = xfl[i];
+                for (int f = 0; f < fieldCount; f++) {
+                    int hashes[8];
+                    cornerHashes(shiftCell(cellFloor,shifts[f]),shiftCell(yfl,shifts[f]),shiftCell(zfl,shifts[f]),repeat,hashes);
+                    for (int c = 0; c < 8; c++) {
+                        const int* g = PERLIN_GRADIENTS[hashes[c] & 15];
+                        gx[c*fieldCount + f] = g[0];
+                        gy[c*fieldCount + f] = g[1] * ((c & 2) ? yd-1 : yd);
+                        gz[c*fieldCount + f] = g[2] * ((c & 4) ? zd-1 : zd);
+                    }
+                }
+            }
+
+            // Blend the run, same arithmetic as evaluateRow(); four fields (an RGBA texel) fit a SIMD kernel's vector
+            double* runOut = out + (size_t)(start + i) * fieldCount;
+            if (fieldCount == 4) {
+                PerlinSIMD::blendFields4(level, xd + i, xf + i, gx.data(), gy.data(), gz.data(), yf, zf, runOut, end - i);
+            }
+            else {
+                for (int k = i; k < end; k++, runOut += fieldCount) {
+                    double xd0 = xd[k];
+                    double xd1 = xd0-1;
+                    for (int f = 0; f < fieldCount; f++) {
+                        double d[8];
+                        for (int c = 0; c < 8; c++)
+                            d[c] = (gx[c*fieldCount + f]*((c & 1) ? xd1 : xd0) + gy[c*fieldCount + f]) + gz[c*fieldCount + f];
+                        double y1 = lerp(lerp(d[0],d[1],xf[k]), lerp(d[2],d[3],xf[k]), yf);
+                        double y2 = lerp(lerp(d[4],d[5],xf[k]), lerp(d[6],d[7],xf[k]), yf);
+                        runOut[f] = (lerp(y1,y2,zf)+1)/2;
+                    }
+                }
+            }
+
+            i = end;
+        }
+    }
+}
+
+// 2D Perlin noise row function
+// The 2D counterpart of evaluateRow(): each value is bit-identical to generatePerlinNoise2D(x0 + i*dx, y, repeat)
+// Parameters: y is shared by the whole row; x0 is the x coordinate of the first point and dx the spacing between points; out receives the count noise values; repeat is as in generatePerlinNoise2D()
+void Perlin::evaluateRow2D(double y, double x0, double dx, int count, double* out, int repeat) {
+    if (repeat > 0)
+        y = wrap(y,repeat);
+
+    double yfl = floor(y);
+    double yd = y-yfl;
+    double yf = fade(yd);
+
+    // Constants of the unit square currently being filled, for each corner in the order x0y0, x1y0, x0y1, x1y1
+    double gx[4], gy[4];
+    double cellFloor = NAN;
+
+    const int CHUNK = 256;
+    double xfl[CHUNK], xd[CHUNK];
+
+    for (int start = 0; start < count; start += CHUNK) {
+        int n = count - start < CHUNK ? count - start : CHUNK;
+
+        for (int i = 0; i < n; i++) {
+            double x = x0 + (start + i) * dx;
+            if (repeat > 0)
+                x = wrap(x,repeat);
+            xfl[i] = floor(x);
+            xd[i] = x - xfl[i];
+        }
+
+        int i = 0;
+        while (i < n) {
+            int end = i + 1;
+            while (end < n && xfl[end] == xfl[i])
+                end++;
+
+            // Same corner hashes as generatePerlinNoise2D()
+            if (xfl[i] != cellFloor) {
+                cellFloor = xfl[i];
+                int hashes[4];
+                cornerHashes2D(cellFloor,yfl,repeat,hashes);
+
+                for (int c = 0; c < 4; c++) {
+                    const int* g = PERLIN_GRADIENTS[hashes[c] & 15];
+                    gx[c] = g[0];
+                    gy[c] = g[1] * ((c & 2) ? yd-1 : yd);
+                }
+            }
+
+            for (int k = i; k < end; k++) {
+                double xd0 = xd[k];
+                double xd1 = xd0-1;
+                double xf = fade(xd0);
+                double x1 = lerp(gx[0]*xd0 + gy[0], gx[1]*xd1 + gy[1], xf);
+                double x2 = lerp(gx[2]*xd0 + gy[2], gx[3]*xd1 + gy[3], xf);
+                out[start + k] = (lerp(x1,x2,yf)+1)/2;
+            }
+
+            i = end;
+        }
+    }
+}
+
+// FIXED-POINT ROWS
+// evaluateRow8() and evaluateRow16() compute the same rows as evaluateRow(), but in integer arithmetic from start to finish, writing texels directly
+// Positions inside a unit cube, fade weights and gradient dot products are all fixed-point numbers (an integer with a # of fractional bits,
+// written Qn for n fractional bits), so the 8-bit path fits every value into a 16-bit SIMD lane: 8 points per SSE vector and 16 per AVX2 vector
+//
+// 8-bit number formats: decimal part of x and fade weights in Q15; gradient dot products and the blended noise value in Q12 (values in [-2,2]
+// fit in 16 bits, and so do differences between them); the fade polynomial is evaluated with Q11 intermediates (see PerlinSIMD.cpp)
+// 16-bit number formats: everything in Q24 in 32-bit integers, with the products in 64-bit
+//
+// Error bound against the double reference (int)(generatePerlinNoise(x, y, z, repeat) * 255), or * 65535 for 16-bit texels:
+// the fixed-point noise value is well within one output step of the exact value (Q15 truncation of the position, Q11 fade weights and one
+// rounding per interpolation for 8 bits; Q24 throughout for 16 bits), so without dithering a texel is at most 1 away from the reference,
+// and equal to it wherever the exact value isn't that close to a rounding boundary: about 96% of 8-bit texels and 99.8% of 16-bit texels
+// With dithering, a texel is floor(value * 255 + threshold) for an ordered 4x4 threshold in (0,1), so it's at most 1 away from the undithered
+// texel (and 2 from the reference), and a 4x4 block averages out to the exact value instead of banding
+
+// Number of points positioned at a time
+const int FIXED_CHUNK = 256;
+
+// 4x4 ordered (Bayer) dither matrix, for dither thresholds of (value + 0.5) / 16 of an 8-bit step
+const int BAYER_4X4[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+
+// Converts a weight or offset in [0,1] to fixed point with the given # of fractional bits, capped just below 1
+static int toFixed(double val, int bits) {
+    int one = 1 << bits;
+    int fixed = (int)(val * one);
+    return fixed < one ? fixed : one - 1;
+}
+
+// Fixed-point row traversal shared by evaluateRow8() and evaluateRow16(), the integer counterpart of the per-cube work in evaluateRow()
+// Splits the row of count points (x0 + i*dx, y, z) into runs of points sharing a unit cube, and calls
+// blend(first, t, n, gx, k, corners) for each run: first is the index of the run's first point and n its # of points, t holds each point's
+// decimal x part (with tBits fractional bits), and gx and k hold, for each corner of the cube in the same order as evaluateRow(), the x component
+// of the corner's gradient vector and the y and z terms of its gradient dot product (with kBits fractional bits)
+// corners is 8, or 4 when z lies exactly on a lattice plane so that the far face of every cube has a weight of 0
+template <typename Fixed, typename Blend>
+void Perlin::forEachFixedRun(double y, double z, double x0, double dx, int count, int repeat, int tBits, int kBits, Blend blend) {
+    if (repeat > 0) {
+        y = wrap(y,repeat);
+        z = wrap(z,repeat);
+    }
+
+    double yfl = floor(y);
+    double zfl = floor(z);
+    const int one = 1 << kBits;
+    int yq = toFixed(y-yfl, kBits);
+    int zq = toFixed(z-zfl, kBits);
+    const int corners = zq == 0 ? 4 : 8;
+
+    Fixed t[FIXED_CHUNK], gx[8], k[8];
+    long long cell[FIXED_CHUNK];
+    const double Q32 = 4294967296.0;
+
+    for (int start = 0; start < count; start += FIXED_CHUNK) {
+        int n = count - start < FIXED_CHUNK ? count - start : FIXED_CHUNK;
+
+        // x positions are stepped in Q32 integers, so the cube and decimal part of each point are a shift and a mask rather than a floor() call,
+        // which would otherwise cost more than all the fixed-point blending. Rows reaching beyond +-2^30 don't fit and fall back to doubles
+        const double first = x0 + start * dx, last = x0 + (start + n) * dx;
+        if (fabs(first) < 1073741824.0 && fabs(last) < 1073741824.0) {
+            const long long base = llround(first * Q32), step = llround(dx * Q32);
+            const long long period = (long long)repeat << 32;
+            for (int i = 0; i < n; i++) {
+                long long pos = base + i * step;
+                if (repeat > 0 && (pos < 0 || pos >= period))
+                    pos = (pos % period + period) % period;
+                cell[i] = pos >> 32;
+                t[i] = (Fixed)((pos >> (32 - tBits)) & ((1 << tBits) - 1));
+            }
+        }
+        else {
+            for (int i = 0; i < n; i++) {
+                double x = x0 + (start + i) * dx;
+                if (repeat > 0)
+                    x = wrap(x,repeat);
+                double xfl = floor(x);
+                cell[i] = (long long)xfl;
+                t[i] = (Fixed)toFixed(x - xfl, tBits);
+            }
+        }
+
+        int i = 0;
+        while (i < n) {
+            int end = i + 1;
+            while (end < n && cell[end] == cell[i])
+                end++;
+
+            // Same corner hashes as generatePerlinNoise()
+            int hashes[8];
+            cornerHashes((double)cell[i],yfl,zfl,repeat,hashes);
+
+            for (int c = 0; c < corners; c++) {
+                const int* g = PERLIN_GRADIENTS[hashes[c] & 15];
+                gx[c] = (Fixed)g[0];
+                k[c] = (Fixed)(g[1] * ((c & 2) ? yq-one : yq) + g[2] * ((c & 4) ? zq-one : zq));
+            }
+
+            blend(start + i, t + i, end - i, gx, k, corners);
+            i = end;
+        }
+    }
+}
+
+// Fixed-point row function for 8-bit texels
+// Evaluates the row of count points (x0 + i*dx, y, z) like evaluateRow(), but in 16-bit integer arithmetic on the widest SIMD level available,
+// writing each texel (noise value * 255) straight into out. See the error bound above
+// Parameters: y, z, x0, dx, count and repeat are as in evaluateRow(); out receives the texels, stride bytes apart (e.g. 4 to fill one channel of
+// RGBA texels); ditherRow is the texture row # for ordered dithering (only its low 2 bits matter), or NO_DITHER
+void Perlin::evaluateRow8(double y, double z, double x0, double dx, int count, unsigned char* out, int stride, int repeat, int ditherRow) {
+    double yw = repeat > 0 ? wrap(y,repeat) : y;
+    double zw = repeat > 0 ? wrap(z,repeat) : z;
+    const int fy = toFixed(fade(yw - floor(yw)), 15);
+    const int fz = toFixed(fade(zw - floor(zw)), 15);
+    const PerlinSIMD::Level level = PerlinSIMD::activeLevel();
+
+    // The dither thresholds repeat every 4 texels, so a run starting at texel i reads them from (i & 3) on
+    unsigned short dither[FIXED_CHUNK + 4];
+    for (int i = 0; i < FIXED_CHUNK + 4; i++)
+        dither[i] = ditherRow != NO_DITHER ? (unsigned short)(BAYER_4X4[ditherRow & 3][i & 3] * 16 + 8) : 0;
+
+    unsigned char texels[FIXED_CHUNK];
+    forEachFixedRun<short>(y, z, x0, dx, count, repeat, 15, 12, [&](int first, const short* t, int n, const short* gx, const short* k, int corners) {
+        unsigned char* dest = stride == 1 ? out + first : texels;
+        PerlinSIMD::fixedPointRow8(level, t, gx, k, corners, fy, fz, ditherRow != NO_DITHER ? dither + (first & 3) : nullptr, dest, n);
+        if (stride != 1) {
+            for (int i = 0; i < n; i++)
+                out[(size_t)(first + i) * stride] = texels[i];
+        }
+    });
+}
+
+// Fixed-point row function for 16-bit texels
+// Same as evaluateRow8() with 16-bit texels (noise value * 65535) and without dithering, which 16-bit texels don't need
+// This path needs wider lanes, so it's written as a plain integer loop for the compiler to vectorize rather than with intrinsics
+void Perlin::evaluateRow16(double y, double z, double x0, double dx, int count, unsigned short* out, int stride, int repeat) {
+    double yw = repeat > 0 ? wrap(y,repeat) : y;
+    double zw = repeat > 0 ? wrap(z,repeat) : z;
+    const long long fy = toFixed(fade(yw - floor(yw)), 24);
+    const long long fz = toFixed(fade(zw - floor(zw)), 24);
+    const long long one = 1 << 24, half = 1 << 23;
+
+    forEachFixedRun<int>(y, z, x0, dx, count, repeat, 24, 24, [&](int first, const int* t, int n, const int* gx, const int* k, int corners) {
+        for (int i = 0; i < n; i++) {
+            // Fade weight in Q24: t^3 * (6t^2 - 15t + 10)
+            long long ti = t[i];
+            long long t2 = (ti * ti + half) >> 24;
+            long long t3 = (t2 * ti + half) >> 24;
+            long long xf = (t3 * (10*one - 15*ti + 6*t2) + half) >> 24;
+
+            long long xd = ti, xd1 = ti - one;
+            long long d[8];
+            for (int c = 0; c < corners; c++)
+                d[c] = gx[c] * ((c & 1) ? xd1 : xd) + k[c];
+
+            long long x1 = d[0] + (((d[1] - d[0]) * xf + half) >> 24);
+            long long x2 = d[2] + (((d[3] - d[2]) * xf + half) >> 24);
+            long long v = x1 + (((x2 - x1) * fy + half) >> 24);
+            if (corners == 8) {
+                x1 = d[4] + (((d[5] - d[4]) * xf + half) >> 24);
+                x2 = d[6] + (((d[7] - d[6]) * xf + half) >> 24);
+                long long y2 = x1 + (((x2 - x1) * fy + half) >> 24);
+                v = v + (((y2 - v) * fz + half) >> 24);
+            }
+
+            // Map from [-1,1] in Q24 to [0,65535]
+            v = v < -one ? -one : (v > one-1 ? one-1 : v);
+            out[(size_t)(first + i) * stride] = (unsigned short)(((v + one) * 65535) >> 25);
+        }
+    });
+}
+
+// 4D Perlin noise function
+// The 4D extension of generatePerlinNoise(), e.g. for noise that evolves over time with w as the time axis
+// The point lies in a unit hypercube with 16 corners, each of which gets one of 32 gradient vectors (PERLIN_GRADIENTS_4D) through the same kind of permutation table hash
+// Parameters: xyzw are coordinates of point in 4D space; repeat tiles the x, y and z axes as in generatePerlinNoise(), while w (time) never wraps
+double Perlin::generatePerlinNoise4D(double x, double y, double z, double w, int repeat) {
+    if (repeat > 0) {
+        x = wrap(x, repeat);
+        y = wrap(y, repeat);
+        z = wrap(z, repeat);
+    }
+
+    // Unit hypercube containing the point and the point's position inside it
+    double fl[4] = { floor(x), floor(y), floor(z), floor(w) };
+    double d[4] = { x-fl[0], y-fl[1], z-fl[2], w-fl[3] };
+
+    // Lattice indices of the near and far side of the hypercube along each axis, for the permutation table or the integer hash
+    // The w axis isn't wrapped, so animated noise never loops
+    const bool hashed = latticeHash == INTEGER_HASH;
+    unsigned int i0[4], i1[4];
+    for (int a = 0; a < 4; a++) {
+        i0[a] = hashed ? hashLatticeIndex(fl[a]) : (unsigned int)latticeIndex(fl[a]);
+        if (a == 3)
+            i1[a] = i0[a] + 1;
+        else
+            i1[a] = hashed ? nextHashLatticeIndex(fl[a], repeat) : (unsigned int)nextLatticeIndex(fl[a], repeat);
+    }
+
+    // Contribution of each of the 16 corners; bit 0 of the corner # selects the far x side, bit 1 the far y side and so on
+    double n[16];
+    for (int c = 0; c < 16; c++) {
+        unsigned int xi = (c & 1) ? i1[0] : i0[0];
+        unsigned int yi = (c & 2) ? i1[1] : i0[1];
+        unsigned int zi = (c & 4) ? i1[2] : i0[2];
+        unsigned int wi = (c & 8) ? i1[3] : i0[3];
+        unsigned int hash = hashed ? latticeHashFinal(latticeHashStep(latticeHashStep(latticeHashStep(latticeHashStep(latticeHashStart(seed), xi), yi), zi), wi))
+                                   : (unsigned int)p[p[p[p[xi]+yi]+zi]+wi];
+        const int* g = PERLIN_GRADIENTS_4D[hash & 31];
+        n[c] = g[0]*((c & 1) ? d[0]-1 : d[0]) + g[1]*((c & 2) ? d[1]-1 : d[1]) + g[2]*((c & 4) ? d[2]-1 : d[2]) + g[3]*((c & 8) ? d[3]-1 : d[3]);
+    }
+
+    // Blend the corners along x, then y, then z, then w, halving the # of values each time
+    int size = 16;
+    for (int a = 0; a < 4; a++) {
+        double f = fade(d[a]);
+        size /= 2;
+        for (int c = 0; c < size; c++)
+            n[c] = lerp(n[2*c], n[2*c+1], f);
+    }
+
+    // Final noise value, mapped to range [0,1]
+    // 4D Perlin noise reaches about +-1.19 rather than +-1, so it's scaled by 0.8 first to keep it inside the range
+    return (0.8*n[0]+1)/2;
+}
+
 // Perlin Octaves function - NOTE: this is not used finally, as we calculate the Perlin turbulence in the fragment shader instead
-// Used to produce a more complex/detailed noise pattern by generating layers of Perlin noise at different frequencies and amplitudes, and then combining them
+// Same as NoiseSource::generateOctaves() with Perlin noise, kept for existing callers
 // Parameters: xyz are point coordinates in 3D space; octaves denotes the # of octaves to use in generating the noise; persistence denotes the degree by which the amplitude changes between octaves
 double Perlin::generatePerlinOctaves(double x, double y, double z, int octaves, double persistence) {
-    double total = 0.0;      // Used to store the accumulated noise values
-    double frequency = 1.0;  // Used to adjust the frequency of each noise octave. Frequency determines how quickly the noise values change with respect to changes in input coordinates. Higher frequency = finer-grained/more detail, lower frequency = coarser/more general
-    double amplitude = 1.0;  // Used to adjust the amplitude of each noise octave. Amplitude determines the degree of variation between the highest and lowest noise values. Higher amplitude = more variation in noise, lower amplitude = smoother noise pattern
-    double max = 0.0;        // Used for normalizing the total
-    
-    // Iterate over each noise octave to accumulate the noise values
-    for (int i = 0; i < octaves; i++) {
-        total += generatePerlinNoise(x * frequency, y * frequency, z * frequency, 0) * amplitude; // Adds noise value for the current octave to the total
-        max += amplitude;                                                                         // Used for normalizing the result once loop exits
-        amplitude *= persistence;                                                                 // Reduces amplitude to decrease the contribution of each subsequent octave to the final noise value
-        frequency *= 2;                                                                           // Increases the frequency of each subsequent octave to make the noise more fine-grained
-    }
-    
-    return total/max;     // Normalize total, resulting in a noise value in range [0,1]
-}
\ No newline at end of file
+    return generateOctaves(x, y, z, octaves, persistence);
+}
@@ -2,24 +2,77 @@
 #define PERLIN_H
 #include <cmath>
 #include <vector>
+#include "PerlinTables.h"
+#include "NoiseSource.h"
 
 // A class for generating Perlin noise
-class Perlin {
+class Perlin : public NoiseSource {
     public:
+        // How lattice points are hashed to pick their gradient vectors
+        // PERMUTATION_TABLE: Ken Perlin's 256-entry table, so the noise repeats every 256 cells and there's a single noise field
+        // INTEGER_HASH: an integer hash of the full lattice coordinates and a seed (see PerlinTables.h), so the noise doesn't repeat for 2^32 cells
+        // and each seed gives a different field. Same gradient vectors and output range as the table
+        enum LatticeHash { PERMUTATION_TABLE, INTEGER_HASH };
+
         // Constructor
+        // Uses the permutation table until setLatticeHash() says otherwise
         Perlin();
 
         // Methods
+        void setLatticeHash(LatticeHash mode, unsigned int hashSeed);
+        LatticeHash getLatticeHash() { return latticeHash; }
+        unsigned int getSeed() { return seed; }
         double fade(double t);
+        double fadeDerivative(double t);
         int increment(int val, int repeat);
         double gradient(int hash, double x, double y, double z);
+        double gradient2D(int hash, double x, double y);
         double lerp(double a, double b, double x);
+        double wrap(double val, int repeat);
         double generatePerlinNoise(double x, double y, double z, int repeat);
+        double generatePerlinNoiseD(double x, double y, double z, int repeat, double* dx, double* dy, double* dz);
+        void generatePerlinNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat);
+        double generatePerlinNoise2D(double x, double y, int repeat);
+        void generatePerlinNoise2DBatch(const double* x, const double* y, double* out, int count, int repeat);
+        void evaluateRow(double y, double z, double x0, double dx, int count, double* out, int repeat);
+        void evaluateRow2D(double y, double x0, double dx, int count, double* out, int repeat) override;
+        double thirdDerivativeBound2D() override { return THIRD_DERIVATIVE_BOUND_2D; }
+        void evaluateRowFields(double y, double z, double x0, double dx, int count, const NoiseField* fields, int fieldCount, double* out) override;
+        void evaluateRow8(double y, double z, double x0, double dx, int count, unsigned char* out, int stride, int repeat, int ditherRow);
+        void evaluateRow16(double y, double z, double x0, double dx, int count, unsigned short* out, int stride, int repeat);
+        double generatePerlinNoise4D(double x, double y, double z, double w, int repeat);
         double generatePerlinOctaves(double x, double y, double z, int octaves, double persistence);
 
+        // ditherRow value for evaluateRow8() that turns dithering off
+        static constexpr int NO_DITHER = -1;
+
+        // Bound on the third derivative along x or y of the noise on the z = 0 plane, on the [0,1] scale
+        // Along x the noise is A + fade(u) * D for functions A and D that are linear in u, so its third derivative is fade3(u) * D + 3 * fade2(u) * D'
+        // (fade2 and fade3 being the second and third derivatives of the fade curve). Over every pair of the 16 gradients, blended by the y fade
+        // weights, this peaks at the cell borders, where |fade3| is 60 and |D| reaches 2 halfway across the cell in y (about 59 is measured)
+        static constexpr double THIRD_DERIVATIVE_BOUND_2D = 60.0;
+
+        // NoiseSource interface
+        const char* name() override { return "Perlin"; }
+        double generateNoise(double x, double y, double z, int repeat) override { return generatePerlinNoise(x, y, z, repeat); }
+        double generateNoise4D(double x, double y, double z, double w, int repeat) override { return generatePerlinNoise4D(x, y, z, w, repeat); }
+        double generateNoiseD(double x, double y, double z, int repeat, double* dx, double* dy, double* dz) override { return generatePerlinNoiseD(x, y, z, repeat, dx, dy, dz); }
+        void generateNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat) override { generatePerlinNoiseBatch(x, y, z, out, count, repeat); }
+
     private:
+        // Helper methods
+        int latticeIndex(double fl);
+        int nextLatticeIndex(double fl, int repeat);
+        unsigned int hashLatticeIndex(double fl);
+        unsigned int nextHashLatticeIndex(double fl, int repeat);
+        void cornerHashes(double xfl, double yfl, double zfl, int repeat, int* hashes);
+        void cornerHashes2D(double xfl, double yfl, int repeat, int* hashes);
+        template <typename Fixed, typename Blend>
+        void forEachFixedRun(double y, double z, double x0, double dx, int count, int repeat, int tBits, int kBits, Blend blend);
+
         // Instance variables
-        int permutation[256];
-        int p[512];
+        const int* p;              // Doubled permutation table (points at PERLIN_PERMUTATION)
+        LatticeHash latticeHash;   // How lattice points are hashed
+        unsigned int seed;         // Seed of the integer hash
 };
 #endif
\ No newline at end of file
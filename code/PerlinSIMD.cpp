@@ -0,0 +1,1067 @@
+#include "PerlinSIMD.h"
+#include "PerlinTables.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PERLIN_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need each kernel to be marked with the instruction set it uses, MSVC allows any intrinsic anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define PERLIN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PERLIN_TARGET(isa)
+#endif
+
+namespace PerlinSIMD {
+
+// Level chosen by forceLevel(), or -1 to use the detected level
+static int forcedLevel = -1;
+
+// Detects the widest instruction set the CPU and OS both support
+Level detectLevel() {
+    static const Level detected = []() {
+#if defined(PERLIN_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+        // __builtin_cpu_supports also checks that the OS saves the wider registers on context switches
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return AVX2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return SSE42;
+#elif defined(PERLIN_SIMD_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool sse42 = (info[2] & (1 << 20)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        __cpuidex(info, 7, 0);
+        if ((xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)))
+            return AVX512;
+        if ((xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)))
+            return AVX2;
+        if (sse42)
+            return SSE42;
+#endif
+        return SCALAR;
+    }();
+    return detected;
+}
+
+Level activeLevel() {
+    return forcedLevel < 0 ? detectLevel() : (Level)forcedLevel;
+}
+
+void forceLevel(Level level) {
+    forcedLevel = level < detectLevel() ? level : detectLevel();
+}
+
+int laneWidth(Level level) {
+    switch (level) {
+        case SSE42: return 2;
+        case AVX2: return 4;
+        case AVX512: return 8;
+        default: return 1;
+    }
+}
+
+const char* levelName(Level level) {
+    switch (level) {
+        case SSE42: return "SSE4.2";
+        case AVX2: return "AVX2";
+        case AVX512: return "AVX-512";
+        default: return "scalar";
+    }
+}
+
+#ifdef PERLIN_SIMD_X86
+
+// SSE4.2 KERNEL - 2 points per iteration
+// SSE has no gather instruction, so the permutation table lookups are done one lane at a time
+
+// Branchless version of Perlin::gradient: u is x for hashes 0-7 and y otherwise, v is y for hashes 0-3, x for 12 and 14 and z otherwise,
+// bit 0 of the hash negates u and bit 1 negates v (negating by flipping the sign bit gives the same result as the unary minus)
+PERLIN_TARGET("sse4.2")
+static inline __m128d gradientSSE(__m128i h, __m128d x, __m128d y, __m128d z) {
+    h = _mm_and_si128(h, _mm_set1_epi64x(15));
+    __m128d lt8 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(8), h));
+    __m128d lt4 = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(4), h));
+    __m128d xv = _mm_castsi128_pd(_mm_or_si128(_mm_cmpeq_epi64(h, _mm_set1_epi64x(12)), _mm_cmpeq_epi64(h, _mm_set1_epi64x(14))));
+    __m128d u = _mm_blendv_pd(y, x, lt8);
+    __m128d v = _mm_blendv_pd(_mm_blendv_pd(z, x, xv), y, lt4);
+    u = _mm_xor_pd(u, _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(1)), 63)));
+    v = _mm_xor_pd(v, _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(2)), 62)));
+    return _mm_add_pd(u, v);
+}
+
+PERLIN_TARGET("sse4.2")
+static inline __m128d lerpSSE(__m128d a, __m128d b, __m128d t) {
+    return _mm_add_pd(a, _mm_mul_pd(t, _mm_sub_pd(b, a)));
+}
+
+// 6t^5 - 15t^4 + 10t^3, multiplied out left to right exactly like Perlin::fade
+PERLIN_TARGET("sse4.2")
+static inline __m128d fadeSSE(__m128d t) {
+    __m128d a = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(6), t), t), t), t), t);
+    __m128d b = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(15), t), t), t), t);
+    __m128d c = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(10), t), t), t);
+    return _mm_add_pd(_mm_sub_pd(a, b), c);
+}
+
+// Splits a coordinate into its permutation table index (floor mod 256) and its decimal part
+PERLIN_TARGET("sse4.2")
+static inline void latticeSSE(__m128d v, int* i, __m128d* d) {
+    __m128d fl = _mm_floor_pd(v);
+    __m128d wrapped = _mm_sub_pd(fl, _mm_mul_pd(_mm_set1_pd(256.0), _mm_floor_pd(_mm_mul_pd(fl, _mm_set1_pd(1.0 / 256.0)))));
+    _mm_storel_epi64((__m128i*)i, _mm_cvttpd_epi32(wrapped));
+    *d = _mm_sub_pd(v, fl);
+}
+
+PERLIN_TARGET("sse4.2")
+static void kernelSSE42(const int* p, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    const __m128d one = _mm_set1_pd(1.0);
+    for (int n = 0; n < count; n += 2) {
+        int xi[2], yi[2], zi[2];
+        __m128d xd, yd, zd;
+        latticeSSE(_mm_loadu_pd(x + n), xi, &xd);
+        latticeSSE(_mm_loadu_pd(y + n), yi, &yd);
+        latticeSSE(_mm_loadu_pd(z + n), zi, &zd);
+
+        // Hash the 8 corners of each lane's cube, the same way Perlin::generatePerlinNoise does
+        long long h[8][2];
+        for (int l = 0; l < 2; l++) {
+            int xi1 = xi[l] + 1, yi1 = yi[l] + 1, zi1 = zi[l] + 1;
+            if (repeat > 0) {
+                xi1 %= repeat;
+                yi1 %= repeat;
+                zi1 %= repeat;
+            }
+            int a = p[xi[l]], b = p[xi1];
+            int aa = p[a + yi[l]], ab = p[a + yi1], ba = p[b + yi[l]], bb = p[b + yi1];
+            h[0][l] = p[aa + zi[l]]; h[1][l] = p[ba + zi[l]];
+            h[2][l] = p[ab + zi[l]]; h[3][l] = p[bb + zi[l]];
+            h[4][l] = p[aa + zi1];   h[5][l] = p[ba + zi1];
+            h[6][l] = p[ab + zi1];   h[7][l] = p[bb + zi1];
+        }
+        __m128i hv[8];
+        for (int c = 0; c < 8; c++)
+            hv[c] = _mm_loadu_si128((const __m128i*)h[c]);
+
+        __m128d xf = fadeSSE(xd), yf = fadeSSE(yd), zf = fadeSSE(zd);
+        __m128d xd1 = _mm_sub_pd(xd, one), yd1 = _mm_sub_pd(yd, one), zd1 = _mm_sub_pd(zd, one);
+
+        __m128d x1 = lerpSSE(gradientSSE(hv[0], xd, yd, zd), gradientSSE(hv[1], xd1, yd, zd), xf);
+        __m128d x2 = lerpSSE(gradientSSE(hv[2], xd, yd1, zd), gradientSSE(hv[3], xd1, yd1, zd), xf);
+        __m128d y1 = lerpSSE(x1, x2, yf);
+        x1 = lerpSSE(gradientSSE(hv[4], xd, yd, zd1), gradientSSE(hv[5], xd1, yd, zd1), xf);
+        x2 = lerpSSE(gradientSSE(hv[6], xd, yd1, zd1), gradientSSE(hv[7], xd1, yd1, zd1), xf);
+        __m128d y2 = lerpSSE(x1, x2, yf);
+        _mm_storeu_pd(out + n, _mm_mul_pd(_mm_add_pd(lerpSSE(y1, y2, zf), one), _mm_set1_pd(0.5)));
+    }
+}
+
+// 2D version of kernelSSE42, see Perlin::generatePerlinNoise2D
+// The 3D gradient is reused with z = 0, which gives the same values as Perlin::gradient2D
+PERLIN_TARGET("sse4.2")
+static void kernel2DSSE42(const int* p, const double* x, const double* y, double* out, int count, int repeat) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+    for (int n = 0; n < count; n += 2) {
+        int xi[2], yi[2];
+        __m128d xd, yd;
+        latticeSSE(_mm_loadu_pd(x + n), xi, &xd);
+        latticeSSE(_mm_loadu_pd(y + n), yi, &yd);
+
+        long long h[4][2];
+        for (int l = 0; l < 2; l++) {
+            int xi1 = xi[l] + 1, yi1 = yi[l] + 1;
+            if (repeat > 0) {
+                xi1 %= repeat;
+                yi1 %= repeat;
+            }
+            int a = p[xi[l]], b = p[xi1];
+            h[0][l] = p[p[a + yi[l]]]; h[1][l] = p[p[b + yi[l]]];
+            h[2][l] = p[p[a + yi1]];   h[3][l] = p[p[b + yi1]];
+        }
+
+        __m128d xf = fadeSSE(xd), yf = fadeSSE(yd);
+        __m128d xd1 = _mm_sub_pd(xd, one), yd1 = _mm_sub_pd(yd, one);
+
+        __m128d x1 = lerpSSE(gradientSSE(_mm_loadu_si128((const __m128i*)h[0]), xd, yd, zero), gradientSSE(_mm_loadu_si128((const __m128i*)h[1]), xd1, yd, zero), xf);
+        __m128d x2 = lerpSSE(gradientSSE(_mm_loadu_si128((const __m128i*)h[2]), xd, yd1, zero), gradientSSE(_mm_loadu_si128((const __m128i*)h[3]), xd1, yd1, zero), xf);
+        _mm_storeu_pd(out + n, _mm_mul_pd(_mm_add_pd(lerpSSE(x1, x2, yf), one), _mm_set1_pd(0.5)));
+    }
+}
+
+// HASHED KERNELS - the integer lattice hash instead of the permutation table (see Perlin::setLatticeHash)
+// The lattice coordinates are the floored coordinates mod 2^32 and the hash is pure integer arithmetic, so no lookups are needed at all
+
+// Splits a coordinate into its hash lattice coordinate (floor mod 2^32, like Perlin::hashLatticeIndex) and its decimal part
+// cvttpd only converts to signed ints, so the coordinate is shifted down by 2^31 and the sign bit flipped back afterwards
+PERLIN_TARGET("sse4.2")
+static inline __m128i hashLatticeSSE(__m128d v, __m128d* d) {
+    __m128d fl = _mm_floor_pd(v);
+    __m128d wrapped = _mm_sub_pd(fl, _mm_mul_pd(_mm_set1_pd(4294967296.0), _mm_floor_pd(_mm_mul_pd(fl, _mm_set1_pd(1.0 / 4294967296.0)))));
+    *d = _mm_sub_pd(v, fl);
+    return _mm_xor_si128(_mm_cvttpd_epi32(_mm_sub_pd(wrapped, _mm_set1_pd(2147483648.0))), _mm_set1_epi32((int)0x80000000u));
+}
+
+// Adds 1 to each lattice coordinate, wrapping it back to 0 when it reaches repeat (like Perlin::nextHashLatticeIndex)
+PERLIN_TARGET("sse4.2")
+static inline __m128i incrementSSE(__m128i i, int repeat) {
+    i = _mm_add_epi32(i, _mm_set1_epi32(1));
+    if (repeat > 0)
+        i = _mm_andnot_si128(_mm_cmpeq_epi32(i, _mm_set1_epi32(repeat)), i);
+    return i;
+}
+
+// latticeHashStep and latticeHashFinal of PerlinTables.h on 4 x int32 lanes, also used by the AVX2 kernels
+PERLIN_TARGET("sse4.2")
+static inline __m128i hashStepSSE(__m128i h, __m128i coordinate) {
+    h = _mm_add_epi32(h, _mm_mullo_epi32(coordinate, _mm_set1_epi32((int)LATTICE_HASH_PRIME3)));
+    return _mm_mullo_epi32(_mm_or_si128(_mm_slli_epi32(h, 17), _mm_srli_epi32(h, 15)), _mm_set1_epi32((int)LATTICE_HASH_PRIME4));
+}
+
+PERLIN_TARGET("sse4.2")
+static inline __m128i hashFinalSSE(__m128i h) {
+    h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_srli_epi32(h, 15)), _mm_set1_epi32((int)LATTICE_HASH_PRIME2));
+    h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_srli_epi32(h, 13)), _mm_set1_epi32((int)LATTICE_HASH_PRIME3));
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+}
+
+// Final hash of a corner, widened to the 64-bit lanes gradientSSE() works on
+PERLIN_TARGET("sse4.2")
+static inline __m128i cornerHashSSE(__m128i h, __m128i coordinate) {
+    return _mm_cvtepu32_epi64(hashFinalSSE(hashStepSSE(h, coordinate)));
+}
+
+PERLIN_TARGET("sse4.2")
+static void hashedKernelSSE42(unsigned int seed, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128i start = _mm_set1_epi32((int)latticeHashStart(seed));
+    for (int n = 0; n < count; n += 2) {
+        __m128d xd, yd, zd;
+        __m128i xi = hashLatticeSSE(_mm_loadu_pd(x + n), &xd);
+        __m128i yi = hashLatticeSSE(_mm_loadu_pd(y + n), &yd);
+        __m128i zi = hashLatticeSSE(_mm_loadu_pd(z + n), &zd);
+        __m128i xi1 = incrementSSE(xi, repeat), yi1 = incrementSSE(yi, repeat), zi1 = incrementSSE(zi, repeat);
+
+        // Same hierarchy as the permutation table hash: x is mixed in once per side, then y, then z
+        __m128i a = hashStepSSE(start, xi), b = hashStepSSE(start, xi1);
+        __m128i aa = hashStepSSE(a, yi), ab = hashStepSSE(a, yi1), ba = hashStepSSE(b, yi), bb = hashStepSSE(b, yi1);
+
+        __m128d xf = fadeSSE(xd), yf = fadeSSE(yd), zf = fadeSSE(zd);
+        __m128d xd1 = _mm_sub_pd(xd, one), yd1 = _mm_sub_pd(yd, one), zd1 = _mm_sub_pd(zd, one);
+
+        __m128d x1 = lerpSSE(gradientSSE(cornerHashSSE(aa, zi), xd, yd, zd), gradientSSE(cornerHashSSE(ba, zi), xd1, yd, zd), xf);
+        __m128d x2 = lerpSSE(gradientSSE(cornerHashSSE(ab, zi), xd, yd1, zd), gradientSSE(cornerHashSSE(bb, zi), xd1, yd1, zd), xf);
+        __m128d y1 = lerpSSE(x1, x2, yf);
+        x1 = lerpSSE(gradientSSE(cornerHashSSE(aa, zi1), xd, yd, zd1), gradientSSE(cornerHashSSE(ba, zi1), xd1, yd, zd1), xf);
+        x2 = lerpSSE(gradientSSE(cornerHashSSE(ab, zi1), xd, yd1, zd1), gradientSSE(cornerHashSSE(bb, zi1), xd1, yd1, zd1), xf);
+        __m128d y2 = lerpSSE(x1, x2, yf);
+        _mm_storeu_pd(out + n, _mm_mul_pd(_mm_add_pd(lerpSSE(y1, y2, zf), one), _mm_set1_pd(0.5)));
+    }
+}
+
+PERLIN_TARGET("sse4.2")
+static void hashedKernel2DSSE42(unsigned int seed, const double* x, const double* y, double* out, int count, int repeat) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128i start = _mm_set1_epi32((int)latticeHashStart(seed));
+    const __m128i zi = _mm_setzero_si128();
+    for (int n = 0; n < count; n += 2) {
+        __m128d xd, yd;
+        __m128i xi = hashLatticeSSE(_mm_loadu_pd(x + n), &xd);
+        __m128i yi = hashLatticeSSE(_mm_loadu_pd(y + n), &yd);
+        __m128i xi1 = incrementSSE(xi, repeat), yi1 = incrementSSE(yi, repeat);
+
+        __m128i a = hashStepSSE(start, xi), b = hashStepSSE(start, xi1);
+        __m128i aa = cornerHashSSE(hashStepSSE(a, yi), zi), ab = cornerHashSSE(hashStepSSE(a, yi1), zi);
+        __m128i ba = cornerHashSSE(hashStepSSE(b, yi), zi), bb = cornerHashSSE(hashStepSSE(b, yi1), zi);
+
+        __m128d xf = fadeSSE(xd), yf = fadeSSE(yd);
+        __m128d xd1 = _mm_sub_pd(xd, one), yd1 = _mm_sub_pd(yd, one);
+
+        __m128d x1 = lerpSSE(gradientSSE(aa, xd, yd, zero), gradientSSE(ba, xd1, yd, zero), xf);
+        __m128d x2 = lerpSSE(gradientSSE(ab, xd, yd1, zero), gradientSSE(bb, xd1, yd1, zero), xf);
+        _mm_storeu_pd(out + n, _mm_mul_pd(_mm_add_pd(lerpSSE(x1, x2, yf), one), _mm_set1_pd(0.5)));
+    }
+}
+
+// AVX2 KERNEL - 4 points per iteration
+// Lattice indices live in 4 x int32 SSE registers so the permutation table lookups can use hardware gathers
+
+PERLIN_TARGET("avx2")
+static inline __m256d gradientAVX2(__m128i hash, __m256d x, __m256d y, __m256d z) {
+    __m256i h = _mm256_and_si256(_mm256_cvtepi32_epi64(hash), _mm256_set1_epi64x(15));
+    __m256d lt8 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(8), h));
+    __m256d lt4 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(4), h));
+    __m256d xv = _mm256_castsi256_pd(_mm256_or_si256(_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(12)), _mm256_cmpeq_epi64(h, _mm256_set1_epi64x(14))));
+    __m256d u = _mm256_blendv_pd(y, x, lt8);
+    __m256d v = _mm256_blendv_pd(_mm256_blendv_pd(z, x, xv), y, lt4);
+    u = _mm256_xor_pd(u, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(1)), 63)));
+    v = _mm256_xor_pd(v, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(2)), 62)));
+    return _mm256_add_pd(u, v);
+}
+
+PERLIN_TARGET("avx2")
+static inline __m256d lerpAVX2(__m256d a, __m256d b, __m256d t) {
+    return _mm256_add_pd(a, _mm256_mul_pd(t, _mm256_sub_pd(b, a)));
+}
+
+PERLIN_TARGET("avx2")
+static inline __m256d fadeAVX2(__m256d t) {
+    __m256d a = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(6), t), t), t), t), t);
+    __m256d b = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(15), t), t), t), t);
+    __m256d c = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(10), t), t), t);
+    return _mm256_add_pd(_mm256_sub_pd(a, b), c);
+}
+
+PERLIN_TARGET("avx2")
+static inline __m128i latticeAVX2(__m256d v, __m256d* d) {
+    __m256d fl = _mm256_floor_pd(v);
+    __m256d wrapped = _mm256_sub_pd(fl, _mm256_mul_pd(_mm256_set1_pd(256.0), _mm256_floor_pd(_mm256_mul_pd(fl, _mm256_set1_pd(1.0 / 256.0)))));
+    *d = _mm256_sub_pd(v, fl);
+    return _mm256_cvttpd_epi32(wrapped);
+}
+
+// Adds 1 to each lattice index, wrapping it back to 0 when it reaches repeat (the same as Perlin::increment for indices below repeat)
+PERLIN_TARGET("avx2")
+static inline __m128i incrementAVX2(__m128i i, int repeat) {
+    i = _mm_add_epi32(i, _mm_set1_epi32(1));
+    if (repeat > 0)
+        i = _mm_andnot_si128(_mm_cmpeq_epi32(i, _mm_set1_epi32(repeat)), i);
+    return i;
+}
+
+PERLIN_TARGET("avx2")
+static void kernelAVX2(const int* p, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    for (int n = 0; n < count; n += 4) {
+        __m256d xd, yd, zd;
+        __m128i xi = latticeAVX2(_mm256_loadu_pd(x + n), &xd);
+        __m128i yi = latticeAVX2(_mm256_loadu_pd(y + n), &yd);
+        __m128i zi = latticeAVX2(_mm256_loadu_pd(z + n), &zd);
+        __m128i xi1 = incrementAVX2(xi, repeat), yi1 = incrementAVX2(yi, repeat), zi1 = incrementAVX2(zi, repeat);
+
+        __m128i a = _mm_i32gather_epi32(p, xi, 4);
+        __m128i b = _mm_i32gather_epi32(p, xi1, 4);
+        __m128i aa = _mm_i32gather_epi32(p, _mm_add_epi32(a, yi), 4);
+        __m128i ab = _mm_i32gather_epi32(p, _mm_add_epi32(a, yi1), 4);
+        __m128i ba = _mm_i32gather_epi32(p, _mm_add_epi32(b, yi), 4);
+        __m128i bb = _mm_i32gather_epi32(p, _mm_add_epi32(b, yi1), 4);
+
+        __m256d xf = fadeAVX2(xd), yf = fadeAVX2(yd), zf = fadeAVX2(zd);
+        __m256d xd1 = _mm256_sub_pd(xd, one), yd1 = _mm256_sub_pd(yd, one), zd1 = _mm256_sub_pd(zd, one);
+
+        __m256d x1 = lerpAVX2(gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(aa, zi), 4), xd, yd, zd),
+                              gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(ba, zi), 4), xd1, yd, zd), xf);
+        __m256d x2 = lerpAVX2(gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(ab, zi), 4), xd, yd1, zd),
+                              gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(bb, zi), 4), xd1, yd1, zd), xf);
+        __m256d y1 = lerpAVX2(x1, x2, yf);
+        x1 = lerpAVX2(gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(aa, zi1), 4), xd, yd, zd1),
+                      gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(ba, zi1), 4), xd1, yd, zd1), xf);
+        x2 = lerpAVX2(gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(ab, zi1), 4), xd, yd1, zd1),
+                      gradientAVX2(_mm_i32gather_epi32(p, _mm_add_epi32(bb, zi1), 4), xd1, yd1, zd1), xf);
+        __m256d y2 = lerpAVX2(x1, x2, yf);
+        _mm256_storeu_pd(out + n, _mm256_mul_pd(_mm256_add_pd(lerpAVX2(y1, y2, zf), one), _mm256_set1_pd(0.5)));
+    }
+}
+
+PERLIN_TARGET("avx2")
+static void kernel2DAVX2(const int* p, const double* x, const double* y, double* out, int count, int repeat) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    for (int n = 0; n < count; n += 4) {
+        __m256d xd, yd;
+        __m128i xi = latticeAVX2(_mm256_loadu_pd(x + n), &xd);
+        __m128i yi = latticeAVX2(_mm256_loadu_pd(y + n), &yd);
+        __m128i xi1 = incrementAVX2(xi, repeat), yi1 = incrementAVX2(yi, repeat);
+
+        __m128i a = _mm_i32gather_epi32(p, xi, 4);
+        __m128i b = _mm_i32gather_epi32(p, xi1, 4);
+        __m128i aa = _mm_i32gather_epi32(p, _mm_i32gather_epi32(p, _mm_add_epi32(a, yi), 4), 4);
+        __m128i ab = _mm_i32gather_epi32(p, _mm_i32gather_epi32(p, _mm_add_epi32(a, yi1), 4), 4);
+        __m128i ba = _mm_i32gather_epi32(p, _mm_i32gather_epi32(p, _mm_add_epi32(b, yi), 4), 4);
+        __m128i bb = _mm_i32gather_epi32(p, _mm_i32gather_epi32(p, _mm_add_epi32(b, yi1), 4), 4);
+
+        __m256d xf = fadeAVX2(xd), yf = fadeAVX2(yd);
+        __m256d xd1 = _mm256_sub_pd(xd, one), yd1 = _mm256_sub_pd(yd, one);
+
+        __m256d x1 = lerpAVX2(gradientAVX2(aa, xd, yd, zero), gradientAVX2(ba, xd1, yd, zero), xf);
+        __m256d x2 = lerpAVX2(gradientAVX2(ab, xd, yd1, zero), gradientAVX2(bb, xd1, yd1, zero), xf);
+        _mm256_storeu_pd(out + n, _mm256_mul_pd(_mm256_add_pd(lerpAVX2(x1, x2, yf), one), _mm256_set1_pd(0.5)));
+    }
+}
+
+// Hashed AVX2 kernels: the lattice hash runs on the same 4 x int32 registers the gathers used (with the SSE hash functions), with no memory accesses
+
+// Splits a coordinate into its hash lattice coordinate (floor mod 2^32) and its decimal part, see hashLatticeSSE()
+PERLIN_TARGET("avx2")
+static inline __m128i hashLatticeAVX2(__m256d v, __m256d* d) {
+    __m256d fl = _mm256_floor_pd(v);
+    __m256d wrapped = _mm256_sub_pd(fl, _mm256_mul_pd(_mm256_set1_pd(4294967296.0), _mm256_floor_pd(_mm256_mul_pd(fl, _mm256_set1_pd(1.0 / 4294967296.0)))));
+    *d = _mm256_sub_pd(v, fl);
+    return _mm_xor_si128(_mm256_cvttpd_epi32(_mm256_sub_pd(wrapped, _mm256_set1_pd(2147483648.0))), _mm_set1_epi32((int)0x80000000u));
+}
+
+PERLIN_TARGET("avx2")
+static void hashedKernelAVX2(unsigned int seed, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m128i start = _mm_set1_epi32((int)latticeHashStart(seed));
+    for (int n = 0; n < count; n += 4) {
+        __m256d xd, yd, zd;
+        __m128i xi = hashLatticeAVX2(_mm256_loadu_pd(x + n), &xd);
+        __m128i yi = hashLatticeAVX2(_mm256_loadu_pd(y + n), &yd);
+        __m128i zi = hashLatticeAVX2(_mm256_loadu_pd(z + n), &zd);
+        __m128i xi1 = incrementAVX2(xi, repeat), yi1 = incrementAVX2(yi, repeat), zi1 = incrementAVX2(zi, repeat);
+
+        // Same hierarchy as the permutation table hash: x is mixed in once per side, then y, then z
+        __m128i a = hashStepSSE(start, xi), b = hashStepSSE(start, xi1);
+        __m128i aa = hashStepSSE(a, yi), ab = hashStepSSE(a, yi1), ba = hashStepSSE(b, yi), bb = hashStepSSE(b, yi1);
+
+        __m256d xf = fadeAVX2(xd), yf = fadeAVX2(yd), zf = fadeAVX2(zd);
+        __m256d xd1 = _mm256_sub_pd(xd, one), yd1 = _mm256_sub_pd(yd, one), zd1 = _mm256_sub_pd(zd, one);
+
+        __m256d x1 = lerpAVX2(gradientAVX2(hashFinalSSE(hashStepSSE(aa, zi)), xd, yd, zd), gradientAVX2(hashFinalSSE(hashStepSSE(ba, zi)), xd1, yd, zd), xf);
+        __m256d x2 = lerpAVX2(gradientAVX2(hashFinalSSE(hashStepSSE(ab, zi)), xd, yd1, zd), gradientAVX2(hashFinalSSE(hashStepSSE(bb, zi)), xd1, yd1, zd), xf);
+        __m256d y1 = lerpAVX2(x1, x2, yf);
+        x1 = lerpAVX2(gradientAVX2(hashFinalSSE(hashStepSSE(aa, zi1)), xd, yd, zd1), gradientAVX2(hashFinalSSE(hashStepSSE(ba, zi1)), xd1, yd, zd1), xf);
+        x2 = lerpAVX2(gradientAVX2(hashFinalSSE(hashStepSSE(ab, zi1)), xd, yd1, zd1), gradientAVX2(hashFinalSSE(hashStepSSE(bb, zi1)), xd1, yd1, zd1), xf);
+        __m256d y2 = lerpAVX2(x1, x2, yf);
+        _mm256_storeu_pd(out + n, _mm256_mul_pd(_mm256_add_pd(lerpAVX2(y1, y2, zf), one), _mm256_set1_pd(0.5)));
+    }
+}
+
+PERLIN_TARGET("avx2")
+static void hashedKernel2DAVX2(unsigned int seed, const double* x, const double* y, double* out, int count, int repeat) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m128i start = _mm_set1_epi32((int)latticeHashStart(seed));
+    const __m128i zi = _mm_setzero_si128();
+    for (int n = 0; n < count; n += 4) {
+        __m256d xd, yd;
+        __m128i xi = hashLatticeAVX2(_mm256_loadu_pd(x + n), &xd);
+        __m128i yi = hashLatticeAVX2(_mm256_loadu_pd(y + n), &yd);
+        __m128i xi1 = incrementAVX2(xi, repeat), yi1 = incrementAVX2(yi, repeat);
+
+        __m128i a = hashStepSSE(start, xi), b = hashStepSSE(start, xi1);
+        __m128i aa = hashFinalSSE(hashStepSSE(hashStepSSE(a, yi), zi)), ab = hashFinalSSE(hashStepSSE(hashStepSSE(a, yi1), zi));
+        __m128i ba = hashFinalSSE(hashStepSSE(hashStepSSE(b, yi), zi)), bb = hashFinalSSE(hashStepSSE(hashStepSSE(b, yi1), zi));
+
+        __m256d xf = fadeAVX2(xd), yf = fadeAVX2(yd);
+        __m256d xd1 = _mm256_sub_pd(xd, one), yd1 = _mm256_sub_pd(yd, one);
+
+        __m256d x1 = lerpAVX2(gradientAVX2(aa, xd, yd, zero), gradientAVX2(ba, xd1, yd, zero), xf);
+        __m256d x2 = lerpAVX2(gradientAVX2(ab, xd, yd1, zero), gradientAVX2(bb, xd1, yd1, zero), xf);
+        _mm256_storeu_pd(out + n, _mm256_mul_pd(_mm256_add_pd(lerpAVX2(x1, x2, yf), one), _mm256_set1_pd(0.5)));
+    }
+}
+
+// AVX-512 KERNEL - 8 points per iteration
+// Lattice indices live in 8 x int32 AVX2 registers for the gathers, the gradient selection uses AVX-512 mask registers
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m512d gradientAVX512(__m256i hash, __m512d x, __m512d y, __m512d z) {
+    __m512i h = _mm512_and_si512(_mm512_cvtepi32_epi64(hash), _mm512_set1_epi64(15));
+    __mmask8 lt8 = _mm512_cmplt_epi64_mask(h, _mm512_set1_epi64(8));
+    __mmask8 lt4 = _mm512_cmplt_epi64_mask(h, _mm512_set1_epi64(4));
+    __mmask8 xv = _mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(12)) | _mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(14));
+    __m512d u = _mm512_mask_blend_pd(lt8, y, x);
+    __m512d v = _mm512_mask_blend_pd(lt4, _mm512_mask_blend_pd(xv, z, x), y);
+    __m512i su = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(1)), 63);
+    __m512i sv = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(2)), 62);
+    u = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(u), su));
+    v = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(v), sv));
+    return _mm512_add_pd(u, v);
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m512d lerpAVX512(__m512d a, __m512d b, __m512d t) {
+    return _mm512_add_pd(a, _mm512_mul_pd(t, _mm512_sub_pd(b, a)));
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m512d fadeAVX512(__m512d t) {
+    __m512d a = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(6), t), t), t), t), t);
+    __m512d b = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(15), t), t), t), t);
+    __m512d c = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(10), t), t), t);
+    return _mm512_add_pd(_mm512_sub_pd(a, b), c);
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m256i latticeAVX512(__m512d v, __m512d* d) {
+    __m512d fl = _mm512_roundscale_pd(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    __m512d q = _mm512_roundscale_pd(_mm512_mul_pd(fl, _mm512_set1_pd(1.0 / 256.0)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    *d = _mm512_sub_pd(v, fl);
+    return _mm512_cvttpd_epi32(_mm512_sub_pd(fl, _mm512_mul_pd(_mm512_set1_pd(256.0), q)));
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m256i incrementAVX512(__m256i i, int repeat) {
+    i = _mm256_add_epi32(i, _mm256_set1_epi32(1));
+    if (repeat > 0)
+        i = _mm256_andnot_si256(_mm256_cmpeq_epi32(i, _mm256_set1_epi32(repeat)), i);
+    return i;
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static void kernelAVX512(const int* p, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    for (int n = 0; n < count; n += 8) {
+        __m512d xd, yd, zd;
+        __m256i xi = latticeAVX512(_mm512_loadu_pd(x + n), &xd);
+        __m256i yi = latticeAVX512(_mm512_loadu_pd(y + n), &yd);
+        __m256i zi = latticeAVX512(_mm512_loadu_pd(z + n), &zd);
+        __m256i xi1 = incrementAVX512(xi, repeat), yi1 = incrementAVX512(yi, repeat), zi1 = incrementAVX512(zi, repeat);
+
+        __m256i a = _mm256_i32gather_epi32(p, xi, 4);
+        __m256i b = _mm256_i32gather_epi32(p, xi1, 4);
+        __m256i aa = _mm256_i32gather_epi32(p, _mm256_add_epi32(a, yi), 4);
+        __m256i ab = _mm256_i32gather_epi32(p, _mm256_add_epi32(a, yi1), 4);
+        __m256i ba = _mm256_i32gather_epi32(p, _mm256_add_epi32(b, yi), 4);
+        __m256i bb = _mm256_i32gather_epi32(p, _mm256_add_epi32(b, yi1), 4);
+
+        __m512d xf = fadeAVX512(xd), yf = fadeAVX512(yd), zf = fadeAVX512(zd);
+        __m512d xd1 = _mm512_sub_pd(xd, one), yd1 = _mm512_sub_pd(yd, one), zd1 = _mm512_sub_pd(zd, one);
+
+        __m512d x1 = lerpAVX512(gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(aa, zi), 4), xd, yd, zd),
+                                gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(ba, zi), 4), xd1, yd, zd), xf);
+        __m512d x2 = lerpAVX512(gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(ab, zi), 4), xd, yd1, zd),
+                                gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(bb, zi), 4), xd1, yd1, zd), xf);
+        __m512d y1 = lerpAVX512(x1, x2, yf);
+        x1 = lerpAVX512(gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(aa, zi1), 4), xd, yd, zd1),
+                        gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(ba, zi1), 4), xd1, yd, zd1), xf);
+        x2 = lerpAVX512(gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(ab, zi1), 4), xd, yd1, zd1),
+                        gradientAVX512(_mm256_i32gather_epi32(p, _mm256_add_epi32(bb, zi1), 4), xd1, yd1, zd1), xf);
+        __m512d y2 = lerpAVX512(x1, x2, yf);
+        _mm512_storeu_pd(out + n, _mm512_mul_pd(_mm512_add_pd(lerpAVX512(y1, y2, zf), one), _mm512_set1_pd(0.5)));
+    }
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static void kernel2DAVX512(const int* p, const double* x, const double* y, double* out, int count, int repeat) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d zero = _mm512_setzero_pd();
+    for (int n = 0; n < count; n += 8) {
+        __m512d xd, yd;
+        __m256i xi = latticeAVX512(_mm512_loadu_pd(x + n), &xd);
+        __m256i yi = latticeAVX512(_mm512_loadu_pd(y + n), &yd);
+        __m256i xi1 = incrementAVX512(xi, repeat), yi1 = incrementAVX512(yi, repeat);
+
+        __m256i a = _mm256_i32gather_epi32(p, xi, 4);
+        __m256i b = _mm256_i32gather_epi32(p, xi1, 4);
+        __m256i aa = _mm256_i32gather_epi32(p, _mm256_i32gather_epi32(p, _mm256_add_epi32(a, yi), 4), 4);
+        __m256i ab = _mm256_i32gather_epi32(p, _mm256_i32gather_epi32(p, _mm256_add_epi32(a, yi1), 4), 4);
+        __m256i ba = _mm256_i32gather_epi32(p, _mm256_i32gather_epi32(p, _mm256_add_epi32(b, yi), 4), 4);
+        __m256i bb = _mm256_i32gather_epi32(p, _mm256_i32gather_epi32(p, _mm256_add_epi32(b, yi1), 4), 4);
+
+        __m512d xf = fadeAVX512(xd), yf = fadeAVX512(yd);
+        __m512d xd1 = _mm512_sub_pd(xd, one), yd1 = _mm512_sub_pd(yd, one);
+
+        __m512d x1 = lerpAVX512(gradientAVX512(aa, xd, yd, zero), gradientAVX512(ba, xd1, yd, zero), xf);
+        __m512d x2 = lerpAVX512(gradientAVX512(ab, xd, yd1, zero), gradientAVX512(bb, xd1, yd1, zero), xf);
+        _mm512_storeu_pd(out + n, _mm512_mul_pd(_mm512_add_pd(lerpAVX512(x1, x2, yf), one), _mm512_set1_pd(0.5)));
+    }
+}
+
+// Hashed AVX-512 kernels, the 8 lane versions of the hashed AVX2 kernels (AVX-512F converts straight to unsigned ints)
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m256i hashLatticeAVX512(__m512d v, __m512d* d) {
+    __m512d fl = _mm512_roundscale_pd(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    __m512d q = _mm512_roundscale_pd(_mm512_mul_pd(fl, _mm512_set1_pd(1.0 / 4294967296.0)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    *d = _mm512_sub_pd(v, fl);
+    return _mm512_cvttpd_epu32(_mm512_sub_pd(fl, _mm512_mul_pd(_mm512_set1_pd(4294967296.0), q)));
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m256i hashStepAVX512(__m256i h, __m256i coordinate) {
+    h = _mm256_add_epi32(h, _mm256_mullo_epi32(coordinate, _mm256_set1_epi32((int)LATTICE_HASH_PRIME3)));
+    return _mm256_mullo_epi32(_mm256_or_si256(_mm256_slli_epi32(h, 17), _mm256_srli_epi32(h, 15)), _mm256_set1_epi32((int)LATTICE_HASH_PRIME4));
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static inline __m256i hashFinalAVX512(__m256i h) {
+    h = _mm256_mullo_epi32(_mm256_xor_si256(h, _mm256_srli_epi32(h, 15)), _mm256_set1_epi32((int)LATTICE_HASH_PRIME2));
+    h = _mm256_mullo_epi32(_mm256_xor_si256(h, _mm256_srli_epi32(h, 13)), _mm256_set1_epi32((int)LATTICE_HASH_PRIME3));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static void hashedKernelAVX512(unsigned int seed, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m256i start = _mm256_set1_epi32((int)latticeHashStart(seed));
+    for (int n = 0; n < count; n += 8) {
+        __m512d xd, yd, zd;
+        __m256i xi = hashLatticeAVX512(_mm512_loadu_pd(x + n), &xd);
+        __m256i yi = hashLatticeAVX512(_mm512_loadu_pd(y + n), &yd);
+        __m256i zi = hashLatticeAVX512(_mm512_loadu_pd(z + n), &zd);
+        __m256i xi1 = incrementAVX512(xi, repeat), yi1 = incrementAVX512(yi, repeat), zi1 = incrementAVX512(zi, repeat);
+
+        __m256i a = hashStepAVX512(start, xi), b = hashStepAVX512(start, xi1);
+        __m256i aa = hashStepAVX512(a, yi), ab = hashStepAVX512(a, yi1), ba = hashStepAVX512(b, yi), bb = hashStepAVX512(b, yi1);
+
+        __m512d xf = fadeAVX512(xd), yf = fadeAVX512(yd), zf = fadeAVX512(zd);
+        __m512d xd1 = _mm512_sub_pd(xd, one), yd1 = _mm512_sub_pd(yd, one), zd1 = _mm512_sub_pd(zd, one);
+
+        __m512d x1 = lerpAVX512(gradientAVX512(hashFinalAVX512(hashStepAVX512(aa, zi)), xd, yd, zd), gradientAVX512(hashFinalAVX512(hashStepAVX512(ba, zi)), xd1, yd, zd), xf);
+        __m512d x2 = lerpAVX512(gradientAVX512(hashFinalAVX512(hashStepAVX512(ab, zi)), xd, yd1, zd), gradientAVX512(hashFinalAVX512(hashStepAVX512(bb, zi)), xd1, yd1, zd), xf);
+        __m512d y1 = lerpAVX512(x1, x2, yf);
+        x1 = lerpAVX512(gradientAVX512(hashFinalAVX512(hashStepAVX512(aa, zi1)), xd, yd, zd1), gradientAVX512(hashFinalAVX512(hashStepAVX512(ba, zi1)), xd1, yd, zd1), xf);
+        x2 = lerpAVX512(gradientAVX512(hashFinalAVX512(hashStepAVX512(ab, zi1)), xd, yd1, zd1), gradientAVX512(hashFinalAVX512(hashStepAVX512(bb, zi1)), xd1, yd1, zd1), xf);
+        __m512d y2 = lerpAVX512(x1, x2, yf);
+        _mm512_storeu_pd(out + n, _mm512_mul_pd(_mm512_add_pd(lerpAVX512(y1, y2, zf), one), _mm512_set1_pd(0.5)));
+    }
+}
+
+PERLIN_TARGET("avx512f,avx2")
+static void hashedKernel2DAVX512(unsigned int seed, const double* x, const double* y, double* out, int count, int repeat) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m256i start = _mm256_set1_epi32((int)latticeHashStart(seed));
+    const __m256i zi = _mm256_setzero_si256();
+    for (int n = 0; n < count; n += 8) {
+        __m512d xd, yd;
+        __m256i xi = hashLatticeAVX512(_mm512_loadu_pd(x + n), &xd);
+        __m256i yi = hashLatticeAVX512(_mm512_loadu_pd(y + n), &yd);
+        __m256i xi1 = incrementAVX512(xi, repeat), yi1 = incrementAVX512(yi, repeat);
+
+        __m256i a = hashStepAVX512(start, xi), b = hashStepAVX512(start, xi1);
+        __m256i aa = hashFinalAVX512(hashStepAVX512(hashStepAVX512(a, yi), zi)), ab = hashFinalAVX512(hashStepAVX512(hashStepAVX512(a, yi1), zi));
+        __m256i ba = hashFinalAVX512(hashStepAVX512(hashStepAVX512(b, yi), zi)), bb = hashFinalAVX512(hashStepAVX512(hashStepAVX512(b, yi1), zi));
+
+        __m512d xf = fadeAVX512(xd), yf = fadeAVX512(yd);
+        __m512d xd1 = _mm512_sub_pd(xd, one), yd1 = _mm512_sub_pd(yd, one);
+
+        __m512d x1 = lerpAVX512(gradientAVX512(aa, xd, yd, zero), gradientAVX512(ba, xd1, yd, zero), xf);
+        __m512d x2 = lerpAVX512(gradientAVX512(ab, xd, yd1, zero), gradientAVX512(bb, xd1, yd1, zero), xf);
+        _mm512_storeu_pd(out + n, _mm512_mul_pd(_mm512_add_pd(lerpAVX512(x1, x2, yf), one), _mm512_set1_pd(0.5)));
+    }
+}
+
+#endif
+
+// FIXED-POINT KERNELS - 8-bit texels from integer arithmetic (see Perlin::evaluateRow8 for the number formats)
+// Every level performs exactly the same integer operations, so unlike the double kernels nothing has to be done to keep them in step:
+// all levels give identical texels. The vector kernels return how many points they did, and the scalar kernel finishes the rest
+
+// _mm_mulhrs_epi16 for one lane: a * b / 2^15, rounded
+static inline int mulhrsFixed(int a, int b) {
+    return (a * b + 0x4000) >> 15;
+}
+
+// Fade function 6t^5 - 15t^4 + 10t^3 = t^3 * (6t^2 - 15t + 10) for t in Q15, kept within 16 bits: the second factor lies in [1,10] so it's
+// computed in Q11, and the product comes out in Q11 before being shifted back up to Q15 (capped just below 1 so it still fits)
+static inline int fadeFixed(int t) {
+    int t2 = mulhrsFixed(t, t);
+    int t3 = mulhrsFixed(t2, t);
+    int u = 20480 - (t >> 4) * 15 + (t2 >> 4) * 6;
+    int f = mulhrsFixed(t3, u);
+    return (f < 2047 ? f : 2047) << 4;
+}
+
+// Maps a Q12 noise value in [-1,1] to an 8-bit texel: (value + 1) / 2 * 255 in 8.8 fixed point, plus the dither threshold, truncated
+static inline unsigned char quantizeFixed(int v, int dither) {
+    int n = v < -4096 ? -4096 : (v > 4095 ? 4095 : v);
+    int w = (((n + 4096) << 3) * 65280) >> 16;
+    w = w + dither > 65535 ? 65535 : w + dither;
+    return (unsigned char)(w >> 8);
+}
+
+static void fixedRow8Scalar(const short* t, const short* gx, const short* k, int corners, int fy, int fz, const unsigned short* dither, unsigned char* out, int start, int count) {
+    for (int i = start; i < count; i++) {
+        int f = fadeFixed(t[i]);
+        int xd = t[i] >> 3;
+        int xd1 = xd - 4096;
+        int d[8];
+        for (int c = 0; c < corners; c++)
+            d[c] = gx[c] * ((c & 1) ? xd1 : xd) + k[c];
+
+        int v = d[0] + mulhrsFixed(d[1] - d[0], f);
+        int x2 = d[2] + mulhrsFixed(d[3] - d[2], f);
+        v = v + mulhrsFixed(x2 - v, fy);
+        if (corners == 8) {
+            int x1 = d[4] + mulhrsFixed(d[5] - d[4], f);
+            x2 = d[6] + mulhrsFixed(d[7] - d[6], f);
+            int y2 = x1 + mulhrsFixed(x2 - x1, fy);
+            v = v + mulhrsFixed(y2 - v, fz);
+        }
+        out[i] = quantizeFixed(v, dither ? dither[i] : 0);
+    }
+}
+
+#ifdef PERLIN_SIMD_X86
+
+// SSE4.2 - 8 points per iteration (_mm_mulhrs_epi16 is SSSE3, which every SSE4.2 CPU has)
+PERLIN_TARGET("sse4.2")
+static inline __m128i lerpFixedSSE(__m128i a, __m128i b, __m128i f) {
+    return _mm_add_epi16(a, _mm_mulhrs_epi16(_mm_sub_epi16(b, a), f));
+}
+
+PERLIN_TARGET("sse4.2")
+static inline __m128i fadeFixedSSE(__m128i t) {
+    __m128i t2 = _mm_mulhrs_epi16(t, t);
+    __m128i t3 = _mm_mulhrs_epi16(t2, t);
+    __m128i u = _mm_sub_epi16(_mm_set1_epi16(20480), _mm_mullo_epi16(_mm_srai_epi16(t, 4), _mm_set1_epi16(15)));
+    u = _mm_add_epi16(u, _mm_mullo_epi16(_mm_srai_epi16(t2, 4), _mm_set1_epi16(6)));
+    return _mm_slli_epi16(_mm_min_epi16(_mm_mulhrs_epi16(t3, u), _mm_set1_epi16(2047)), 4);
+}
+
+PERLIN_TARGET("sse4.2")
+static inline __m128i quantizeFixedSSE(__m128i v, __m128i dither) {
+    __m128i n = _mm_min_epi16(_mm_max_epi16(v, _mm_set1_epi16(-4096)), _mm_set1_epi16(4095));
+    __m128i w = _mm_mulhi_epu16(_mm_slli_epi16(_mm_add_epi16(n, _mm_set1_epi16(4096)), 3), _mm_set1_epi16((short)65280));
+    return _mm_srli_epi16(_mm_adds_epu16(w, dither), 8);
+}
+
+PERLIN_TARGET("sse4.2")
+static int fixedRow8SSE42(const short* t, const short* gx, const short* k, int corners, int fy, int fz, const unsigned short* dither, unsigned char* out, int count) {
+    const __m128i fyv = _mm_set1_epi16((short)fy), fzv = _mm_set1_epi16((short)fz);
+    __m128i gxv[8], kv[8];
+    for (int c = 0; c < corners; c++) {
+        gxv[c] = _mm_set1_epi16(gx[c]);
+        kv[c] = _mm_set1_epi16(k[c]);
+    }
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i tv = _mm_loadu_si128((const __m128i*)(t + i));
+        __m128i f = fadeFixedSSE(tv);
+        __m128i xd[2];
+        xd[0] = _mm_srai_epi16(tv, 3);
+        xd[1] = _mm_sub_epi16(xd[0], _mm_set1_epi16(4096));
+
+        __m128i d[8];
+        for (int c = 0; c < corners; c++)
+            d[c] = _mm_add_epi16(_mm_mullo_epi16(gxv[c], xd[c & 1]), kv[c]);
+
+        __m128i v = lerpFixedSSE(lerpFixedSSE(d[0], d[1], f), lerpFixedSSE(d[2], d[3], f), fyv);
+        if (corners == 8)
+            v = lerpFixedSSE(v, lerpFixedSSE(lerpFixedSSE(d[4], d[5], f), lerpFixedSSE(d[6], d[7], f), fyv), fzv);
+
+        __m128i dv = dither ? _mm_loadu_si128((const __m128i*)(dither + i)) : _mm_setzero_si128();
+        __m128i texels = quantizeFixedSSE(v, dv);
+        _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(texels, texels));
+    }
+    return i;
+}
+
+// AVX2 - 16 points per iteration (also used at the AVX-512 level, since 16-bit lanes need AVX-512BW rather than AVX-512F)
+PERLIN_TARGET("avx2")
+static inline __m256i lerpFixedAVX2(__m256i a, __m256i b, __m256i f) {
+    return _mm256_add_epi16(a, _mm256_mulhrs_epi16(_mm256_sub_epi16(b, a), f));
+}
+
+PERLIN_TARGET("avx2")
+static inline __m256i fadeFixedAVX2(__m256i t) {
+    __m256i t2 = _mm256_mulhrs_epi16(t, t);
+    __m256i t3 = _mm256_mulhrs_epi16(t2, t);
+    __m256i u = _mm256_sub_epi16(_mm256_set1_epi16(20480), _mm256_mullo_epi16(_mm256_srai_epi16(t, 4), _mm256_set1_epi16(15)));
+    u = _mm256_add_epi16(u, _mm256_mullo_epi16(_mm256_srai_epi16(t2, 4), _mm256_set1_epi16(6)));
+    return _mm256_slli_epi16(_mm256_min_epi16(_mm256_mulhrs_epi16(t3, u), _mm256_set1_epi16(2047)), 4);
+}
+
+PERLIN_TARGET("avx2")
+static inline __m256i quantizeFixedAVX2(__m256i v, __m256i dither) {
+    __m256i n = _mm256_min_epi16(_mm256_max_epi16(v, _mm256_set1_epi16(-4096)), _mm256_set1_epi16(4095));
+    __m256i w = _mm256_mulhi_epu16(_mm256_slli_epi16(_mm256_add_epi16(n, _mm256_set1_epi16(4096)), 3), _mm256_set1_epi16((short)65280));
+    return _mm256_srli_epi16(_mm256_adds_epu16(w, dither), 8);
+}
+
+PERLIN_TARGET("avx2")
+static int fixedRow8AVX2(const short* t, const short* gx, const short* k, int corners, int fy, int fz, const unsigned short* dither, unsigned char* out, int count) {
+    const __m256i fyv = _mm256_set1_epi16((short)fy), fzv = _mm256_set1_epi16((short)fz);
+    __m256i gxv[8], kv[8];
+    for (int c = 0; c < corners; c++) {
+        gxv[c] = _mm256_set1_epi16(gx[c]);
+        kv[c] = _mm256_set1_epi16(k[c]);
+    }
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i tv = _mm256_loadu_si256((const __m256i*)(t + i));
+        __m256i f = fadeFixedAVX2(tv);
+        __m256i xd[2];
+        xd[0] = _mm256_srai_epi16(tv, 3);
+        xd[1] = _mm256_sub_epi16(xd[0], _mm256_set1_epi16(4096));
+
+        __m256i d[8];
+        for (int c = 0; c < corners; c++)
+            d[c] = _mm256_add_epi16(_mm256_mullo_epi16(gxv[c], xd[c & 1]), kv[c]);
+
+        __m256i v = lerpFixedAVX2(lerpFixedAVX2(d[0], d[1], f), lerpFixedAVX2(d[2], d[3], f), fyv);
+        if (corners == 8)
+            v = lerpFixedAVX2(v, lerpFixedAVX2(lerpFixedAVX2(d[4], d[5], f), lerpFixedAVX2(d[6], d[7], f), fyv), fzv);
+
+        __m256i dv = dither ? _mm256_loadu_si256((const __m256i*)(dither + i)) : _mm256_setzero_si256();
+        __m256i texels = quantizeFixedAVX2(v, dv);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(_mm256_castsi256_si128(texels), _mm256_extracti128_si256(texels, 1)));
+    }
+    return i;
+}
+
+#endif
+
+// MULTI-FIELD KERNELS - the blend of Perlin::evaluateRowFields for 4 fields, one vector lane per field
+// Each point's 4 values are the r,g,b,a of a texel, so a point is blended with broadcast x weights and stored in one go
+// The cube constants are laid out corner by corner, 4 fields per corner: gx[c*4 + f] is corner c of field f
+// Same operations in the same order as the scalar blend, so every level gives identical results
+
+static void blendFields4Scalar(const double* xd, const double* xf, const double* gx, const double* gy, const double* gz, double yf, double zf, double* out, int start, int count) {
+    for (int i = start; i < count; i++) {
+        double xd0 = xd[i];
+        double xd1 = xd0-1;
+        double t = xf[i];
+        for (int f = 0; f < 4; f++) {
+            double d[8];
+            for (int c = 0; c < 8; c++)
+                d[c] = (gx[c*4 + f]*((c & 1) ? xd1 : xd0) + gy[c*4 + f]) + gz[c*4 + f];
+            double x1 = d[0] + t*(d[1]-d[0]);
+            double x2 = d[2] + t*(d[3]-d[2]);
+            double y1 = x1 + yf*(x2-x1);
+            x1 = d[4] + t*(d[5]-d[4]);
+            x2 = d[6] + t*(d[7]-d[6]);
+            double y2 = x1 + yf*(x2-x1);
+            out[i*4 + f] = ((y1 + zf*(y2-y1))+1)/2;
+        }
+    }
+}
+
+#ifdef PERLIN_SIMD_X86
+
+// SSE4.2 - one point per iteration, as two halves of 2 fields
+PERLIN_TARGET("sse4.2")
+static int blendFields4SSE42(const double* xd, const double* xf, const double* gx, const double* gy, const double* gz, double yf, double zf, double* out, int count) {
+    const __m128d one = _mm_set1_pd(1.0), half = _mm_set1_pd(0.5);
+    const __m128d fy = _mm_set1_pd(yf), fz = _mm_set1_pd(zf);
+    for (int i = 0; i < count; i++) {
+        __m128d xd0 = _mm_set1_pd(xd[i]);
+        __m128d xd1 = _mm_sub_pd(xd0, one);
+        __m128d t = _mm_set1_pd(xf[i]);
+        for (int h = 0; h < 4; h += 2) {
+            __m128d d[8];
+            for (int c = 0; c < 8; c++)
+                d[c] = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(gx + c*4 + h), (c & 1) ? xd1 : xd0), _mm_loadu_pd(gy + c*4 + h)), _mm_loadu_pd(gz + c*4 + h));
+            __m128d y1 = lerpSSE(lerpSSE(d[0], d[1], t), lerpSSE(d[2], d[3], t), fy);
+            __m128d y2 = lerpSSE(lerpSSE(d[4], d[5], t), lerpSSE(d[6], d[7], t), fy);
+            _mm_storeu_pd(out + i*4 + h, _mm_mul_pd(_mm_add_pd(lerpSSE(y1, y2, fz), one), half));
+        }
+    }
+    return count;
+}
+
+// AVX2 - one point per iteration, all 4 fields in one register
+PERLIN_TARGET("avx2")
+static int blendFields4AVX2(const double* xd, const double* xf, const double* gx, const double* gy, const double* gz, double yf, double zf, double* out, int count) {
+    const __m256d one = _mm256_set1_pd(1.0), half = _mm256_set1_pd(0.5);
+    const __m256d fy = _mm256_set1_pd(yf), fz = _mm256_set1_pd(zf);
+    for (int i = 0; i < count; i++) {
+        __m256d xd0 = _mm256_set1_pd(xd[i]);
+        __m256d xd1 = _mm256_sub_pd(xd0, one);
+        __m256d t = _mm256_set1_pd(xf[i]);
+        __m256d d[8];
+        for (int c = 0; c < 8; c++)
+            d[c] = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(gx + c*4), (c & 1) ? xd1 : xd0), _mm256_loadu_pd(gy + c*4)), _mm256_loadu_pd(gz + c*4));
+        __m256d y1 = lerpAVX2(lerpAVX2(d[0], d[1], t), lerpAVX2(d[2], d[3], t), fy);
+        __m256d y2 = lerpAVX2(lerpAVX2(d[4], d[5], t), lerpAVX2(d[6], d[7], t), fy);
+        _mm256_storeu_pd(out + i*4, _mm256_mul_pd(_mm256_add_pd(lerpAVX2(y1, y2, fz), one), half));
+    }
+    return count;
+}
+
+#endif
+
+void blendFields4(Level level, const double* xd, const double* xf, const double* gx, const double* gy, const double* gz, double yf, double zf, double* out, int count) {
+    int done = 0;
+#ifdef PERLIN_SIMD_X86
+    switch (level) {
+        case AVX2:
+        case AVX512: done = blendFields4AVX2(xd, xf, gx, gy, gz, yf, zf, out, count); break;
+        case SSE42: done = blendFields4SSE42(xd, xf, gx, gy, gz, yf, zf, out, count); break;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    blendFields4Scalar(xd, xf, gx, gy, gz, yf, zf, out, done, count);
+}
+
+// CELLULAR KERNELS - the distance search of Worley noise (see Worley::evaluateCell), one point per lane
+// Each lane keeps its point's two smallest squared distances, updated branchlessly with f2 = min(f2, max(f1, d)) and f1 = min(f1, d),
+// and the distances are summed in the same order at every level, so all levels give identical results
+
+static void nearestFeaturesScalar(const double* x, const double* y, const double* z, int start, int count, const double* fx, const double* fy, const double* fz, int features, double* f1, double* f2) {
+    for (int i = start; i < count; i++) {
+        double d1 = INFINITY, d2 = INFINITY;
+        for (int j = 0; j < features; j++) {
+            double dx = fx[j] - x[i], dy = fy[j] - y[i], dz = fz[j] - z[i];
+            double d = dx*dx + dy*dy + dz*dz;
+            d2 = fmin(d2, fmax(d1, d));
+            d1 = fmin(d1, d);
+        }
+        f1[i] = d1;
+        f2[i] = d2;
+    }
+}
+
+#ifdef PERLIN_SIMD_X86
+
+// SSE4.2 - 2 points per iteration
+PERLIN_TARGET("sse4.2")
+static int nearestFeaturesSSE42(const double* x, const double* y, const double* z, int count, const double* fx, const double* fy, const double* fz, int features, double* f1, double* f2) {
+    int n = 0;
+    for (; n + 2 <= count; n += 2) {
+        __m128d px = _mm_loadu_pd(x + n), py = _mm_loadu_pd(y + n), pz = _mm_loadu_pd(z + n);
+        __m128d d1 = _mm_set1_pd(INFINITY), d2 = d1;
+        for (int j = 0; j < features; j++) {
+            __m128d dx = _mm_sub_pd(_mm_set1_pd(fx[j]), px);
+            __m128d dy = _mm_sub_pd(_mm_set1_pd(fy[j]), py);
+            __m128d dz = _mm_sub_pd(_mm_set1_pd(fz[j]), pz);
+            __m128d d = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+            d2 = _mm_min_pd(d2, _mm_max_pd(d1, d));
+            d1 = _mm_min_pd(d1, d);
+        }
+        _mm_storeu_pd(f1 + n, d1);
+        _mm_storeu_pd(f2 + n, d2);
+    }
+    return n;
+}
+
+// AVX2 - 4 points per iteration
+PERLIN_TARGET("avx2")
+static int nearestFeaturesAVX2(const double* x, const double* y, const double* z, int count, const double* fx, const double* fy, const double* fz, int features, double* f1, double* f2) {
+    int n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m256d px = _mm256_loadu_pd(x + n), py = _mm256_loadu_pd(y + n), pz = _mm256_loadu_pd(z + n);
+        __m256d d1 = _mm256_set1_pd(INFINITY), d2 = d1;
+        for (int j = 0; j < features; j++) {
+            __m256d dx = _mm256_sub_pd(_mm256_set1_pd(fx[j]), px);
+            __m256d dy = _mm256_sub_pd(_mm256_set1_pd(fy[j]), py);
+            __m256d dz = _mm256_sub_pd(_mm256_set1_pd(fz[j]), pz);
+            __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+            d2 = _mm256_min_pd(d2, _mm256_max_pd(d1, d));
+            d1 = _mm256_min_pd(d1, d);
+        }
+        _mm256_storeu_pd(f1 + n, d1);
+        _mm256_storeu_pd(f2 + n, d2);
+    }
+    return n;
+}
+
+// AVX-512 - 8 points per iteration
+PERLIN_TARGET("avx512f,avx2")
+static int nearestFeaturesAVX512(const double* x, const double* y, const double* z, int count, const double* fx, const double* fy, const double* fz, int features, double* f1, double* f2) {
+    int n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m512d px = _mm512_loadu_pd(x + n), py = _mm512_loadu_pd(y + n), pz = _mm512_loadu_pd(z + n);
+        __m512d d1 = _mm512_set1_pd(INFINITY), d2 = d1;
+        for (int j = 0; j < features; j++) {
+            __m512d dx = _mm512_sub_pd(_mm512_set1_pd(fx[j]), px);
+            __m512d dy = _mm512_sub_pd(_mm512_set1_pd(fy[j]), py);
+            __m512d dz = _mm512_sub_pd(_mm512_set1_pd(fz[j]), pz);
+            __m512d d = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)), _mm512_mul_pd(dz, dz));
+            d2 = _mm512_min_pd(d2, _mm512_max_pd(d1, d));
+            d1 = _mm512_min_pd(d1, d);
+        }
+        _mm512_storeu_pd(f1 + n, d1);
+        _mm512_storeu_pd(f2 + n, d2);
+    }
+    return n;
+}
+
+#endif
+
+void nearestFeatures(Level level, const double* x, const double* y, const double* z, int count, const double* fx, const double* fy, const double* fz, int features, double* f1, double* f2) {
+    int done = 0;
+#ifdef PERLIN_SIMD_X86
+    switch (level) {
+        case AVX512:
+            done = nearestFeaturesAVX512(x, y, z, count, fx, fy, fz, features, f1, f2);
+            done += nearestFeaturesAVX2(x + done, y + done, z + done, count - done, fx, fy, fz, features, f1 + done, f2 + done);
+            break;
+        case AVX2: done = nearestFeaturesAVX2(x, y, z, count, fx, fy, fz, features, f1, f2); break;
+        case SSE42: done = nearestFeaturesSSE42(x, y, z, count, fx, fy, fz, features, f1, f2); break;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    nearestFeaturesScalar(x, y, z, done, count, fx, fy, fz, features, f1, f2);
+}
+
+void fixedPointRow8(Level level, const short* t, const short* gx, const short* k, int corners, int fy, int fz, const unsigned short* dither, unsigned char* out, int count) {
+    int done = 0;
+#ifdef PERLIN_SIMD_X86
+    switch (level) {
+        case AVX2:
+        case AVX512:
+            done = fixedRow8AVX2(t, gx, k, corners, fy, fz, dither, out, count);
+            // Runs are often shorter than 16 points, so an 8 point step is worth taking before the scalar one
+            done += fixedRow8SSE42(t + done, gx, k, corners, fy, fz, dither ? dither + done : nullptr, out + done, count - done);
+            break;
+        case SSE42: done = fixedRow8SSE42(t, gx, k, corners, fy, fz, dither, out, count); break;
+        default: break;
+    }
+#else
+    (void)level;
+#endif
+    fixedRow8Scalar(t, gx, k, corners, fy, fz, dither, out, done, count);
+}
+
+void generatePerlinNoise(Level level, const int* p, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+#ifdef PERLIN_SIMD_X86
+    switch (level) {
+        case SSE42: kernelSSE42(p, x, y, z, out, count, repeat); return;
+        case AVX2: kernelAVX2(p, x, y, z, out, count, repeat); return;
+        case AVX512: kernelAVX512(p, x, y, z, out, count, repeat); return;
+        default: break;
+    }
+#else
+    (void)level; (void)p; (void)x; (void)y; (void)z; (void)out; (void)count; (void)repeat;
+#endif
+}
+
+void generatePerlinNoise2D(Level level, const int* p, const double* x, const double* y, double* out, int count, int repeat) {
+#ifdef PERLIN_SIMD_X86
+    switch (level) {
+        case SSE42: kernel2DSSE42(p, x, y, out, count, repeat); return;
+        case AVX2: kernel2DAVX2(p, x, y, out, count, repeat); return;
+        case AVX512: kernel2DAVX512(p, x, y, out, count, repeat); return;
+        default: break;
+    }
+#else
+    (void)level; (void)p; (void)x; (void)y; (void)out; (void)count; (void)repeat;
+#endif
+}
+
+void generateHashedNoise(Level level, unsigned int seed, const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+#ifdef PERLIN_SIMD_X86
+    switch (level) {
+        case SSE42: hashedKernelSSE42(seed, x, y, z, out, count, repeat); return;
+        case AVX2: hashedKernelAVX2(seed, x, y, z, out, count, repeat); return;
+        case AVX512: hashedKernelAVX512(seed, x, y, z, out, count, repeat); return;
+        default: break;
+    }
+#else
+    (void)level; (void)seed; (void)x; (void)y; (void)z; (void)out; (void)count; (void)repeat;
+#endif
+}
+
+void generateHashedNoise2D(Level level, unsigned int seed, const double* x, const double* y, double* out, int count, int repeat) {
+#ifdef PERLIN_SIMD_X86
+    switch (level) {
+        case SSE42: hashedKernel2DSSE42(seed, x, y, out, count, repeat); return;
+        case AVX2: hashedKernel2DAVX2(seed, x, y, out, count, repeat); return;
+        case AVX512: hashedKernel2DAVX512(seed, x, y, out, count, repeat); return;
+        default: break;
+    }
+#else
+    (void)level; (void)seed; (void)x; (void)y; (void)out; (void)count; (void)repeat;
+#endif
+}
+
+}
@@ -0,0 +1,59 @@
+#ifndef PERLINSIMD_H
+#define PERLINSIMD_H
+
+// SIMD kernels for Perlin::generatePerlinNoiseBatch
+// Each kernel is a vectorized copy of Perlin::generatePerlinNoise that performs the exact same floating point operations in the same order,
+// so every kernel returns results that are bit-identical to the scalar function
+// It also holds the fixed-point kernel of Perlin::evaluateRow8, which works in 16-bit integer lanes and is likewise identical at every level,
+// and the multi-field kernel of Perlin::evaluateRowFields. The distance kernel of Worley noise lives here too, to share the level dispatch
+namespace PerlinSIMD {
+    // Instruction sets a kernel can be built for, ordered from narrowest to widest
+    enum Level { SCALAR = 0, SSE42 = 1, AVX2 = 2, AVX512 = 3 };
+
+    // Widest level supported by the CPU (and OS) we're running on, detected once
+    Level detectLevel();
+
+    // Level used by the batch functions, which is the detected level unless forceLevel() lowered it
+    Level activeLevel();
+
+    // Restricts the batch functions to the given level (clamped to the detected level), e.g. to compare kernels against each other
+    void forceLevel(Level level);
+
+    // # of points processed per kernel iteration, and a readable name, for a level
+    int laneWidth(Level level);
+    const char* levelName(Level level);
+
+    // Runs the kernel for the given level
+    // Parameters: p is the doubled permutation table; xyz are coordinates already wrapped into [0,repeat) when repeat > 0;
+    // out receives the noise values; count must be a multiple of laneWidth(level); repeat is as in Perlin::generatePerlinNoise(), at most 256
+    void generatePerlinNoise(Level level, const int* p, const double* x, const double* y, const double* z, double* out, int count, int repeat);
+
+    // Runs the 2D kernel for the given level, the vectorized copy of Perlin::generatePerlinNoise2D (same rules for the parameters)
+    void generatePerlinNoise2D(Level level, const int* p, const double* x, const double* y, double* out, int count, int repeat);
+
+    // Hashed versions of the 3D and 2D kernels, for Perlin's INTEGER_HASH lattice mode: the lattice points are hashed from seed with the
+    // integer hash of PerlinTables.h instead of the permutation table, which needs no table lookups. Same rules for the other parameters,
+    // except that any period works
+    void generateHashedNoise(Level level, unsigned int seed, const double* x, const double* y, const double* z, double* out, int count, int repeat);
+    void generateHashedNoise2D(Level level, unsigned int seed, const double* x, const double* y, double* out, int count, int repeat);
+
+    // Runs the fixed-point kernel of Perlin::evaluateRow8 for the given level, turning count prepared points that share a unit cube into 8-bit texels
+    // Unlike the other kernels, count doesn't have to be a multiple of the lane width, and every level gives identical results
+    // Parameters: t is each point's decimal x part (Q15); gx and k hold, for each corner of the cube, the x component of the corner's gradient
+    // vector and the y and z terms of its gradient dot product (Q12); corners is 8, or 4 when the far z face has no weight;
+    // fy and fz are the faded y and z weights (Q15); dither holds each point's dither threshold in [0,255] (or is null); out receives the texels
+    void fixedPointRow8(Level level, const short* t, const short* gx, const short* k, int corners, int fy, int fz, const unsigned short* dither, unsigned char* out, int count);
+
+    // Runs the multi-field kernel of Perlin::evaluateRowFields for the given level, blending count points that share a unit cube for 4 fields at once
+    // Parameters: xd and xf are each point's decimal x part and its faded weight; gx, gy and gz hold the cube constants of evaluateRow() for each
+    // corner and field, corner by corner (gx[c*4 + f]); yf and zf are the faded y and z weights; out receives 4 interleaved values per point
+    void blendFields4(Level level, const double* xd, const double* xf, const double* gx, const double* gy, const double* gz, double yf, double zf, double* out, int count);
+
+    // Runs the distance kernel of Worley::evaluateCell for the given level: the two smallest squared distances from each of count points
+    // to a set of feature points (infinity when there are fewer than two). Any count works, and every level gives identical results
+    // Parameters: xyz are the points' coordinates; fx, fy and fz are the coordinates of the features feature points; f1 and f2 receive each
+    // point's smallest and second smallest squared distance
+    void nearestFeatures(Level level, const double* x, const double* y, const double* z, int count, const double* fx, const double* fy, const double* fz, int features, double* f1, double* f2);
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PERLINTABLES_H
+#define PERLINTABLES_H
+
+// Compile-time lookup tables shared by every Perlin noise implementation
+// Being constexpr, they live in read-only storage once per program instead of being copied into each noise object
+// Also holds the integer lattice hash that can replace the permutation table, so the scalar code and the SIMD kernels share one definition
+
+// Permutation table, as defined by Ken Perlin
+// It's an array of random values from 0 - 255 inclusive, will be used in a hash function to determine gradient vector
+inline constexpr int PERLIN_PERMUTATION_BASE[256] = {
+    151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,190,
+    6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,88,237,149,56,87,174,20,125,136,
+    171,168,68,175,74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,
+    55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,200,196,135,130,116,
+    188,159,86,164,100,109,198,173,186,3,64,52,217,226,250,124,123,5,202,38,147,118,126,255,82,85,212,207,
+    206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,119,248,152,2,44,154,163,70,221,153,101,155,167,
+    43,172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,218,246,97,228,251,34,242,193,238,
+    210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,49,192,214,31,181,199,106,157,184,84,204,176,
+    115,121,50,45,127,4,150,254,138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+};
+
+// Permutation table doubled to 512 entries to avoid having to perform modulo arithmetic when indexing the array
+struct PermutationTable {
+    int values[512];
+};
+
+constexpr PermutationTable makePermutationTable() {
+    PermutationTable table = {};
+    for (int i = 0; i < 512; i++)
+        table.values[i] = PERLIN_PERMUTATION_BASE[i % 256];
+    return table;
+}
+
+inline constexpr PermutationTable PERLIN_PERMUTATION = makePermutationTable();
+
+// The 16 gradient vectors selected by the low 4 bits of a corner's hash: the 12 edges of the cube, with 4 of them repeated so the hash can be masked instead of taken mod 12
+// Dotting a vector with the point's offset gives exactly the values of Ken Perlin's original switch statement
+inline constexpr int PERLIN_GRADIENTS[16][3] = {
+    { 1, 1, 0}, {-1, 1, 0}, { 1,-1, 0}, {-1,-1, 0},
+    { 1, 0, 1}, {-1, 0, 1}, { 1, 0,-1}, {-1, 0,-1},
+    { 0, 1, 1}, { 0,-1, 1}, { 0, 1,-1}, { 0,-1,-1},
+    { 1, 1, 0}, { 0,-1, 1}, {-1, 1, 0}, { 0,-1,-1}
+};
+
+// The 32 gradient vectors used by 4D noise, selected by the low 5 bits of a corner's hash: the midpoints of the edges of a 4D hypercube
+// (every vector with one zero component and the other three components +-1)
+inline constexpr int PERLIN_GRADIENTS_4D[32][4] = {
+    { 0, 1, 1, 1}, { 0, 1, 1,-1}, { 0, 1,-1, 1}, { 0, 1,-1,-1}, { 0,-1, 1, 1}, { 0,-1, 1,-1}, { 0,-1,-1, 1}, { 0,-1,-1,-1},
+    { 1, 0, 1, 1}, { 1, 0, 1,-1}, { 1, 0,-1, 1}, { 1, 0,-1,-1}, {-1, 0, 1, 1}, {-1, 0, 1,-1}, {-1, 0,-1, 1}, {-1, 0,-1,-1},
+    { 1, 1, 0, 1}, { 1, 1, 0,-1}, { 1,-1, 0, 1}, { 1,-1, 0,-1}, {-1, 1, 0, 1}, {-1, 1, 0,-1}, {-1,-1, 0, 1}, {-1,-1, 0,-1},
+    { 1, 1, 1, 0}, { 1, 1,-1, 0}, { 1,-1, 1, 0}, { 1,-1,-1, 0}, {-1, 1, 1, 0}, {-1, 1,-1, 0}, {-1,-1, 1, 0}, {-1,-1,-1, 0}
+};
+
+// Integer lattice hash, an alternative to the permutation table hash (see Perlin::setLatticeHash)
+// It mixes a seed with the full 32-bit lattice coordinates using the multiply-rotate step and final avalanche of xxHash32, so the noise doesn't
+// repeat every 256 cells and a different seed gives an unrelated noise field. Being pure arithmetic, SIMD kernels compute it without gathers
+// A corner's hash is latticeHashFinal(latticeHashStep(latticeHashStep(latticeHashStep(latticeHashStart(seed), x), y), z)), and the gradient
+// vector is selected by its low bits exactly like a permutation table hash
+inline constexpr unsigned int LATTICE_HASH_PRIME2 = 2246822519u;
+inline constexpr unsigned int LATTICE_HASH_PRIME3 = 3266489917u;
+inline constexpr unsigned int LATTICE_HASH_PRIME4 = 668265263u;
+inline constexpr unsigned int LATTICE_HASH_PRIME5 = 374761393u;
+
+constexpr unsigned int latticeHashStart(unsigned int seed) {
+    return seed + LATTICE_HASH_PRIME5;
+}
+
+// Mixes one lattice coordinate into the hash
+constexpr unsigned int latticeHashStep(unsigned int h, unsigned int coordinate) {
+    h += coordinate * LATTICE_HASH_PRIME3;
+    return ((h << 17) | (h >> 15)) * LATTICE_HASH_PRIME4;
+}
+
+// Spreads every input bit over the low bits that select the gradient vector
+constexpr unsigned int latticeHashFinal(unsigned int h) {
+    h ^= h >> 15;
+    h *= LATTICE_HASH_PRIME2;
+    h ^= h >> 13;
+    h *= LATTICE_HASH_PRIME3;
+    h ^= h >> 16;
+    return h;
+}
+
+#endif
@@ -0,0 +1,131 @@
+#include "Simplex.h"
+#include "PerlinTables.h"
+#include <cmath>
+
+// Constructor
+// Uses the same permutation table as Perlin noise for hashing the simplex corners
+Simplex::Simplex() : p(PERLIN_PERMUTATION.values) {}
+
+// Floor function returning an int, cheaper than std::floor followed by a cast
+int Simplex::fastFloor(double val) {
+    int i = (int)val;
+    return val < i ? i - 1 : i;
+}
+
+// 3D Simplex noise function
+// Returns the noise value of the point, in range [0,1]
+// Parameters: xyz are coordinates of point in 3D space
+double Simplex::generateSimplexNoise(double x, double y, double z) {
+    // Skewing and unskewing factors for 3D: skewing the input space turns the tetrahedral simplex grid into a cube grid
+    const double F3 = 1.0/3.0;
+    const double G3 = 1.0/6.0;
+
+    // Skew the input space to find which cube the point is in, then unskew the cube's origin back to find the point's offset from it
+    double s = (x+y+z)*F3;
+    int i = fastFloor(x+s);
+    int j = fastFloor(y+s);
+    int k = fastFloor(z+s);
+    double t = (i+j+k)*G3;
+    double x0 = x-(i-t);
+    double y0 = y-(j-t);
+    double z0 = z-(k-t);
+
+    // The cube is split into 6 tetrahedra; the order of the offsets' magnitudes tells us which one the point is in,
+    // i.e. the lattice steps (i1,j1,k1) and (i2,j2,k2) from the first corner to the second and third corners
+    int i1, j1, k1, i2, j2, k2;
+    if (x0 >= y0) {
+        if (y0 >= z0)      { i1=1; j1=0; k1=0; i2=1; j2=1; k2=0; }
+        else if (x0 >= z0) { i1=1; j1=0; k1=0; i2=1; j2=0; k2=1; }
+        else               { i1=0; j1=0; k1=1; i2=1; j2=0; k2=1; }
+    }
+    else {
+        if (y0 < z0)       { i1=0; j1=0; k1=1; i2=0; j2=1; k2=1; }
+        else if (x0 < z0)  { i1=0; j1=1; k1=0; i2=0; j2=1; k2=1; }
+        else               { i1=0; j1=1; k1=0; i2=1; j2=1; k2=0; }
+    }
+
+    // Offsets of the point from the other 3 corners, in unskewed coordinates
+    double x1 = x0-i1+G3, y1 = y0-j1+G3, z1 = z0-k1+G3;
+    double x2 = x0-i2+2*G3, y2 = y0-j2+2*G3, z2 = z0-k2+2*G3;
+    double x3 = x0-1+3*G3, y3 = y0-1+3*G3, z3 = z0-1+3*G3;
+    double offsets[4][3] = { {x0,y0,z0}, {x1,y1,z1}, {x2,y2,z2}, {x3,y3,z3} };
+
+    // Hash the 4 corners to pick their gradient vectors
+    int ii = i & 255, jj = j & 255, kk = k & 255;
+    int hashes[4] = {
+        p[ii+p[jj+p[kk]]],
+        p[ii+i1+p[jj+j1+p[kk+k1]]],
+        p[ii+i2+p[jj+j2+p[kk+k2]]],
+        p[ii+1+p[jj+1+p[kk+1]]]
+    };
+
+    // Each corner contributes its gradient dotted with the offset, attenuated by a radial falloff that reaches 0 before the next simplex
+    double n = 0.0;
+    for (int c = 0; c < 4; c++) {
+        const double* d = offsets[c];
+        double falloff = 0.6 - d[0]*d[0] - d[1]*d[1] - d[2]*d[2];
+        if (falloff > 0) {
+            const int* g = PERLIN_GRADIENTS[hashes[c] & 15];
+            falloff *= falloff;
+            n += falloff*falloff*(g[0]*d[0] + g[1]*d[1] + g[2]*d[2]);
+        }
+    }
+
+    // Scale the sum to roughly [-1,1], then map it to [0,1] like the Perlin noise
+    return (32.0*n+1)/2;
+}
+
+// 4D Simplex noise function
+// Returns the noise value of the point, in range [0,1]
+// Parameters: xyzw are coordinates of point in 4D space
+double Simplex::generateSimplexNoise4D(double x, double y, double z, double w) {
+    // Skewing and unskewing factors for 4D
+    const double F4 = (std::sqrt(5.0)-1.0)/4.0;
+    const double G4 = (5.0-std::sqrt(5.0))/20.0;
+
+    // Skew to find the hypercube, unskew to find the offset from its origin
+    double s = (x+y+z+w)*F4;
+    int i = fastFloor(x+s);
+    int j = fastFloor(y+s);
+    int k = fastFloor(z+s);
+    int l = fastFloor(w+s);
+    double t = (i+j+k+l)*G4;
+    double d0[4] = { x-(i-t), y-(j-t), z-(k-t), w-(l-t) };
+
+    // The hypercube is split into 24 simplices; ranking the offsets from largest to smallest tells us which one the point is in
+    // The axis with rank 3 (largest offset) is stepped first, then the one with rank 2 and so on
+    int rank[4] = { 0, 0, 0, 0 };
+    for (int a = 0; a < 4; a++)
+        for (int b = a+1; b < 4; b++) {
+            if (d0[a] > d0[b])
+                rank[a]++;
+            else
+                rank[b]++;
+        }
+
+    // Lattice steps and offsets of all 5 corners
+    int steps[5][4];
+    double offsets[5][4];
+    for (int c = 0; c < 5; c++)
+        for (int a = 0; a < 4; a++) {
+            steps[c][a] = rank[a] >= 4-c ? 1 : 0;
+            offsets[c][a] = d0[a] - steps[c][a] + c*G4;
+        }
+
+    // Each corner contributes its gradient dotted with the offset, attenuated by a radial falloff
+    int ii = i & 255, jj = j & 255, kk = k & 255, ll = l & 255;
+    double n = 0.0;
+    for (int c = 0; c < 5; c++) {
+        const double* d = offsets[c];
+        double falloff = 0.6 - d[0]*d[0] - d[1]*d[1] - d[2]*d[2] - d[3]*d[3];
+        if (falloff > 0) {
+            int hash = p[ii+steps[c][0]+p[jj+steps[c][1]+p[kk+steps[c][2]+p[ll+steps[c][3]]]]];
+            const int* g = PERLIN_GRADIENTS_4D[hash & 31];
+            falloff *= falloff;
+            n += falloff*falloff*(g[0]*d[0] + g[1]*d[1] + g[2]*d[2] + g[3]*d[3]);
+        }
+    }
+
+    // Scale the sum to roughly [-1,1], then map it to [0,1]
+    return (27.0*n+1)/2;
+}
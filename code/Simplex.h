@@ -0,0 +1,32 @@
+#ifndef SIMPLEX_H
+#define SIMPLEX_H
+#include "NoiseSource.h"
+
+// A class for generating Simplex noise (Ken Perlin's successor to Perlin noise, in the formulation of Stefan Gustavson's "Simplex noise demystified")
+// Instead of the 2^n corners of a hypercube, each point is influenced by the n+1 corners of the simplex it lies in: 4 corners in 3D and 5 in 4D,
+// so the cost grows linearly with dimension rather than exponentially, and the noise has fewer axis-aligned artifacts
+// Simplex noise has no lattice tiling, so the repeat parameter is ignored
+class Simplex : public NoiseSource {
+    public:
+        // Constructor
+        Simplex();
+
+        // Methods
+        double generateSimplexNoise(double x, double y, double z);
+        double generateSimplexNoise4D(double x, double y, double z, double w);
+
+        // NoiseSource interface
+        const char* name() override { return "Simplex"; }
+        bool tiles() override { return false; }
+        double generateNoise(double x, double y, double z, int repeat) override { (void)repeat; return generateSimplexNoise(x, y, z); }
+        double generateNoise4D(double x, double y, double z, double w, int repeat) override { (void)repeat; return generateSimplexNoise4D(x, y, z, w); }
+
+    private:
+        // Helper methods
+        int fastFloor(double val);
+
+        // Instance variables
+        const int* p;  // Doubled permutation table (points at PERLIN_PERMUTATION)
+};
+
+#endif
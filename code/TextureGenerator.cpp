@@ -1,50 +1,782 @@
 #include "TextureGenerator.h"
+#include "NoiseCache.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTURE_SSE2
+#endif
 
 // Generates the Perlin noise texture a Perlin noise texture based on specified # of octaves
-unsigned char* TextureGenerator::generatePerlinTexture(const int textureWidth, const int textureHeight, const int octaves) {
-    // To access Perlin noise methods
-    Perlin* perlin = new Perlin;
-    
+// The noise comes from the generator's noise source, which is Perlin noise unless setNoiseSource() chose another algorithm
+void TextureGenerator::generatePerlinTexture(const int textureWidth, const int textureHeight, const int octaves, TextureImage& image) {
     // Denotes the degree by which the amplitude changes between octaves
     double persistence = 1;  
 
     // Pointer to the texture data (texture size * 4 for alpha channel, in case we want transparency)
-    unsigned char* textureData = new unsigned char[textureWidth * textureHeight * 4]; 
+    unsigned char* textureData = prepareImage(image, (size_t)textureWidth * textureHeight * 4);
 
-    // For incrementing textureData index
-    int count = 0; 
+    // Iterate over each row of pixels in texture map, in bands of rows spread over the thread pool (see generateRowBands())
+    // The texture is the z = 0 plane of the noise, and a whole row is evaluated at once so that the noise source can share work between pixels
+    // (Perlin noise uses its 2D kernel, which gives the same values at about half the cost, and hashes each lattice cell once)
+    generateRowBands(textureHeight, textureWidth, 4, [&](int firstRow, int lastRow) {
+        // Noise values of one row of pixels
+        std::vector<double> noiseValues(textureWidth);
 
-    // Iterate over each pixel in texture map, generating a noise value for each point 
-    for (int i = 0; i < textureWidth; i++) {
-        for (int j = 0; j < textureHeight; j++) {
-            // Compute x and y values of the point
-            double x = (double)j / textureWidth * octaves;
+        for (int i = firstRow; i < lastRow; i++) {
+            // Compute the Perlin noise values for this row: y is fixed, x steps by octaves / textureWidth from pixel to pixel
             double y = (double)i / textureHeight * octaves;
+            noise->evaluateRow2D(y, 0.0, (double)octaves / textureWidth, textureWidth, noiseValues.data(), octaves);
+
+            // For incrementing textureData index, from the first pixel of the row
+            size_t count = (size_t)i * textureWidth * 4;
+
+            for (int j = 0; j < textureWidth; j++) {
+                // Store the color of this pixel based on the noise value in the textureData array
+                int colorValue = (int)(noiseValues[j] * 255);
+
+                textureData[count] = colorValue;
+                textureData[count + 1] = colorValue;
+                textureData[count + 2] = colorValue;
+                textureData[count + 3] = 0.0;
+
+                // Increment by 4 to account for r,g,b,a values
+                count = count + 4;
+            }
+        }
+    });
+}
+
+// Generates an approximation of generatePerlinTexture() whose values are guaranteed to be within maxError of the exact noise
+// Within a lattice cell, noise is a smooth blend of its corners, so at low octave counts neighbouring pixels are highly redundant: the exact noise
+// is only evaluated on a coarse grid of every step-th pixel (plus a border of one coarse sample), and the pixels in between are reconstructed with
+// bicubic (Catmull-Rom) interpolation, first along the coarse rows and then down the columns
+// Catmull-Rom interpolation reproduces quadratics, so with samples h noise cells apart its error is at most CATMULL_ROM_ERROR * h^3 times the
+// largest third derivative of the noise along the interpolated axis, and the column pass scales the error of the row pass by at most
+// CATMULL_ROM_GAIN. With the noise source's bound on its third derivatives (NoiseSource::thirdDerivativeBound2D()), that gives the coarsest
+// step whose error is within maxError at every pixel, without evaluating any exact rows to check it. Noise without such a bound, or a step
+// below MIN_STEP pixels, where the interpolation no longer beats the noise row functions, is generated exactly
+// Both passes run in bands of rows on the thread pool, like generatePerlinTexture()
+// Parameters: textureWidth, textureHeight and octaves as in generatePerlinTexture(); maxError is the largest allowed difference from the exact noise
+// values (in [0,1], e.g. 1/255 for one 8-bit step); errorBound receives the bound on the difference (0 when generated exactly), if not null
+void TextureGenerator::generateApproximateTexture(const int textureWidth, const int textureHeight, const int octaves, const double maxError, double* errorBound, TextureImage& image) {
+    // Spacing between pixels in noise cells, as in generatePerlinTexture()
+    const double dx = (double)octaves / textureWidth;
+    const double dy = (double)octaves / textureHeight;
+
+    // Bound on the interpolation error of a step of one pixel, which grows with the cube of the step
+    const double unitError = CATMULL_ROM_ERROR * noise->thirdDerivativeBound2D() * (dy * dy * dy + CATMULL_ROM_GAIN * dx * dx * dx);
+    int step = maxError > 0 && std::isfinite(unitError) ? (int)cbrt(maxError / unitError) : 0;
+    while (step > 0 && unitError * step * step * step > maxError)
+        step--;
+
+    // At a step of 4 pixels the interpolation is about 3 times as fast as the 2D row kernels on the same threads; below that the gain shrinks
+    // (1.6 times at 2) while the buffer of interpolated coarse rows grows to several times the size of the texture
+    const int MIN_STEP = 4;
+    if (step < MIN_STEP) {
+        if (errorBound)
+            *errorBound = 0.0;
+        generatePerlinTexture(textureWidth, textureHeight, octaves, image);
+        return;
+    }
+
+    // Coarse samples m = 0, 1, ... sit at pixel (m-1)*step along each axis, enough to cover every pixel's 4 sample stencil
+    const int coarseWidth = (textureWidth - 1) / step + 4;
+    const int coarseHeight = (textureHeight - 1) / step + 4;
+
+    // Catmull-Rom weights of each pixel column
+    std::vector<double> weights((size_t)textureWidth * 4);
+    for (int j = 0; j < textureWidth; j++)
+        catmullRomWeights((double)(j % step) / step, &weights[(size_t)j * 4]);
+
+    // The coarse rows interpolated along x to every pixel column
+    std::vector<double> rows((size_t)coarseHeight * textureWidth);
+    double seconds = generateRowBands(coarseHeight, textureWidth, sizeof(double), [&](int firstRow, int lastRow) {
+        std::vector<double> coarse(coarseWidth);
+        for (int m = firstRow; m < lastRow; m++) {
+            noise->evaluateRow2D((double)((m - 1) * step) / textureHeight * octaves, -step * dx, step * dx, coarseWidth, coarse.data(), octaves);
+            double* row = &rows[(size_t)m * textureWidth];
+            for (int j = 0; j < textureWidth; j++) {
+                const double* w = &weights[(size_t)j * 4];
+                const double* v = &coarse[j / step];
+                row[j] = w[0] * v[0] + w[1] * v[1] + w[2] * v[2] + w[3] * v[3];
+            }
+        }
+    });
+
+    // Pixel rows interpolated down the columns of the x-interpolated coarse rows, laid out like generatePerlinTexture()'s
+    unsigned char* textureData = prepareImage(image, (size_t)textureWidth * textureHeight * 4);
+    seconds += generateRowBands(textureHeight, textureWidth, 4, [&](int firstRow, int lastRow) {
+        for (int i = firstRow; i < lastRow; i++) {
+            double w[4];
+            catmullRomWeights((double)(i % step) / step, w);
+            const double* r0 = &rows[(size_t)(i / step) * textureWidth];
+            const double* r1 = r0 + textureWidth;
+            const double* r2 = r1 + textureWidth;
+            const double* r3 = r2 + textureWidth;
+
+            unsigned char* texel = textureData + (size_t)i * textureWidth * 4;
+            for (int j = 0; j < textureWidth; j++, texel += 4) {
+                // Catmull-Rom can overshoot the samples slightly, so the value is clamped to the noise's range
+                double value = w[0] * r0[j] + w[1] * r1[j] + w[2] * r2[j] + w[3] * r3[j];
+                int colorValue = (int)(std::clamp(value, 0.0, 1.0) * 255);
+                texel[0] = texel[1] = texel[2] = colorValue;
+                texel[3] = 0;
+            }
+        }
+    });
+    texelRate = seconds > 0.0 ? (double)textureWidth * textureHeight / seconds / 1.0e6 : 0.0;
+
+    if (errorBound)
+        *errorBound = unitError * step * step * step;
+}
+
+// Generates a tileable noise texture, or volume when textureDepth > 1, that repeats seamlessly with GL_REPEAT
+// The noise is periodic with exactly period lattice cells across each axis of the texture, so the last texel of a row joins up with the first
+// one of the next tile. A small power-of-two tile (e.g. 128x128x128, or 256x256 for a single layer) repeated over the scene then looks the same
+// as a much larger texture, without seams, at a fraction of the memory
+// Tiling needs a noise source that supports it (see NoiseSource::tiles(); Perlin noise does, Simplex noise ignores the period)
+// Each texel holds the noise value in all of r,g,b,a, so it can be sampled through any channel
+// Parameters: textureWidth, textureHeight and textureDepth should be powers of two so the tile mipmaps cleanly; period is the # of noise cells across the tile
+void TextureGenerator::generateTileableTexture(const int textureWidth, const int textureHeight, const int textureDepth, const int period, TextureImage& image) {
+    // Pointer to the texture data
+    unsigned char* textureData = prepareImage(image, (size_t)textureWidth * textureHeight * textureDepth * 4);
+
+    // x coordinates of one row of texels, shared by every row
+    // Texel i sits at i / textureWidth * period, so texel textureWidth (the first texel of the next tile) would sit at exactly one period
+    std::vector<double> x(textureWidth);
+    for (int i = 0; i < textureWidth; i++)
+        x[i] = (double)i / textureWidth * period;
+
+    // Iterate over each row of each layer of the volume, where row r is row r % textureHeight of layer r / textureHeight, in bands on the thread pool
+    generateRowBands(textureHeight * textureDepth, textureWidth, 4, [&](int firstRow, int lastRow) {
+        // Coordinates and noise values of one row of texels
+        std::vector<double> y(textureWidth), z(textureWidth), noiseValues(textureWidth);
+
+        for (int row = firstRow; row < lastRow; row++) {
+            int j = row % textureHeight;
+            int k = row / textureHeight;
+            double rowY = (double)j / textureHeight * period;
+
+            // For incrementing textureData index, from the first texel of the row
+            size_t count = (size_t)row * textureWidth * 4;
+
+            // The default Perlin source writes 8-bit texels straight from its fixed-point row function, several times faster than
+            // evaluating doubles and converting them (texels are at most 1 away from the double path, see Perlin::evaluateRow8)
+            if (noise == &perlin) {
+                perlin.evaluateRow8(rowY, (double)k / textureDepth * period, 0.0, (double)period / textureWidth, textureWidth,
+                                    textureData + count, 4, period, Perlin::NO_DITHER);
+                for (int i = 0; i < textureWidth; i++, count += 4)
+                    textureData[count + 1] = textureData[count + 2] = textureData[count + 3] = textureData[count];
+                continue;
+            }
+
+            // A single layer is the z = 0 plane, which has a faster row function
+            if (textureDepth == 1) {
+                noise->evaluateRow2D(rowY, 0.0, (double)period / textureWidth, textureWidth, noiseValues.data(), period);
+            }
+            else {
+                std::fill(y.begin(), y.end(), rowY);
+                std::fill(z.begin(), z.end(), (double)k / textureDepth * period);
+                noise->generateNoiseBatch(x.data(), y.data(), z.data(), noiseValues.data(), textureWidth, period);
+            }
+
+            for (int i = 0; i < textureWidth; i++) {
+                unsigned char colorValue = (unsigned char)(noiseValues[i] * 255);
+
+                textureData[count] = colorValue;
+                textureData[count + 1] = colorValue;
+                textureData[count + 2] = colorValue;
+                textureData[count + 3] = colorValue;
+
+                // Increment by 4 to account for r,g,b,a values
+                count = count + 4;
+            }
+        }
+    });
+}
+
+// Generates a tileable texture, or volume when textureDepth > 1, holding four noise fields in its r, g, b and a channels
+// All four fields are evaluated in one pass over the texels, so the row setup and texel writes are shared, and each texel is written once
+// (rather than baking four textures and keeping one channel of each). Texture coordinates run over [0,1) across the tile, so a field
+// with frequency and repeat both equal to n has n noise cells across the tile and tiles seamlessly, like generateTileableTexture(n)
+// Parameters: textureWidth, textureHeight and textureDepth as in generateTileableTexture(); fields are the 4 fields, in channel order
+void TextureGenerator::generateTileableFieldTexture(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields, TextureImage& image) {
+    // Pointer to the texture data
+    unsigned char* textureData = prepareImage(image, (size_t)textureWidth * textureHeight * textureDepth * 4);
+
+    generateFieldLayers(textureData, textureWidth, textureHeight, textureDepth, fields, 4, 0, textureDepth, nullptr, nullptr);
+}
+
+// Streams a tileable volume holding fieldCount noise fields, one per channel, to slab a few layers at a time
+// With 4 fields the texels are laid out like generateTileableFieldTexture()'s (GL_RGBA data); with 1 field each texel is a single byte (GL_RED data,
+// e.g. for a GL_R8 volume when only one layer is needed, a quarter of the memory of RGBA), and likewise for 2 or 3
+// The layers are generated into one staging buffer of at most stagingBytes (but always at least one layer), which is handed to slab as soon as
+// each slab of layers is done and then reused for the next one, so the memory needed stays the same however deep the volume is
+// (a 256^3 RGBA volume would otherwise be a 64 MB allocation), and the buffer itself comes from the texture pool, so regenerating the volume reuses it. slab typically uploads the layers with glTexSubImage3D, which copies them out
+// before returning, so it mustn't hold on to the pointer. The texel rate covers the generation of the whole volume, not the slab calls
+// Parameters: textureWidth, textureHeight, textureDepth and fields as in generateTileableFieldTexture(); fieldCount is # of fields (1 to 4);
+// stagingBytes is the size limit of the staging buffer; slab is called on the calling thread with each slab's first layer, # of layers and texels
+void TextureGenerator::streamTileableFieldVolume(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                                 const int fieldCount, const size_t stagingBytes, const SlabCallback& slab) {
+    const size_t layerBytes = (size_t)textureWidth * textureHeight * fieldCount;
+    const int slabDepth = std::clamp((int)(stagingBytes / layerBytes), 1, textureDepth);
+    TextureImage staging = (images ? *images : TexturePool::shared()).acquire(layerBytes * slabDepth);
+
+    double seconds = 0.0;
+    for (int firstLayer = 0; firstLayer < textureDepth && !(cancel && *cancel); firstLayer += slabDepth) {
+        const int layerCount = std::min(slabDepth, textureDepth - firstLayer);
+        seconds += generateFieldLayers(staging.data(), textureWidth, textureHeight, textureDepth, fields, fieldCount, firstLayer, layerCount, nullptr, nullptr);
+        slab(firstLayer, layerCount, staging.data());
+    }
+    texelRate = seconds > 0.0 ? (double)textureWidth * textureHeight * textureDepth / seconds / 1.0e6 : 0.0;
+}
+
+// Streams the whole mip chain of the volume streamTileableFieldVolume() would produce, level by level, to slab
+// Level 0 is streamed a slab at a time exactly as by streamTileableFieldVolume(), and each lower level is handed to slab whole once it's built
+// (it's at most an eighth of the level above, so the chain adds little to the staging memory), replacing glGenerateMipmap() with filters
+// that run on the thread pool:
+// - BOX_MIPS averages each 2x2x2 block of texels of the level above (2x2 or 2 once an axis is down to 1 texel). Level 1 is built from
+//   each slab of level 0 as it streams past, so level 0 is never held in memory
+// - KAISER_MIPS filters the level above with a separable Kaiser-windowed sinc (2 * KAISER_RADIUS taps per axis, wrapping around the tile),
+//   which keeps the noise's contrast where the box filter blurs it and cuts off what the lower level can't hold where the box filter lets it
+//   alias. Its taps reach across slabs (and around the tile), so level 0 is kept in memory while it streams
+// - PROCEDURAL_MIPS generates each level straight from the noise, sampling each texel at the center of the block of level 0 texels it covers,
+//   and leaves out each field with more noise cells than half the level's texels along an axis (above its Nyquist limit, where it would
+//   only alias), setting its channel to its mean over the level above instead, which is what filtering it would converge to. The mean of
+//   fields left out at level 1 is taken from level 0 as it streams
+// The box and Kaiser filters halve each axis, so they need power-of-two dimensions (as the tiles have anyway)
+// Parameters: as in streamTileableFieldVolume(); filter picks how the levels below level 0 are built; slab is called on the calling thread
+// with the level, the first layer, # of layers and texels of each slab, in order of level and then layer
+void TextureGenerator::streamTileableFieldMips(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                               const int fieldCount, const size_t stagingBytes, const MipFilter filter, const MipSlabCallback& slab) {
+    TexturePool& texturePool = images ? *images : TexturePool::shared();
+    const int levelCount = mipLevelCount(textureWidth, textureHeight, textureDepth);
+    const size_t layerBytes = (size_t)textureWidth * textureHeight * fieldCount;
+
+    bool meansOfLevel0 = false;
+    for (int f = 0; f < fieldCount && filter == PROCEDURAL_MIPS && levelCount > 1; f++)
+        meansOfLevel0 |= aboveNyquist(fields[f], textureWidth, textureHeight, textureDepth, 1);
+
+    // Level 1 (box filter), level 0 (Kaiser filter) or the channel sums of level 0 (procedural, when needed) are taken from the slabs of level 0
+    // Box filtering a slab on its own needs whole pairs of layers, so the staging buffer holds an even # of layers
+    TextureImage level1, level0;
+    std::vector<double> sums(fieldCount, 0.0);
+    if (filter == BOX_MIPS && levelCount > 1)
+        level1 = texturePool.acquire((size_t)mipSize(textureWidth, 1) * mipSize(textureHeight, 1) * mipSize(textureDepth, 1) * fieldCount);
+    if (filter == KAISER_MIPS && levelCount > 1)
+        level0 = texturePool.acquire(layerBytes * textureDepth);
+    const size_t slabBytes = textureDepth > 1 ? std::max<size_t>(2, stagingBytes / layerBytes / 2 * 2) * layerBytes : stagingBytes;
+
+    streamTileableFieldVolume(textureWidth, textureHeight, textureDepth, fields, fieldCount, slabBytes,
+        [&](int firstLayer, int layerCount, const unsigned char* texels) {
+            slab(0, firstLayer, layerCount, texels);
+            if (!level1.empty()) {
+                const int layerStep = textureDepth > 1 ? 2 : 1;
+                boxDownsample(texels, textureWidth, textureHeight, layerCount, fieldCount,
+                              level1.data() + (size_t)firstLayer / layerStep * mipSize(textureWidth, 1) * mipSize(textureHeight, 1) * fieldCount,
+                              mipSize(textureWidth, 1), mipSize(textureHeight, 1), layerCount / layerStep);
+            }
+            if (!level0.empty())
+                memcpy(level0.data() + firstLayer * layerBytes, texels, layerBytes * layerCount);
+            if (meansOfLevel0) {
+                for (size_t i = 0; i < layerBytes * layerCount; i++)
+                    sums[i % fieldCount] += texels[i];
+            }
+        });
+    const double level0Rate = texelRate;
+
+    // Each lower level is built from the one above it
+    TextureImage above = filter == BOX_MIPS ? std::move(level1) : std::move(level0);
+    double aboveTexels = (double)textureWidth * textureHeight * textureDepth;
+    std::vector<int> dropValues(fieldCount);
+    for (int level = 1; level < levelCount && !(cancel && *cancel); level++) {
+        const int width = mipSize(textureWidth, level), height = mipSize(textureHeight, level), depth = mipSize(textureDepth, level);
+        const size_t levelBytes = (size_t)width * height * depth * fieldCount;
+
+        // Level 1 of the box filter is already built
+        if (filter == BOX_MIPS && level == 1) {
+            slab(level, 0, depth, above.data());
+            continue;
+        }
+
+        TextureImage current = texturePool.acquire(levelBytes);
+        if (filter == BOX_MIPS) {
+            boxDownsample(above.data(), mipSize(textureWidth, level - 1), mipSize(textureHeight, level - 1), mipSize(textureDepth, level - 1), fieldCount,
+                          current.data(), width, height, depth);
+        }
+        else if (filter == KAISER_MIPS) {
+            kaiserDownsample(above.data(), mipSize(textureWidth, level - 1), mipSize(textureHeight, level - 1), mipSize(textureDepth, level - 1), fieldCount,
+                             current.data());
+        }
+        else {
+            if (level > 1) {
+                std::fill(sums.begin(), sums.end(), 0.0);
+                for (size_t i = 0; i < above.getSize(); i++)
+                    sums[i % fieldCount] += above.data()[i];
+            }
+            for (int f = 0; f < fieldCount; f++)
+                dropValues[f] = aboveNyquist(fields[f], textureWidth, textureHeight, textureDepth, level) ? (int)(sums[f] / aboveTexels + 0.5) : -1;
+
+            // Texel i of this level covers level 0 texels [i * b, (i + 1) * b) along an axis halved to a block of b texels, centered 0.5 - 0.5 / b
+            // of its texel past i (b is 2^level until the axis is down to 1 texel, and stays 1 along an axis that was a single texel to begin with)
+            const double shifts[3] = { mipTexelShift(textureWidth, level), mipTexelShift(textureHeight, level), mipTexelShift(textureDepth, level) };
+            generateFieldLayers(current.data(), width, height, depth, fields, fieldCount, 0, depth, shifts, dropValues.data());
+        }
+        slab(level, 0, depth, current.data());
+        above = std::move(current);
+        aboveTexels = (double)width * height * depth;
+    }
+    texelRate = level0Rate;
+}
+
+// Streams levels firstLevel and below of the chain streamTileableFieldMips() builds with PROCEDURAL_MIPS, each level whole, without generating
+// the levels above, e.g. for a quick preview of a large volume whose cost doesn't depend on the volume's size
+// The levels are the same as that chain's except for the fields left out of firstLevel itself, which are set to their mean over firstLevel
+// (sampled before they're left out) rather than over the level above, as that level isn't generated
+// Parameters: as in streamTileableFieldMips(); firstLevel is the first level streamed; slab is called with the level (numbered as in the whole
+// chain), 0, # of layers of the level and its texels, in order of level
+void TextureGenerator::streamProceduralMips(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                            const int fieldCount, const int firstLevel, const MipSlabCallback& slab) {
+    TexturePool& texturePool = images ? *images : TexturePool::shared();
+    const int levelCount = mipLevelCount(textureWidth, textureHeight, textureDepth);
+
+    TextureImage above;
+    double aboveTexels = 0.0;
+    std::vector<double> sums(fieldCount);
+    std::vector<int> dropValues(fieldCount);
+    double seconds = 0.0, texels = 0.0;
+    for (int level = firstLevel; level < levelCount && !(cancel && *cancel); level++) {
+        const int width = mipSize(textureWidth, level), height = mipSize(textureHeight, level), depth = mipSize(textureDepth, level);
+        const size_t levelBytes = (size_t)width * height * depth * fieldCount;
+        const double shifts[3] = { mipTexelShift(textureWidth, level), mipTexelShift(textureHeight, level), mipTexelShift(textureDepth, level) };
+        TextureImage current = texturePool.acquire(levelBytes);
+
+        // The first level is generated with every field, and its own channel sums stand in for those of the level above
+        if (level == firstLevel) {
+            seconds += generateFieldLayers(current.data(), width, height, depth, fields, fieldCount, 0, depth, shifts, nullptr);
+            aboveTexels = (double)width * height * depth;
+        }
+        const TextureImage& sampled = level == firstLevel ? current : above;
+        std::fill(sums.begin(), sums.end(), 0.0);
+        for (size_t i = 0; i < sampled.getSize(); i++)
+            sums[i % fieldCount] += sampled.data()[i];
+        for (int f = 0; f < fieldCount; f++)
+            dropValues[f] = aboveNyquist(fields[f], textureWidth, textureHeight, textureDepth, level) ? (int)(sums[f] / aboveTexels + 0.5) : -1;
+
+        if (level == firstLevel) {
+            for (int f = 0; f < fieldCount; f++)
+                if (dropValues[f] >= 0)
+                    for (size_t i = f; i < levelBytes; i += fieldCount)
+                        current.data()[i] = (unsigned char)dropValues[f];
+        }
+        else {
+            seconds += generateFieldLayers(current.data(), width, height, depth, fields, fieldCount, 0, depth, shifts, dropValues.data());
+        }
+        texels += (double)width * height * depth;
+
+        slab(level, 0, depth, current.data());
+        above = std::move(current);
+        aboveTexels = (double)width * height * depth;
+    }
+    texelRate = seconds > 0.0 ? texels / seconds / 1.0e6 : 0.0;
+}
+
+// Whether a field has too many noise cells for mip level level of a volume, along any axis that isn't a single texel at level 0 (which doesn't vary)
+bool TextureGenerator::aboveNyquist(const NoiseField& field, const int textureWidth, const int textureHeight, const int textureDepth, const int level) {
+    const int sizes[3] = { textureWidth, textureHeight, textureDepth };
+    for (int size : sizes)
+        if (size > 1 && 2 * field.frequency > mipSize(size, level))
+            return true;
+    return false;
+}
+
+// Sums rowCount rows of bytes into 16-bit sums, 16 bytes at a time with SSE2 where available
+static void sumRows(const unsigned char* const* rows, int rowCount, int bytes, unsigned short* sums) {
+    int i = 0;
+#ifdef TEXTURE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i low = zero, high = zero;
+        for (int r = 0; r < rowCount; r++) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(rows[r] + i));
+            low = _mm_add_epi16(low, _mm_unpacklo_epi8(v, zero));
+            high = _mm_add_epi16(high, _mm_unpackhi_epi8(v, zero));
+        }
+        _mm_storeu_si128((__m128i*)(sums + i), low);
+        _mm_storeu_si128((__m128i*)(sums + i + 8), high);
+    }
+#endif
+    for (; i < bytes; i++) {
+        unsigned int sum = 0;
+        for (int r = 0; r < rowCount; r++)
+            sum += rows[r][i];
+        sums[i] = (unsigned short)sum;
+    }
+}
+
+// Box filters sourceLayers layers of a level into layers layers of the level below, in bands of rows on the thread pool: each texel is the
+// rounded average of the 2 (or 1, along an axis that isn't halved) source texels along each axis that it covers
+// The rows of each block are first summed a whole row at a time (with SIMD), then neighbouring texels of the sums are added together
+// Parameters: source and its dimensions; channels is # of bytes per texel; destination and its dimensions, each 1 or half the source's
+void TextureGenerator::boxDownsample(const unsigned char* source, const int sourceWidth, const int sourceHeight, const int sourceLayers, const int channels,
+                                     unsigned char* destination, const int width, const int height, const int layers) {
+    const int fx = sourceWidth / width, fy = sourceHeight / height, fz = sourceLayers / layers;
+    const int count = fx * fy * fz;
+    const size_t sourceRow = (size_t)sourceWidth * channels;
+
+    generateRowBands(height * layers, width, channels, [&](int firstRow, int lastRow) {
+        std::vector<unsigned short> sums(sourceRow);
+        for (int row = firstRow; row < lastRow; row++) {
+            const int j = row % height, k = row / height;
+            const unsigned char* rows[4];
+            int rowCount = 0;
+            for (int z = 0; z < fz; z++)
+                for (int y = 0; y < fy; y++)
+                    rows[rowCount++] = source + ((size_t)(k * fz + z) * sourceHeight + j * fy + y) * sourceRow;
+            sumRows(rows, rowCount, (int)sourceRow, sums.data());
+
+            unsigned char* out = destination + (size_t)row * width * channels;
+            for (int i = 0; i < width; i++) {
+                for (int c = 0; c < channels; c++) {
+                    unsigned int sum = sums[(size_t)i * fx * channels + c];
+                    if (fx == 2)
+                        sum += sums[((size_t)i * 2 + 1) * channels + c];
+                    out[(size_t)i * channels + c] = (unsigned char)((sum + count / 2) / count);
+                }
+            }
+        }
+    });
+}
+
+// Taps of the Kaiser mip filter: a sinc cut off at half the source's sample rate, shaped by a Kaiser window of half-width KAISER_RADIUS source
+// texels, at the source texels from KAISER_RADIUS - 1 before to KAISER_RADIUS after the first of the pair a destination texel is centered on
+// (so at offsets of +-0.5, +-1.5, ... from its center), normalized to add up to 1
+static const std::array<float, 2 * TextureGenerator::KAISER_RADIUS>& kaiserTaps() {
+    static const std::array<float, 2 * TextureGenerator::KAISER_RADIUS> taps = [] {
+        // Zeroth order modified Bessel function of the first kind, by its power series
+        auto bessel = [](double x) {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; k++) {
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+            }
+            return sum;
+        };
+        const double PI = 3.14159265358979323846;
+        const int RADIUS = TextureGenerator::KAISER_RADIUS;
+        std::array<double, 2 * RADIUS> weights;
+        double total = 0.0;
+        for (int t = 0; t < 2 * RADIUS; t++) {
+            double offset = t - RADIUS + 0.5;
+            double x = PI * offset / 2;
+            double ratio = offset / RADIUS;
+            weights[t] = std::sin(x) / x * bessel(TextureGenerator::KAISER_ALPHA * std::sqrt(1.0 - ratio * ratio));
+            total += weights[t];
+        }
+        std::array<float, 2 * RADIUS> normalized;
+        for (int t = 0; t < 2 * RADIUS; t++)
+            normalized[t] = (float)(weights[t] / total);
+        return normalized;
+    }();
+    return taps;
+}
+
+// Filters a level with the Kaiser mip filter into the level below, one axis at a time (each axis that is halved), wrapping around the tile
+// The intermediate levels are kept as floats, so the texels are only rounded once, and clamped since the filter's negative lobes can overshoot
+// Parameters: source and its dimensions; channels is # of bytes per texel; destination receives the level below
+void TextureGenerator::kaiserDownsample(const unsigned char* source, const int sourceWidth, const int sourceHeight, const int sourceDepth, const int channels,
+                                        unsigned char* destination) {
+    TexturePool& texturePool = images ? *images : TexturePool::shared();
+    int dimensions[3] = { sourceWidth, sourceHeight, sourceDepth };
+    TextureImage filtered[2];     // The last two passes' output, so each pass reads one and writes the other
+    const float* current = nullptr;
+    int next = 0;
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (dimensions[axis] < 2)
+            continue;
+        const int outer = axis == 0 ? dimensions[1] * dimensions[2] : axis == 1 ? dimensions[2] : 1;
+        const int inner = channels * (axis == 0 ? 1 : axis == 1 ? dimensions[0] : dimensions[0] * dimensions[1]);
+        const int length = dimensions[axis];
+
+        TextureImage& output = filtered[next];
+        next ^= 1;
+        output = texturePool.acquire((size_t)outer * (length / 2) * inner * sizeof(float));
+        if (current)
+            kaiserAxis(current, outer, length, inner, output.as<float>());
+        else
+            kaiserAxis(source, outer, length, inner, output.as<float>());
+        current = output.as<float>();
+        dimensions[axis] = length / 2;
+    }
+
+    const size_t bytes = (size_t)dimensions[0] * dimensions[1] * dimensions[2] * channels;
+    for (size_t i = 0; i < bytes; i++)
+        destination[i] = (unsigned char)std::clamp(current[i] + 0.5f, 0.0f, 255.0f);
+}
+
+// Filters source along one axis with the Kaiser taps, halving it: source is outer blocks of length slices along the axis, each inner values long,
+// and destination gets outer blocks of length / 2 slices. Runs in bands of slices on the thread pool
+template <typename T>
+void TextureGenerator::kaiserAxis(const T* source, const int outer, const int length, const int inner, float* destination) {
+    const float* taps = kaiserTaps().data();
+    const int TAPS = 2 * KAISER_RADIUS;
+    const int half = length / 2;
+
+    generateRowBands(outer * half, inner, sizeof(float), [&](int firstSlice, int lastSlice) {
+        for (int slice = firstSlice; slice < lastSlice; slice++) {
+            const int o = slice / half, i = slice % half;
+            float* out = destination + (size_t)slice * inner;
+            std::fill(out, out + inner, 0.0f);
+            for (int t = 0; t < TAPS; t++) {
+                // Source slices around 2i and 2i + 1, wrapping around the tile (length is a power of two)
+                const int s = (2 * i + t - TAPS / 2 + 1) & (length - 1);
+                const T* in = source + ((size_t)o * length + s) * inner;
+                const float weight = taps[t];
+                for (int n = 0; n < inner; n++)
+                    out[n] += weight * in[n];
+            }
+        }
+    });
+}
+
+// Streams a volume like streamTileableFieldVolume() and block compresses it as a stack of 2D layers with their own mip chains (halving width
+// and height only, down to 1x1), for a 2D array texture: OpenGL has no 3D textures in the BC4/BC5 formats, so the layers are blended by the shader
+// The fields are compressed in pairs, BC5 for two fields (channels 2 * part and 2 * part + 1) and BC4 for a last field on its own, so 4 fields
+// take 1 byte per texel instead of 4, and 1 field half a byte instead of 1
+// Each slab of layers is box filtered down the mip chain (see boxDownsample()) and compressed as it streams past, so the uncompressed volume is
+// never held in memory, only the compressed one. Once the whole volume is done, part is called with each part's levels in order
+// Parameters: as in streamTileableFieldVolume(); compressor encodes the blocks, at its quality; part receives the blocks of each part and level
+void TextureGenerator::compressTileableFieldLayers(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                                   const int fieldCount, const size_t stagingBytes, BlockCompressor& compressor, const CompressedCallback& part) {
+    TexturePool& texturePool = images ? *images : TexturePool::shared();
+    const int levelCount = mipLevelCount(textureWidth, textureHeight, 1);
+    const int partCount = (fieldCount + 1) / 2;
+
+    // The compressed levels of each part, and the two most recent levels of the current slab
+    std::vector<TextureImage> compressed((size_t)partCount * levelCount);
+    for (int p = 0; p < partCount; p++) {
+        for (int level = 0; level < levelCount; level++) {
+            const size_t layerBytes = BlockCompressor::compressedBytes(mipSize(textureWidth, level), mipSize(textureHeight, level), std::min(2, fieldCount - 2 * p));
+            compressed[(size_t)p * levelCount + level] = texturePool.acquire(layerBytes * textureDepth);
+        }
+    }
+    TextureImage filtered[2];
+
+    streamTileableFieldVolume(textureWidth, textureHeight, textureDepth, fields, fieldCount, stagingBytes,
+        [&](int firstLayer, int layerCount, const unsigned char* texels) {
+            const unsigned char* levelTexels = texels;
+            for (int level = 0; level < levelCount; level++) {
+                const int width = mipSize(textureWidth, level), height = mipSize(textureHeight, level);
+                if (level > 0) {
+                    TextureImage& output = filtered[level & 1];
+                    const size_t bytes = (size_t)width * height * layerCount * fieldCount;
+                    if (output.getSize() < bytes)
+                        output = texturePool.acquire(bytes);
+                    boxDownsample(levelTexels, mipSize(textureWidth, level - 1), mipSize(textureHeight, level - 1), layerCount, fieldCount,
+                                  output.data(), width, height, layerCount);
+                    levelTexels = output.data();
+                }
+                for (int p = 0; p < partCount; p++) {
+                    const int channelCount = std::min(2, fieldCount - 2 * p);
+                    unsigned char* blocks = compressed[(size_t)p * levelCount + level].data() + BlockCompressor::compressedBytes(width, height, channelCount) * firstLayer;
+                    compressor.encode(levelTexels, width, height, layerCount, fieldCount, 2 * p, channelCount, blocks);
+                }
+            }
+        });
+
+    for (int p = 0; p < partCount; p++)
+        for (int level = 0; level < levelCount; level++)
+            part(p, level, compressed[(size_t)p * levelCount + level].data(), compressed[(size_t)p * levelCount + level].getSize());
+}
+
+// Bytes of all the blocks compressTileableFieldLayers() produces for a volume
+size_t TextureGenerator::compressedChainBytes(const int textureWidth, const int textureHeight, const int textureDepth, const int fieldCount) {
+    size_t bytes = 0;
+    for (int p = 0; p < (fieldCount + 1) / 2; p++)
+        for (int level = 0; level < mipLevelCount(textureWidth, textureHeight, 1); level++)
+            bytes += BlockCompressor::compressedBytes(mipSize(textureWidth, level), mipSize(textureHeight, level), std::min(2, fieldCount - 2 * p)) * textureDepth;
+    return bytes;
+}
+
+// Where in its texel mip level level of an axis of size size samples the noise, to sample the center of the block of level 0 texels each of
+// its texels covers: a block of b texels is centered 0.5 - 0.5 / b of a texel past the start of the level's texel, and b only doubles for
+// as long as the axis is halved, so an axis that reaches 1 texel (or was 1 texel to begin with, like the depth of a 2D texture) stops moving
+double TextureGenerator::mipTexelShift(const int size, const int level) {
+    const double block = (double)size / mipSize(size, level);
+    return 0.5 - 0.5 / block;
+}
+
+// Bytes of the whole mip chain of a texture, down to 1x1x1, with texelBytes bytes per texel
+size_t TextureGenerator::mipChainBytes(const int textureWidth, const int textureHeight, const int textureDepth, const int texelBytes) {
+    size_t bytes = 0;
+    for (int level = 0; level < mipLevelCount(textureWidth, textureHeight, textureDepth); level++)
+        bytes += (size_t)mipSize(textureWidth, level) * mipSize(textureHeight, level) * mipSize(textureDepth, level) * texelBytes;
+    return bytes;
+}
+
+// # of mip levels of a texture down to 1x1x1: one more than the # of times its largest dimension can be halved
+int TextureGenerator::mipLevelCount(const int textureWidth, const int textureHeight, const int textureDepth) {
+    int largest = std::max(textureWidth, std::max(textureHeight, textureDepth));
+    int levels = 1;
+    while (largest > 1) {
+        largest >>= 1;
+        levels++;
+    }
+    return levels;
+}
 
-            // Compute the Perlin turbulence value for this point
-            // double noiseValue = perlin.generatePerlinTurbulence(x, y, 0.0, octaves);
-            double noiseValue = perlin->generatePerlinNoise(x, y, 0.0, octaves);
+// Key identifying the volume streamTileableFieldVolume() would produce with these parameters, for caching it (see NoiseCache)
+// It hashes the dimensions, the fields, GENERATOR_VERSION and which path the texels take, along with the noise source's name and its values at a few
+// points of each field. The noise sources don't expose their settings (seed, lattice mode, Worley distance, ...), but any setting that changes the
+// texels changes those values, so a source that is reconfigured gets a new key without each source having to describe itself
+// Parameters: as in streamTileableFieldVolume(); mipFilter is the MipFilter of the whole chain streamed by streamTileableFieldMips(), or -1 for level 0 alone;
+// compression is the BlockCompressor::Quality of the layers compressed by compressTileableFieldLayers(), or -1 for uncompressed texels
+unsigned long long TextureGenerator::fieldVolumeKey(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields, const int fieldCount,
+                                                    const int mipFilter, const int compression) {
+    Checksum key(GENERATOR_VERSION);
+    const int dimensions[5] = { textureWidth, textureHeight, textureDepth, fieldCount, noise == &perlin };
+    key.update(dimensions, sizeof(dimensions));
+    for (int f = 0; f < fieldCount; f++) {
+        key.update(&fields[f].frequency, sizeof(double));
+        key.update(&fields[f].offset, sizeof(double));
+        key.update(&fields[f].repeat, sizeof(int));
+    }
+    const char* name = noise->name();
+    key.update(name, strlen(name));
+    key.update(&mipFilter, sizeof(mipFilter));
+    key.update(&compression, sizeof(compression));
+
+    // The probe row is off the lattice and away from the texel grid, so the values depend on the gradients and hashing of the noise
+    std::vector<double> values((size_t)KEY_PROBE_POINTS * fieldCount);
+    noise->evaluateRowFields(0.3183, 0.6931, 0.1234, 0.4142, KEY_PROBE_POINTS, fields, fieldCount, values.data());
+    key.update(values.data(), values.size() * sizeof(double));
+    return key.value();
+}
+
+// Generates a Perlin noise gradient texture, for building fog normal/lighting maps and advection directions
+// Each pixel holds the gradient of the same noise as generatePerlinTexture() in r,g,b (d/dx, d/dy, d/dz mapped from [-GRADIENT_RANGE,GRADIENT_RANGE] to [0,255])
+// and the noise value itself in a, all from a single analytic-derivative noise evaluation per pixel (for noise sources that provide analytic derivatives)
+// Derivatives are with respect to noise space; multiply by octaves to get them with respect to texture coordinates
+void TextureGenerator::generatePerlinGradientTexture(const int textureWidth, const int textureHeight, const int octaves, TextureImage& image) {
+    // Pointer to the texture data (r,g,b for the gradient, a for the noise value)
+    unsigned char* textureData = prepareImage(image, (size_t)textureWidth * textureHeight * 4);
+
+    // Iterate over each pixel in texture map, row by row, in bands of rows on the thread pool
+    generateRowBands(textureHeight, textureWidth, 4, [&](int firstRow, int lastRow) {
+        for (int i = firstRow; i < lastRow; i++) {
+            // For incrementing textureData index, from the first pixel of the row
+            size_t count = (size_t)i * textureWidth * 4;
+
+            for (int j = 0; j < textureWidth; j++) {
+                // Compute x and y values of the point
+                double x = (double)j / textureWidth * octaves;
+                double y = (double)i / textureHeight * octaves;
+
+                // Noise value and its derivatives at this point
+                double dx, dy, dz;
+                double noiseValue = noise->generateNoiseD(x, y, 0.0, octaves, &dx, &dy, &dz);
+
+                textureData[count] = encodeGradient(dx);
+                textureData[count + 1] = encodeGradient(dy);
+                textureData[count + 2] = encodeGradient(dz);
+                textureData[count + 3] = (int)(noiseValue * 255);
+
+                // Increment by 4 to account for r,g,b,a values
+                count = count + 4;
+            }
+        }
+    });
+}
 
-            // Store the color of this pixel based on the noise value in the textureData array
-            int colorValue = (int)(noiseValue * 255);
+// Generates a tileable curl-noise velocity volume for advecting the fog, as half floats to load as a GL_RGB16F texture (GL_HALF_FLOAT data)
+// Each texel holds the x, y and z velocity of curl at the texel's position in [0,1)^3, so with a whole period the volume tiles under GL_REPEAT
+// Rows are generated in bands on the thread pool, so the whole volume is rebuilt in a few milliseconds when the wind changes
+// Parameters: volumeWidth, volumeHeight and volumeDepth are the dimensions of the volume; curl is the velocity field
+void TextureGenerator::generateVelocityVolume(const int volumeWidth, const int volumeHeight, const int volumeDepth, CurlNoise* curl, TextureImage& image) {
+    // Pointer to the texture data, 3 half floats per texel
+    unsigned short* textureData = (unsigned short*)prepareImage(image, (size_t)volumeWidth * volumeHeight * volumeDepth * 3 * sizeof(unsigned short));
 
-            textureData[count] = colorValue;
-            textureData[count + 1] = colorValue;
-            textureData[count + 2] = colorValue;
-            textureData[count + 3] = 0.0;
+    generateRowBands(volumeHeight * volumeDepth, volumeWidth, 6, [&](int firstRow, int lastRow) {
+        std::vector<double> velocity((size_t)volumeWidth * 3);
+        for (int row = firstRow; row < lastRow; row++) {
+            double y = (double)(row % volumeHeight) / volumeHeight;
+            double z = (double)(row / volumeHeight) / volumeDepth;
+            curl->generateRow(y, z, 0.0, 1.0 / volumeWidth, volumeWidth, velocity.data());
 
-            // Increment by 4 to account for r,g,b,a values
-            count = count + 4;
+            unsigned short* texels = textureData + (size_t)row * volumeWidth * 3;
+            for (int i = 0; i < volumeWidth * 3; i++)
+                texels[i] = encodeHalf((float)velocity[i]);
         }
+    });
+}
+
+// Converts a float to a 16-bit half float (1 sign, 5 exponent and 10 mantissa bits), rounding to nearest even
+// Values too large for a half become infinity and values too small become subnormals or zero, like the GPU's own conversion
+unsigned short TextureGenerator::encodeHalf(float value) {
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned int sign = (bits >> 16) & 0x8000;
+    unsigned int mantissa = bits & 0x7fffff;
+    int exponent = (int)((bits >> 23) & 255) - 127 + 15;
+
+    // Infinity and NaN
+    if (((bits >> 23) & 255) == 255)
+        return (unsigned short)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)
+        return (unsigned short)(sign | 0x7c00);
+
+    // Subnormal halves: the mantissa with its implicit leading 1, shifted down to units of 2^-24
+    if (exponent <= 0) {
+        if (exponent < -10)
+            return (unsigned short)sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        unsigned int half = mantissa >> shift;
+        unsigned int rest = mantissa & ((1u << shift) - 1);
+        unsigned int halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return (unsigned short)(sign | half);
     }
-    // Return the textureData array
-    return textureData;   
+
+    // Rounding up can carry into the exponent, which is still the right result (up to infinity)
+    unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+    unsigned int rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    return (unsigned short)(sign | half);
+}
+
+// Catmull-Rom cubic weights of the 4 samples around a point t of the way from the second sample to the third (t in [0,1))
+// The weights sum to 1 and reproduce the second and third samples exactly at t = 0 and t = 1
+void TextureGenerator::catmullRomWeights(double t, double* weights) {
+    double t2 = t * t;
+    double t3 = t2 * t;
+    weights[0] = 0.5 * (-t3 + 2 * t2 - t);
+    weights[1] = 0.5 * (3 * t3 - 5 * t2 + 2);
+    weights[2] = 0.5 * (-3 * t3 + 4 * t2 + t);
+    weights[3] = 0.5 * (t3 - t2);
+}
+
+// Maps a noise derivative from [-GRADIENT_RANGE,GRADIENT_RANGE] to a color value in [0,255], clamping anything outside that range
+unsigned char TextureGenerator::encodeGradient(double derivative) {
+    double normalized = 0.5 + 0.5 * derivative / GRADIENT_RANGE;
+    if (normalized < 0.0)
+        normalized = 0.0;
+    if (normalized > 1.0)
+        normalized = 1.0;
+    return (unsigned char)(normalized * 255 + 0.5);
 }
 
 // Generates a solid-colored texture
-unsigned char* TextureGenerator::generateSolidTexture(const int textureWidth, const int textureHeight, const float r, const float g, const float b) {
+void TextureGenerator::generateSolidTexture(const int textureWidth, const int textureHeight, const float r, const float g, const float b, TextureImage& image) {
     // Pointer to the texture data
-    unsigned char* textureData = new unsigned char[textureWidth * textureHeight * 3]; 
+    unsigned char* textureData = prepareImage(image, (size_t)textureWidth * textureHeight * 3);
 
     // For incrementing textureData index
     int count = 0;          
@@ -61,6 +793,92 @@ unsigned char* TextureGenerator::generateSolidTexture(const int textureWidth, co
             count = count + 3;
         }
     }   
-    // Return the textureData array
-    return textureData;
-}
\ No newline at end of file
+}
+
+// Generates layers [firstLayer, firstLayer + layerCount) of a volume of fieldCount noise fields, laid out like generateTileableFieldTexture()'s
+// with fieldCount channels per texel, into textureData, which holds just those layers
+// Texel i along an axis of size n is sampled at (i + shift) / n, for that axis's shift in texelShifts (x, y, z; all 0 for nullptr), so a mip level
+// can be sampled at the centers of the blocks of level 0 texels it covers (see mipTexelShift())
+// When dropValues isn't null, each field f with dropValues[f] >= 0 isn't evaluated and its channel is set to dropValues[f]
+// Returns the time it took, in seconds
+double TextureGenerator::generateFieldLayers(unsigned char* textureData, const int textureWidth, const int textureHeight, const int textureDepth,
+                                             const NoiseField* fields, const int fieldCount, const int firstLayer, const int layerCount,
+                                             const double* texelShifts, const int* dropValues) {
+    const double shiftX = texelShifts ? texelShifts[0] : 0.0, shiftY = texelShifts ? texelShifts[1] : 0.0, shiftZ = texelShifts ? texelShifts[2] : 0.0;
+    const double dx = 1.0 / textureWidth;
+    const double x0 = shiftX / textureWidth;
+    const int firstRow = firstLayer * textureHeight;
+
+    // Iterate over each row of each layer, in bands on the thread pool (rows numbered as in generateTileableTexture(), from the first layer)
+    return generateRowBands(layerCount * textureHeight, textureWidth, fieldCount, [&](int bandFirst, int bandLast) {
+        // Noise values of one row of texels, fieldCount per texel
+        std::vector<double> noiseValues((size_t)textureWidth * fieldCount);
+
+        for (int band = bandFirst; band < bandLast; band++) {
+            int row = firstRow + band;
+            double rowY = (row % textureHeight + shiftY) / textureHeight;
+            double rowZ = (row / textureHeight + shiftZ) / textureDepth;
+
+            // For incrementing textureData index, from the first texel of the row
+            size_t count = (size_t)band * textureWidth * fieldCount;
+
+            // The default Perlin source writes each field's 8-bit texels straight into its channel (see generateTileableTexture()), one row pass per
+            // field: fields at different frequencies, like the noise volume's octave layers, have no lattice work to share (see Perlin::evaluateRowFields())
+            if (noise == &perlin) {
+                for (int f = 0; f < fieldCount; f++) {
+                    const NoiseField& field = fields[f];
+                    if (dropValues && dropValues[f] >= 0)
+                        continue;
+                    perlin.evaluateRow8(rowY * field.frequency + field.offset, rowZ * field.frequency + field.offset, x0 * field.frequency + field.offset,
+                                        dx * field.frequency, textureWidth, textureData + count + f, fieldCount, field.repeat, Perlin::NO_DITHER);
+                }
+            }
+            else {
+                noise->evaluateRowFields(rowY, rowZ, x0, dx, textureWidth, fields, fieldCount, noiseValues.data());
+                for (int i = 0; i < textureWidth * fieldCount; i++)
+                    textureData[count + i] = (unsigned char)(noiseValues[i] * 255);
+            }
+
+            if (dropValues) {
+                for (int f = 0; f < fieldCount; f++) {
+                    if (dropValues[f] >= 0) {
+                        for (int i = 0; i < textureWidth; i++)
+                            textureData[count + (size_t)i * fieldCount + f] = (unsigned char)dropValues[f];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Makes image byteCount bytes long and returns its texels, keeping its memory when it's already that size and otherwise swapping it
+// for a block of the right size from the texture pool (the old block goes back to the pool, for whichever texture is that size)
+unsigned char* TextureGenerator::prepareImage(TextureImage& image, const size_t byteCount) {
+    if (image.empty() || image.getSize() != byteCount)
+        image = (images ? *images : TexturePool::shared()).acquire(byteCount);
+    return image.data();
+}
+
+// Runs band(firstRow, lastRow) over consecutive bands of rows [firstRow, lastRow) that together cover rows [0, rowCount), on the thread pool,
+// and records the texel rate for getTexelRate(). Returns the time it took, in seconds
+// A band is about TILE_BYTES of output, so a core writes its band's texels while they are still in its own cache and the row scratch buffers
+// are reused across a band, but bands are kept small enough that every thread gets several of them, which balances the load when rows cost
+// different amounts. Band boundaries depend on the thread count as well as the texture's dimensions, but each row is computed on its own,
+// the same way whichever band and thread it lands in, so the texture's bytes are identical for any number of threads
+// Parameters: rowCount is # of rows; rowTexels is # of texels per row; texelBytes is # of bytes per texel; band generates the rows it's given
+double TextureGenerator::generateRowBands(const int rowCount, const int rowTexels, const int texelBytes, const std::function<void(int, int)>& band) {
+    const auto start = std::chrono::steady_clock::now();
+    ThreadPool& threads = pool ? *pool : ThreadPool::shared();
+
+    int bandRows = std::max(1, TILE_BYTES / std::max(1, rowTexels * texelBytes));
+    bandRows = std::min(bandRows, std::max(1, rowCount / (threads.getThreadCount() * BANDS_PER_THREAD)));
+    const int bandCount = (rowCount + bandRows - 1) / bandRows;
+
+    threads.run(bandCount, [&](int b) {
+        band(b * bandRows, std::min(rowCount, (b + 1) * bandRows));
+    });
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    texelRate = seconds > 0.0 ? (double)rowCount * rowTexels / seconds / 1.0e6 : 0.0;
+    return seconds;
+}
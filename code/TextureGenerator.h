@@ -1,16 +1,142 @@
 #ifndef TEXTUREGENERATOR_H
 #define TEXTUREGENERATOR_H
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include "Perlin.h"
+#include "BlockCompressor.h"
+#include "CurlNoise.h"
+#include "TextureImage.h"
+#include "ThreadPool.h"
 
 // A class for generating textures
 class TextureGenerator {
     public:
-        // Constructor
-        TextureGenerator() {}
+        // Constructors: by default noise textures use Perlin noise, or any other NoiseSource can be given (the TextureGenerator doesn't take ownership of it)
+        // Textures are generated on the shared thread pool unless setThreadPool() picks another one, into memory from the shared texture pool
+        // unless setTexturePool() picks another one
+        TextureGenerator() : noise(&perlin), pool(nullptr), images(nullptr), cancel(nullptr), texelRate(0.0) {}
+        explicit TextureGenerator(NoiseSource* noiseSource) : noise(noiseSource), pool(nullptr), images(nullptr), cancel(nullptr), texelRate(0.0) {}
+
+        // Not copyable, since the default noise source pointer would point into the original object
+        TextureGenerator(const TextureGenerator&) = delete;
+        TextureGenerator& operator=(const TextureGenerator&) = delete;
+
+        // Switches the noise algorithm used by the noise textures, or back to the default Perlin noise for nullptr
+        void setNoiseSource(NoiseSource* noiseSource) { noise = noiseSource ? noiseSource : &perlin; }
+        NoiseSource* getNoiseSource() { return noise; }
+
+        // Whether the noise textures use the default Perlin noise, which is generated on the fixed-point path (see generateFieldLayers())
+        // rather than through the NoiseSource interface, so another generator only makes the same texels if it also uses its default
+        bool usesDefaultNoise() { return noise == &perlin; }
+
+        // Switches the thread pool the textures are generated on, or back to the shared pool for nullptr (the TextureGenerator doesn't take ownership of it)
+        void setThreadPool(ThreadPool* threadPool) { pool = threadPool; }
+
+        // Switches the texture pool that images are acquired from, or back to the shared pool for nullptr (the TextureGenerator doesn't take ownership of it)
+        void setTexturePool(TexturePool* texturePool) { images = texturePool; }
+
+        // Lets another thread stop a streamed volume early: once the flag is set, streamTileableFieldVolume() and streamTileableFieldMips()
+        // return after the slab or level in progress, without streaming the rest (nullptr, the default, for volumes that always finish)
+        void setCancelFlag(const std::atomic<bool>* cancelFlag) { cancel = cancelFlag; }
+
+        // Millions of texels per second achieved by the last texture generated on the thread pool
+        double getTexelRate() { return texelRate; }
+
+        // Receives the slabs of a streamed volume: layerCount layers starting at layer firstLayer, as tightly packed texels
+        using SlabCallback = std::function<void(int firstLayer, int layerCount, const unsigned char* texels)>;
+
+        // How the mip levels below level 0 of a streamed volume are built: by box filtering (averaging each 2x2x2 block of the level above),
+        // by Kaiser-windowed sinc filtering (sharper, without the box filter's blur and aliasing), or procedurally, by generating each level
+        // straight from the noise with the fields too fine for it left out (see streamTileableFieldMips())
+        enum MipFilter { BOX_MIPS, KAISER_MIPS, PROCEDURAL_MIPS };
+
+        // Receives the levels of a streamed mip chain: layerCount layers of mip level level, starting at layer firstLayer, as tightly packed texels
+        using MipSlabCallback = std::function<void(int level, int firstLayer, int layerCount, const unsigned char* texels)>;
+
+        // Receives a block-compressed mip level of a volume's layers: part is which pair of fields (channels 2 * part and 2 * part + 1) it holds
+        using CompressedCallback = std::function<void(int part, int level, const unsigned char* blocks, size_t byteCount)>;
 
         // Methods
-        unsigned char* generatePerlinTexture(const int textureWidth, const int textureHeight, const int octaves);
-        unsigned char* generateSolidTexture(const int textureWidth, const int textureHeight, const float r, const float g, const float b);
+        // Each texture is written into the image passed in, which the caller keeps and uploads from directly. An image that already has the
+        // texture's size is overwritten in place, so regenerating a texture into the same image doesn't allocate; otherwise its memory goes
+        // back to the pool and a block of the right size is acquired
+        void generatePerlinTexture(const int textureWidth, const int textureHeight, const int octaves, TextureImage& image);
+        void generateApproximateTexture(const int textureWidth, const int textureHeight, const int octaves, const double maxError, double* errorBound, TextureImage& image);
+        void generateTileableTexture(const int textureWidth, const int textureHeight, const int textureDepth, const int period, TextureImage& image);
+        void generateTileableFieldTexture(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields, TextureImage& image);
+        void streamTileableFieldVolume(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                       const int fieldCount, const size_t stagingBytes, const SlabCallback& slab);
+        void streamTileableFieldMips(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                     const int fieldCount, const size_t stagingBytes, const MipFilter filter, const MipSlabCallback& slab);
+        void streamProceduralMips(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                  const int fieldCount, const int firstLevel, const MipSlabCallback& slab);
+        void compressTileableFieldLayers(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields,
+                                         const int fieldCount, const size_t stagingBytes, BlockCompressor& compressor, const CompressedCallback& part);
+        unsigned long long fieldVolumeKey(const int textureWidth, const int textureHeight, const int textureDepth, const NoiseField* fields, const int fieldCount,
+                                          const int mipFilter = -1, const int compression = -1);
+        void generatePerlinGradientTexture(const int textureWidth, const int textureHeight, const int octaves, TextureImage& image);
+        void generateVelocityVolume(const int volumeWidth, const int volumeHeight, const int volumeDepth, CurlNoise* curl, TextureImage& image);
+        void generateSolidTexture(const int textureWidth, const int textureHeight, const float r, const float g, const float b, TextureImage& image);
+
+        // # of mip levels of a texture down to 1x1x1, as OpenGL counts them, the size of level level along an axis of size size,
+        // the bytes of the whole chain of a texture with texelBytes bytes per texel, and where in its texels a procedural mip level samples the noise
+        static int mipLevelCount(const int textureWidth, const int textureHeight, const int textureDepth);
+        static int mipSize(const int size, const int level) { return size >> level > 0 ? size >> level : 1; }
+        static size_t mipChainBytes(const int textureWidth, const int textureHeight, const int textureDepth, const int texelBytes);
+        static size_t compressedChainBytes(const int textureWidth, const int textureHeight, const int textureDepth, const int fieldCount);
+        static double mipTexelShift(const int size, const int level);
+
+        // Half-width in texels of the level above of the Kaiser mip filter (so it has twice as many taps), and its window's shape parameter
+        static constexpr int KAISER_RADIUS = 4;
+        static constexpr double KAISER_ALPHA = 4.0;
+
+        // Version of the texel generation, part of fieldVolumeKey(): change it whenever a change to the generator or the noise code changes the texels it produces
+        static constexpr unsigned int GENERATOR_VERSION = 2;
+
+        // # of points along a row of the volume that fieldVolumeKey() evaluates the noise source at
+        static constexpr int KEY_PROBE_POINTS = 16;
+
+        // Largest noise derivative magnitude that generatePerlinGradientTexture() can represent: the analytic bound on each partial derivative
+        // of Perlin noise on the [0,1] scale, the fade's largest slope (15/8, at mid-cell) times the largest half difference of two corners'
+        // contributions (1), which the blend of the gradients can't add to there (about 1.64 is measured over 4M random points)
+        static constexpr double GRADIENT_RANGE = 15.0 / 8.0;
+
+        // Catmull-Rom interpolation of samples h apart is off by at most this times h^3 times the largest third derivative of the function
+        // (the integral of its Peano kernel, at the worst point between samples), and the largest sum of the absolute values of its weights,
+        // by which it can scale errors in the samples, for generateApproximateTexture()
+        static constexpr double CATMULL_ROM_ERROR = 3.0 / 64.0;
+        static constexpr double CATMULL_ROM_GAIN = 1.25;
+
+        // Output bytes per band of rows handed to a thread, so a band's texels stay in the core's cache while they're written,
+        // and # of bands each thread should get at least, so threads that finish early can take over work
+        static constexpr int TILE_BYTES = 32 * 1024;
+        static constexpr int BANDS_PER_THREAD = 4;
+
+    private:
+        // Helper methods
+        unsigned char* prepareImage(TextureImage& image, const size_t byteCount);
+        unsigned char encodeGradient(double derivative);
+        unsigned short encodeHalf(float value);
+        void catmullRomWeights(double t, double* weights);
+        double generateFieldLayers(unsigned char* textureData, const int textureWidth, const int textureHeight, const int textureDepth,
+                                   const NoiseField* fields, const int fieldCount, const int firstLayer, const int layerCount,
+                                   const double* texelShifts, const int* dropValues);
+        void boxDownsample(const unsigned char* source, const int sourceWidth, const int sourceHeight, const int sourceLayers, const int channels,
+                           unsigned char* destination, const int width, const int height, const int layers);
+        void kaiserDownsample(const unsigned char* source, const int sourceWidth, const int sourceHeight, const int sourceDepth, const int channels,
+                              unsigned char* destination);
+        static bool aboveNyquist(const NoiseField& field, const int textureWidth, const int textureHeight, const int textureDepth, const int level);
+        template <typename T> void kaiserAxis(const T* source, const int outer, const int length, const int inner, float* destination);
+        double generateRowBands(const int rowCount, const int rowTexels, const int texelBytes, const std::function<void(int, int)>& band);
+
+        // Instance variables
+        Perlin perlin;       // Default noise source
+        NoiseSource* noise;  // Noise source used by the noise textures
+        ThreadPool* pool;    // Thread pool the textures are generated on (nullptr for ThreadPool::shared(), which is only started when first needed)
+        TexturePool* images; // Texture pool the images are acquired from (nullptr for TexturePool::shared())
+        const std::atomic<bool>* cancel;  // Flag that stops streamed volumes early, or nullptr
+        double texelRate;    // Mtexels/s of the last texture generated on the thread pool
 };
 
 #endif
\ No newline at end of file
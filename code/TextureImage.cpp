@@ -0,0 +1,106 @@
+#include "TextureImage.h"
+#include <new>
+#include <utility>
+
+// Constructor
+TextureImage::TextureImage(size_t byteCount) : bytes(allocate(byteCount)), size(byteCount), pool(nullptr) {}
+
+TextureImage::TextureImage(TextureImage&& other) noexcept : bytes(other.bytes), size(other.size), pool(other.pool) {
+    other.bytes = nullptr;
+    other.size = 0;
+    other.pool = nullptr;
+}
+
+// Releases the image's own block first, then takes over other's
+TextureImage& TextureImage::operator=(TextureImage&& other) noexcept {
+    if (this != &other) {
+        release();
+        std::swap(bytes, other.bytes);
+        std::swap(size, other.size);
+        std::swap(pool, other.pool);
+    }
+    return *this;
+}
+
+// Gives the block back to its pool (or frees it), leaving the image empty
+void TextureImage::release() {
+    if (bytes) {
+        if (pool)
+            pool->recycle(bytes, size);
+        else
+            deallocate(bytes);
+    }
+    bytes = nullptr;
+    size = 0;
+    pool = nullptr;
+}
+
+// Allocates a block of byteCount bytes rounded up by roundSize(), aligned to ALIGNMENT
+unsigned char* TextureImage::allocate(size_t byteCount) {
+    return static_cast<unsigned char*>(::operator new(roundSize(byteCount), std::align_val_t(ALIGNMENT)));
+}
+
+// Frees a block from allocate()
+void TextureImage::deallocate(unsigned char* block) {
+    ::operator delete(block, std::align_val_t(ALIGNMENT));
+}
+
+// Constructor
+TexturePool::TexturePool(size_t maxCachedBytes) : cachedBytes(0), maxCachedBytes(maxCachedBytes), reuseCount(0) {}
+
+// Hands out an image of byteCount bytes, reusing a free block of the same rounded size when there is one
+TextureImage TexturePool::acquire(size_t byteCount) {
+    const size_t blockBytes = TextureImage::roundSize(byteCount);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto blocks = freeBlocks.find(blockBytes);
+        if (blocks != freeBlocks.end() && !blocks->second.empty()) {
+            unsigned char* block = blocks->second.back();
+            blocks->second.pop_back();
+            cachedBytes -= blockBytes;
+            reuseCount++;
+            return TextureImage(block, byteCount, this);
+        }
+    }
+    return TextureImage(TextureImage::allocate(byteCount), byteCount, this);
+}
+
+// Keeps a released block for the next image of its size, or frees it when the pool already holds maxCachedBytes
+void TexturePool::recycle(unsigned char* block, size_t byteCount) {
+    const size_t blockBytes = TextureImage::roundSize(byteCount);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cachedBytes + blockBytes <= maxCachedBytes) {
+            freeBlocks[blockBytes].push_back(block);
+            cachedBytes += blockBytes;
+            return;
+        }
+    }
+    TextureImage::deallocate(block);
+}
+
+// Frees every free block
+void TexturePool::trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& blocks : freeBlocks)
+        for (unsigned char* block : blocks.second)
+            TextureImage::deallocate(block);
+    freeBlocks.clear();
+    cachedBytes = 0;
+}
+
+size_t TexturePool::getCachedBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cachedBytes;
+}
+
+long TexturePool::getReuseCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reuseCount;
+}
+
+// Pool shared by the texture generators
+TexturePool& TexturePool::shared() {
+    static TexturePool pool(SHARED_CACHED_BYTES);
+    return pool;
+}
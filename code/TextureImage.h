@@ -0,0 +1,94 @@
+#ifndef TEXTUREIMAGE_H
+#define TEXTUREIMAGE_H
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class TexturePool;
+
+// The texels of a generated texture, in one block of memory aligned to ALIGNMENT bytes (a cache line, and enough for any SIMD load)
+// A TextureImage owns its block and can only be moved, so the block is freed exactly once: when the image is destroyed or released it goes
+// back to the TexturePool it came from, ready to be handed out again for the next texture of the same size, or is freed if it has no pool
+// The pool must outlive the images it hands out
+class TextureImage {
+    public:
+        // Constructors: an empty image, or one owning a new block of at least byteCount bytes that isn't recycled
+        TextureImage() : bytes(nullptr), size(0), pool(nullptr) {}
+        explicit TextureImage(size_t byteCount);
+        ~TextureImage() { release(); }
+
+        TextureImage(TextureImage&& other) noexcept;
+        TextureImage& operator=(TextureImage&& other) noexcept;
+        TextureImage(const TextureImage&) = delete;
+        TextureImage& operator=(const TextureImage&) = delete;
+
+        // Methods
+        unsigned char* data() { return bytes; }
+        const unsigned char* data() const { return bytes; }
+        template <typename T> T* as() { return reinterpret_cast<T*>(bytes); }
+        size_t getSize() const { return size; }
+        bool empty() const { return bytes == nullptr; }
+
+        // Gives the block back to its pool (or frees it), leaving the image empty
+        void release();
+
+        static constexpr size_t ALIGNMENT = 64;
+
+        // Allocates and frees blocks of a size rounded up by roundSize(), aligned to ALIGNMENT
+        static size_t roundSize(size_t byteCount) { return (byteCount + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+        static unsigned char* allocate(size_t byteCount);
+        static void deallocate(unsigned char* block);
+
+    private:
+        friend class TexturePool;
+        TextureImage(unsigned char* block, size_t byteCount, TexturePool* owner) : bytes(block), size(byteCount), pool(owner) {}
+
+        // Instance variables
+        unsigned char* bytes;  // The block, or nullptr for an empty image
+        size_t size;           // # of bytes asked for (the block itself may be rounded up)
+        TexturePool* pool;     // Pool the block goes back to, or nullptr to free it
+};
+
+// Keeps the blocks of released TextureImages, grouped by size, so regenerating a texture reuses the previous one's memory instead of going
+// back to the heap (a texture regenerated at the same size never allocates again). At most maxCachedBytes of free blocks are kept; a block
+// that doesn't fit is freed. Safe to use from several threads
+class TexturePool {
+    public:
+        // Constructor
+        // Parameters: maxCachedBytes is the most memory kept in free blocks
+        explicit TexturePool(size_t maxCachedBytes);
+        ~TexturePool() { trim(); }
+
+        TexturePool(const TexturePool&) = delete;
+        TexturePool& operator=(const TexturePool&) = delete;
+
+        // Methods
+        // Hands out an image of byteCount bytes, reusing a free block of the same (rounded) size when there is one; its contents are undefined
+        TextureImage acquire(size_t byteCount);
+
+        // Frees every free block
+        void trim();
+
+        size_t getCachedBytes();
+        long getReuseCount();  // # of acquire() calls served from a free block
+
+        // Pool used by the texture generators unless they're given another one
+        static TexturePool& shared();
+        static constexpr size_t SHARED_CACHED_BYTES = 256u * 1024 * 1024;
+
+    private:
+        friend class TextureImage;
+
+        // Helper methods
+        void recycle(unsigned char* block, size_t byteCount);
+
+        // Instance variables
+        std::mutex mutex;
+        std::unordered_map<size_t, std::vector<unsigned char*>> freeBlocks;  // Free blocks by rounded size
+        size_t cachedBytes;     // Total size of the free blocks
+        size_t maxCachedBytes;
+        long reuseCount;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+// Constructor
+ThreadPool::ThreadPool(int threadCount) : job(nullptr), jobTasks(0), jobGeneration(0), activeWorkers(0), quit(false), nextTask(0) {
+    for (int i = 1; i < threadCount; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+// Stops the worker threads, after the job in progress (if any)
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+// Runs task(0) to task(taskCount - 1) on the pool and waits for all of them to finish
+// The calling thread takes tasks too, so a pool of one thread runs the tasks in order on the caller. A task must not call run() on the same pool
+// Parameters: taskCount is # of tasks; task is called with the index of each task
+void ThreadPool::run(int taskCount, const std::function<void(int)>& task) {
+    if (taskCount <= 0)
+        return;
+    std::lock_guard<std::mutex> runLock(runMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        jobTasks = taskCount;
+        nextTask = 0;
+        jobGeneration++;
+    }
+    jobReady.notify_all();
+
+    runTasks(&task, taskCount);
+
+    // Workers that joined the job may still be finishing their last task; ones that haven't woken up yet will find no tasks left
+    // Waiting on activeWorkers under the lock also makes everything the workers wrote visible to the caller
+    std::unique_lock<std::mutex> lock(mutex);
+    jobDone.wait(lock, [&] { return activeWorkers == 0; });
+    job = nullptr;
+}
+
+// Pool shared by the texture generators
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::clamp((int)std::thread::hardware_concurrency(), 1, MAX_SHARED_THREADS));
+    return pool;
+}
+
+// Body of each worker thread: sleeps until a job is submitted, then takes its tasks until there are none left
+void ThreadPool::workerLoop() {
+    long seenGeneration = 0;
+
+    while (true) {
+        const std::function<void(int)>* task;
+        int taskCount;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [&] { return quit || jobGeneration != seenGeneration; });
+            if (quit)
+                return;
+
+            seenGeneration = jobGeneration;
+            task = job;
+            taskCount = jobTasks;
+            activeWorkers++;
+        }
+
+        // A worker that wakes up after run() returned finds the job cleared, and nextTask past the end in any case
+        if (task)
+            runTasks(task, taskCount);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        jobDone.notify_all();
+    }
+}
+
+// Takes tasks of the current job one at a time until there are none left
+void ThreadPool::runTasks(const std::function<void(int)>* task, int taskCount) {
+    int index;
+    while ((index = nextTask++) < taskCount)
+        (*task)(index);
+}
@@ -0,0 +1,53 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A pool of worker threads that stay alive between jobs, so work like baking a texture can be split across cores without starting threads each time
+// A job is a number of independent tasks: run() hands them out one at a time to the workers and the calling thread, which take the next task
+// until there are none left (so faster threads simply do more tasks), and returns once every task is done
+// Which thread runs a task doesn't matter as long as each task only writes its own part of the output, so results don't depend on the thread count
+class ThreadPool {
+    public:
+        // Constructor
+        // Parameters: threadCount is # of threads that work on a job, including the thread calling run(), so threadCount - 1 workers are started
+        explicit ThreadPool(int threadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Methods
+        int getThreadCount() { return (int)workers.size() + 1; }
+        void run(int taskCount, const std::function<void(int)>& task);
+
+        // Pool shared by the texture generators, with a thread per core (up to MAX_SHARED_THREADS), started the first time it's used
+        static ThreadPool& shared();
+        static constexpr int MAX_SHARED_THREADS = 16;
+
+    private:
+        // Helper methods
+        void workerLoop();
+        void runTasks(const std::function<void(int)>* task, int taskCount);
+
+        // Instance variables
+        std::vector<std::thread> workers;
+
+        // Job the workers are taking tasks from, guarded by mutex
+        std::mutex mutex;
+        std::mutex runMutex;               // Serializes run() calls from different threads
+        std::condition_variable jobReady;
+        std::condition_variable jobDone;
+        const std::function<void(int)>* job;
+        int jobTasks;                      // # of tasks in the job
+        long jobGeneration;                // Incremented for every job, so a worker can tell a new job from the one it finished
+        int activeWorkers;                 // # of workers still taking tasks from the job
+        bool quit;
+        std::atomic<int> nextTask;         // Next task of the job to hand out
+};
+
+#endif
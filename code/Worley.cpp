@@ -0,0 +1,276 @@
+#include "Worley.h"
+#include "PerlinTables.h"
+#include "PerlinSIMD.h"
+#include <cmath>
+#include <vector>
+
+// # of points evaluateCell() takes at a time
+const int WORLEY_CHUNK = 256;
+
+// Constructor
+Worley::Worley() : output(F1), seed(0) {}
+
+// Wrap function
+// Brings a coordinate into the repeating interval [0,repeat), including negative coordinates (same as Perlin::wrap)
+// Parameters: val is the coordinate to wrap; repeat is the tiling period in cells, must be > 0
+double Worley::wrap(double val, int repeat) {
+    if (val >= 0 && val < repeat)
+        return val;
+
+    val = fmod(val,repeat);
+    if (val < 0)
+        val += repeat;
+    if (val >= repeat)
+        val = 0.0;
+
+    return val;
+}
+
+// Cell coordinate function
+// Coordinate of the cell offset cells away from the cell whose floored coordinate is fl, as hashed by featurePoint(): wrapped back into
+// [0,repeat) when tiling, so the cells of neighbouring tiles hold the same feature points, or taken mod 2^32 otherwise (like Perlin::hashLatticeIndex)
+// Parameters: fl is the floored coordinate, already wrapped when repeat > 0; offset is -1, 0 or 1; repeat is as in generateWorleyNoise()
+unsigned int Worley::cellCoordinate(double fl, int offset, int repeat) {
+    if (repeat > 0)
+        return (unsigned int)(((int)fl + offset + repeat) % repeat);
+    return (unsigned int)(long long)(fl - 4294967296.0*floor(fl/4294967296.0)) + (unsigned int)offset;
+}
+
+// Feature point function
+// Position of the feature point of a cell inside the cell, in [0,1) on each axis
+// The cell is hashed with the integer lattice hash of PerlinTables.h, and 10 bits of the hash are used for each coordinate
+// Parameters: xHash is the hash after the cell's x coordinate (latticeHashStep(latticeHashStart(seed), cx)), so it can be shared by the cells
+// of a column; cy and cz are the other cell coordinates (see cellCoordinate()); feature receives the 3 coordinates
+void Worley::featurePoint(unsigned int xHash, unsigned int cy, unsigned int cz, double* feature) {
+    unsigned int h = latticeHashFinal(latticeHashStep(latticeHashStep(xHash, cy), cz));
+    feature[0] = ((h & 1023) + 0.5) / 1024;
+    feature[1] = (((h >> 10) & 1023) + 0.5) / 1024;
+    feature[2] = (((h >> 20) & 1023) + 0.5) / 1024;
+}
+
+// Shape function
+// Turns the squared distances to the nearest and second nearest feature points into the noise value of the chosen output, in [0,1]
+double Worley::shape(double f1Squared, double f2Squared) {
+    double value;
+    if (output == F1)
+        value = sqrt(f1Squared) / F1_RANGE;
+    else if (output == F2)
+        value = sqrt(f2Squared) / F2_RANGE;
+    else
+        value = (sqrt(f2Squared) - sqrt(f1Squared)) / F2_MINUS_F1_RANGE;
+    return value < 1.0 ? value : 1.0;
+}
+
+// Cell evaluation function
+// Evaluates count points that lie in the same cell, which share their 3x3x3 block of neighbouring cells
+// Rather than hashing all 27 cells, the cell itself and its 6 face neighbours are hashed first: every point is at most as far from its
+// nearest (and second nearest) feature point as the farthest point of the points' bounding box is from these features, which bounds F1 and F2
+// for the whole group. The 20 edge and corner cells are then only hashed if some part of them is within that bound of the bounding box, and
+// feature points that are farther than the bound from the whole box are dropped. The distances from the points to the remaining feature
+// points are computed by the SIMD kernel PerlinSIMD::nearestFeatures. None of this changes the result, which is the exact F1 and F2 over the 27 cells
+// Parameters: xd, yd and zd are the points' coordinates inside the cell (in [0,1)); count is at most WORLEY_CHUNK; xfl, yfl and zfl are
+// the cell's floored coordinates, already wrapped when repeat > 0; repeat is as in generateWorleyNoise(); out receives the noise values
+void Worley::evaluateCell(const double* xd, const double* yd, const double* zd, int count, double xfl, double yfl, double zfl, int repeat, double* out) {
+    // Bounding box of the points
+    double lo[3] = { xd[0], yd[0], zd[0] };
+    double hi[3] = { xd[0], yd[0], zd[0] };
+    for (int i = 1; i < count; i++) {
+        lo[0] = xd[i] < lo[0] ? xd[i] : lo[0]; hi[0] = xd[i] > hi[0] ? xd[i] : hi[0];
+        lo[1] = yd[i] < lo[1] ? yd[i] : lo[1]; hi[1] = yd[i] > hi[1] ? yd[i] : hi[1];
+        lo[2] = zd[i] < lo[2] ? zd[i] : lo[2]; hi[2] = zd[i] > hi[2] ? zd[i] : hi[2];
+    }
+
+    // Coordinates of the neighbouring cells along y and z, and the hash after the x coordinate for each of the 3 columns along x
+    unsigned int cy[3], cz[3], xHash[3];
+    for (int o = -1; o <= 1; o++) {
+        xHash[o + 1] = latticeHashStep(latticeHashStart(seed), cellCoordinate(xfl,o,repeat));
+        cy[o + 1] = cellCoordinate(yfl,o,repeat);
+        cz[o + 1] = cellCoordinate(zfl,o,repeat);
+    }
+
+    // Candidate feature points relative to the cell's origin, and each one's squared distance to the nearest point of the bounding box
+    double fx[27], fy[27], fz[27], nearest[27];
+    int features = 0;
+
+    // The smallest (F1) or two smallest (F2) squared distances from a feature point to the farthest point of the bounding box so far
+    // bound[needed-1] is then at least the squared F1 or F2 of every point
+    const int needed = output == F1 ? 1 : 2;
+    double bound[2] = { INFINITY, INFINITY };
+
+    auto addCell = [&](int ox, int oy, int oz) {
+        double f[3];
+        featurePoint(xHash[ox + 1], cy[oy + 1], cz[oz + 1], f);
+        f[0] += ox;
+        f[1] += oy;
+        f[2] += oz;
+
+        double nearSquared = 0.0, farSquared = 0.0;
+        for (int a = 0; a < 3; a++) {
+            double below = lo[a] - f[a], above = f[a] - hi[a];
+            double gap = below > 0 ? below : (above > 0 ? above : 0.0);
+            nearSquared += gap * gap;
+            farSquared += below * below > above * above ? below * below : above * above;
+        }
+        if (nearSquared > bound[needed-1])
+            return;
+
+        if (farSquared < bound[0]) {
+            bound[1] = bound[0];
+            bound[0] = farSquared;
+        }
+        else if (farSquared < bound[1]) {
+            bound[1] = farSquared;
+        }
+
+        fx[features] = f[0];
+        fy[features] = f[1];
+        fz[features] = f[2];
+        nearest[features] = nearSquared;
+        features++;
+    };
+
+    // The cell and its face neighbours
+    addCell(0, 0, 0);
+    addCell(-1, 0, 0); addCell(1, 0, 0);
+    addCell(0, -1, 0); addCell(0, 1, 0);
+    addCell(0, 0, -1); addCell(0, 0, 1);
+
+    // The edge and corner neighbours, skipped without hashing when the whole cell is beyond the bound
+    // Along each offset axis, the gap between the bounding box and the neighbour is the box's distance to that side of the cell
+    for (int oz = -1; oz <= 1; oz++) {
+        for (int oy = -1; oy <= 1; oy++) {
+            for (int ox = -1; ox <= 1; ox++) {
+                if ((ox != 0) + (oy != 0) + (oz != 0) < 2)
+                    continue;
+
+                const int o[3] = { ox, oy, oz };
+                double gapSquared = 0.0;
+                for (int a = 0; a < 3; a++) {
+                    double gap = o[a] < 0 ? lo[a] : (o[a] > 0 ? 1.0 - hi[a] : 0.0);
+                    gapSquared += gap * gap;
+                }
+                if (gapSquared <= bound[needed-1])
+                    addCell(ox, oy, oz);
+            }
+        }
+    }
+
+    // The bound has only shrunk since the first candidates were added, so drop the ones that are out of reach now
+    int kept = 0;
+    for (int i = 0; i < features; i++) {
+        if (nearest[i] <= bound[needed-1]) {
+            fx[kept] = fx[i];
+            fy[kept] = fy[i];
+            fz[kept] = fz[i];
+            kept++;
+        }
+    }
+
+    double f1[WORLEY_CHUNK], f2[WORLEY_CHUNK];
+    PerlinSIMD::nearestFeatures(PerlinSIMD::activeLevel(), xd, yd, zd, count, fx, fy, fz, kept, f1, f2);
+    for (int i = 0; i < count; i++)
+        out[i] = shape(f1[i], f2[i]);
+}
+
+// Worley noise function
+// Returns the noise value of the point, in range [0,1]
+// Parameters: xyz are coordinates of point in 3D space; repeat is # of cells after which the noise repeats in each dimension (0 for none)
+double Worley::generateWorleyNoise(double x, double y, double z, int repeat) {
+    double value;
+    generateWorleyNoiseBatch(&x, &y, &z, &value, 1, repeat);
+    return value;
+}
+
+// Batch Worley noise function
+// Evaluates count points given as structure-of-arrays coordinates; each value is identical to generateWorleyNoise() of the point
+// Consecutive points in the same cell (such as the texels of a row) are evaluated together by evaluateCell(), so the cell search is shared between them
+// Parameters: xyz are the coordinates of the points; out receives the count noise values; repeat is as in generateWorleyNoise()
+void Worley::generateWorleyNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat) {
+    double xd[WORLEY_CHUNK], yd[WORLEY_CHUNK], zd[WORLEY_CHUNK];
+
+    int i = 0;
+    while (i < count) {
+        // Gather the run of points that lie in the same cell as point i
+        double cell[3];
+        int n = 0;
+        while (i + n < count && n < WORLEY_CHUNK) {
+            double p[3] = { x[i + n], y[i + n], z[i + n] };
+            double fl[3];
+            for (int a = 0; a < 3; a++) {
+                if (repeat > 0)
+                    p[a] = wrap(p[a],repeat);
+                fl[a] = floor(p[a]);
+            }
+            if (n == 0) {
+                cell[0] = fl[0];
+                cell[1] = fl[1];
+                cell[2] = fl[2];
+            }
+            else if (fl[0] != cell[0] || fl[1] != cell[1] || fl[2] != cell[2]) {
+                break;
+            }
+            xd[n] = p[0] - fl[0];
+            yd[n] = p[1] - fl[1];
+            zd[n] = p[2] - fl[2];
+            n++;
+        }
+
+        evaluateCell(xd, yd, zd, n, cell[0], cell[1], cell[2], repeat, out + i);
+        i += n;
+    }
+}
+
+// Worley noise row function
+// Evaluates the row of count points (x0 + i*dx, y, 0) as one batch
+void Worley::evaluateRow2D(double y, double x0, double dx, int count, double* out, int repeat) {
+    std::vector<double> xs(count), ys(count, y), zs(count, 0.0);
+    for (int i = 0; i < count; i++)
+        xs[i] = x0 + i * dx;
+    generateWorleyNoiseBatch(xs.data(), ys.data(), zs.data(), out, count, repeat);
+}
+
+// 4D Worley noise function
+// Searches the 3x3x3x3 block of 4D cells around the point, cells with fewer offset axes first; a cell is only hashed if its nearest point
+// could still beat the current F1 or F2. Each feature point uses 8 bits of its hash per coordinate
+// Parameters: xyzw are coordinates of point in 4D space; repeat tiles the xyz axes as in generateWorleyNoise(), w never wraps
+double Worley::generateWorleyNoise4D(double x, double y, double z, double w, int repeat) {
+    double p[4] = { x, y, z, w };
+    double fl[4], d[4];
+    for (int a = 0; a < 4; a++) {
+        if (repeat > 0 && a < 3)
+            p[a] = wrap(p[a],repeat);
+        fl[a] = floor(p[a]);
+        d[a] = p[a] - fl[a];
+    }
+
+    double f1 = INFINITY, f2 = INFINITY;
+    for (int axes = 0; axes <= 4; axes++) {
+        for (int c = 0; c < 81; c++) {
+            int o[4] = { c % 3 - 1, c / 3 % 3 - 1, c / 9 % 3 - 1, c / 27 - 1 };
+            if ((o[0] != 0) + (o[1] != 0) + (o[2] != 0) + (o[3] != 0) != axes)
+                continue;
+
+            double gapSquared = 0.0;
+            for (int a = 0; a < 4; a++) {
+                double gap = o[a] < 0 ? d[a] : (o[a] > 0 ? 1.0 - d[a] : 0.0);
+                gapSquared += gap * gap;
+            }
+            if (gapSquared > (output == F1 ? f1 : f2))
+                continue;
+
+            unsigned int h = latticeHashStart(seed);
+            for (int a = 0; a < 4; a++)
+                h = latticeHashStep(h, cellCoordinate(fl[a], o[a], a < 3 ? repeat : 0));
+            h = latticeHashFinal(h);
+
+            double distanceSquared = 0.0;
+            for (int a = 0; a < 4; a++) {
+                double delta = o[a] + (((h >> (8 * a)) & 255) + 0.5) / 256 - d[a];
+                distanceSquared += delta * delta;
+            }
+            f2 = fmin(f2, fmax(f1, distanceSquared));
+            f1 = fmin(f1, distanceSquared);
+        }
+    }
+    return shape(f1, f2);
+}
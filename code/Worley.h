@@ -0,0 +1,52 @@
+#ifndef WORLEY_H
+#define WORLEY_H
+#include "NoiseSource.h"
+
+// A class for generating Worley (cellular) noise, as described in Steven Worley's "A Cellular Texture Basis Function"
+// Space is divided into unit cells that each hold one feature point, jittered to a position hashed from the cell's coordinates and a seed.
+// The noise at a point is built from its distances to the nearest (F1) and second nearest (F2) feature points, which gives the patchy, billowy
+// cell patterns. The nearest feature points are searched for in the 3x3x3 block of cells around the point
+class Worley : public NoiseSource {
+    public:
+        // Distance the noise is built from: to the nearest feature point, to the second nearest one, or their difference (0 along cell borders)
+        enum Output { F1, F2, F2_MINUS_F1 };
+
+        // Constructor
+        // Starts out as F1 noise with seed 0
+        Worley();
+
+        // Methods
+        void setOutput(Output distance) { output = distance; }
+        Output getOutput() { return output; }
+        void setSeed(unsigned int featureSeed) { seed = featureSeed; }
+        unsigned int getSeed() { return seed; }
+        double generateWorleyNoise(double x, double y, double z, int repeat);
+        double generateWorleyNoise4D(double x, double y, double z, double w, int repeat);
+        void generateWorleyNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat);
+
+        // NoiseSource interface
+        const char* name() override { return "Worley"; }
+        double generateNoise(double x, double y, double z, int repeat) override { return generateWorleyNoise(x, y, z, repeat); }
+        double generateNoise4D(double x, double y, double z, double w, int repeat) override { return generateWorleyNoise4D(x, y, z, w, repeat); }
+        void generateNoiseBatch(const double* x, const double* y, const double* z, double* out, int count, int repeat) override { generateWorleyNoiseBatch(x, y, z, out, count, repeat); }
+        void evaluateRow2D(double y, double x0, double dx, int count, double* out, int repeat) override;
+
+        // Distances mapped to 1 by each output (larger ones are clamped), chosen so that clamping is rare
+        static constexpr double F1_RANGE = 1.0;
+        static constexpr double F2_RANGE = 1.25;
+        static constexpr double F2_MINUS_F1_RANGE = 0.75;
+
+    private:
+        // Helper methods
+        double wrap(double val, int repeat);
+        unsigned int cellCoordinate(double fl, int offset, int repeat);
+        void featurePoint(unsigned int xHash, unsigned int cy, unsigned int cz, double* feature);
+        double shape(double f1Squared, double f2Squared);
+        void evaluateCell(const double* xd, const double* yd, const double* zd, int count, double xfl, double yfl, double zfl, int repeat, double* out);
+
+        // Instance variables
+        Output output;      // Distance the noise is built from
+        unsigned int seed;  // Seed of the feature point hash
+};
+
+#endif
@@ -2,7 +2,14 @@
 #include "extern/imgui-docking/backends/imgui_impl_glfw.h"
 #include "extern/imgui-docking/backends/imgui_impl_opengl3.h"
 #include "Perlin.h"
+#include "Simplex.h"
+#include "Worley.h"
+#include "CurlNoise.h"
 #include "TextureGenerator.h"
+#include "NoiseCache.h"
+#include "NoiseAnimator.h"
+#include "NoiseRefiner.h"
+#include "NoiseValidator.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -19,6 +26,31 @@ void keyInput(GLFWwindow *window);
 // Window and texture dimensions
 const int WINDOW_WIDTH = 800, WINDOW_HEIGHT = 800, TEXTURE_WIDTH = 800, TEXTURE_HEIGHT = 800, TEXTURE_DEPTH = 1;
 
+// Dimensions of the noise textures, which are tileable power-of-two volumes repeated over the scene with GL_REPEAT
+// (seamless since the noise is exactly periodic across a tile), so the fog varies along all three axes rather than being one image stretched through space
+// They're generated and uploaded a slab of layers at a time through a staging buffer of at most NOISE_STAGING_BYTES, whatever their depth
+const int NOISE_TILE_SIZE = 128, NOISE_TILE_DEPTH = 128;
+
+// Texture units of the base texture and the noise texture (the evolving fog's slices use units 5 and 6, and the wind's velocity volume VELOCITY_UNIT)
+// Compressed noise is held in up to two 2D array textures instead of the noise texture, on units NOISE_ARRAY_UNITS
+const int BASE_UNIT = 0, NOISE_UNIT = 1;
+const int NOISE_ARRAY_UNITS[2] = { 2, 3 };
+const size_t NOISE_STAGING_BYTES = 4 * 1024 * 1024;
+
+// The 4, 8, 16 and 32 octave noise layers of the noise textures, as fields with that many tiling noise cells across a tile
+const NoiseField NOISE_LAYERS[4] = { { 4, 0.0, 4 }, { 8, 0.0, 8 }, { 16, 0.0, 16 }, { 32, 0.0, 32 } };
+
+// Directory of the on-disk cache of noise volumes (relative to the working directory, like the shaders), so later runs load them instead of generating them
+const char* NOISE_CACHE_DIRECTORY = "noise_cache";
+
+// Dimensions of the time slices of evolving fog, smaller than the static textures so a slice can be regenerated several times a second
+const int SLICE_WIDTH = 128, SLICE_HEIGHT = 128, SLICE_DEPTH = 1;
+
+// Dimensions of the wind's velocity volume, the # of noise cells across it, the texture unit it's bound to, how much smaller than the
+// noise it's sampled (flowScale in the shader) and how many flow cycles pass per second
+const int VELOCITY_SIZE = 32, VELOCITY_PERIOD = 2, VELOCITY_UNIT = 7;
+const float FLOW_SCALE = 0.5f, FLOW_SPEED = 0.1f;
+
 // Shader/buffer variables
 unsigned int shaderProgram, VAO, VBO;
 
@@ -40,13 +72,61 @@ float geoColor[] = { 0.0f, 0.0f, 1.0f, 1.0f };
 int selectedOctave = 0;
 const char* octaveLabels[] = {"0", "4", "8", "16", "32"};
 int octaveSteps[] = { 0, 4, 8, 16, 32 };
+bool octaveLoopFlag = false;   // Sums octaves of the first noise layer in a shader loop instead of using the fixed layers
+float loopOctaves = 4.0f;      // # of octaves in the loop, fractional values fade the last one in
+// Octaves the loop can sum, which the fragment shader gets as maxLoopOctaves. Octave i has 4 * 2^i noise cells per unit of noise texture
+// coordinates, so with the largest fog size and the geometry about 4 units away, a noise cell of the 7th octave still covers about 4 pixels
+// of the window; an 8th octave's cells would be under the 2 pixels a cell needs to show up as detail rather than aliasing
+const int MAX_LOOP_OCTAVES = 7;
 bool animationFlag = true;
+bool evolveFlag = false;
 
 // TextureGenerator pointer to access texture generation methods
-TextureGenerator* Texture;
+TextureGenerator* Texture = new TextureGenerator();
+
+// Noise algorithms the noise textures can be generated with (for user), and how long the last generation of the noise texture took
+// The seeded Perlin noise hashes lattice points from fogSeed instead of the permutation table, so every seed gives a different fog
+// Worley noise gives patchy, cell-like fog, built from the distance the user picked in worleyOutputLabels
+// Simplex noise ignores the tiling period, so it's shown but can't be picked for the tiled noise textures (see NoiseSource::tiles())
+Perlin perlinNoise;
+Perlin seededPerlinNoise;
+Simplex simplexNoise;
+Worley worleyNoise;
+NoiseSource* noiseSources[] = { &perlinNoise, &seededPerlinNoise, &simplexNoise, &worleyNoise };
+const char* noiseLabels[] = { "Perlin", "Perlin (seeded)", "Simplex (doesn't tile)", "Worley" };
+const char* worleyOutputLabels[] = { "F1", "F2", "F2 - F1" };
+int selectedNoise = 0;
+int fogSeed = 1;
+int worleyOutput = Worley::F1;
+float noiseBakeTime = 0.0f;
+float noiseTexelRate = 0.0f;   // Mtexels/s of the CPU side of that generation
+int noiseMipFilter = TextureGenerator::PROCEDURAL_MIPS;  // How the noise texture's mip levels are built (TextureGenerator::MipFilter)
+const char* mipFilterLabels[] = { "Box", "Kaiser", "Procedural" };
+bool noiseCompressed = false;  // Whether the noise is block compressed into the noise arrays (see uploadCompressedNoise())
+int compressionQuality = BlockCompressor::NORMAL;
+const char* compressionLabels[] = { "Fast", "Normal", "High" };
+BlockCompressor noiseCompressor(BlockCompressor::NORMAL);
+bool progressiveNoise = true;  // Whether noise that isn't cached shows a coarse preview first and is refined in the background (see NoiseRefiner)
+NoiseRefiner noiseRefiner(NOISE_UNIT, NOISE_STAGING_BYTES);
+double refineStart = 0.0;      // Time the refinement in progress started
+bool noiseFromCache = false;   // Whether the noise texture was last loaded from the noise cache rather than generated
+NoiseCache noiseCache(NOISE_CACHE_DIRECTORY);
+bool noiseSingleLayer = true;  // Whether the noise texture only holds the first layer, as a GL_R8 volume (see uploadNoiseVolume()); true for the initial 0 octaves
+
+// Generates and streams the time slices of evolving fog, created the first time the user turns it on
+// Its slices are bound to texture units 5 (previous slice) and 6 (current slice)
+NoiseAnimator* animator = nullptr;
+
+// Wind: the fog is advected along a curl-noise velocity field, rebuilt whenever the user changes the wind strength
+CurlNoise wind(&perlinNoise);
+bool windFlag = false;
+float windStrength = 0.15f;
+float windBakeTime = 0.0f;
 
 // Variables to store the textures in
-unsigned int baseTexture, noiseTexture0, noiseTexture1, noiseTexture2, noiseTexture3;
+unsigned int baseTexture, noiseTexture;
+unsigned int noiseArrays[2] = { 0, 0 };
+unsigned int velocityTexture = 0;
 
 // Function to read a file into a string
 string readFile(const char* filePath) {
@@ -164,6 +244,161 @@ void bufferObjects() {
     // glEnableVertexAttribArray(1);  // Enable the vertex attribute at index 1 (the texture coordinate attribute textCoord) to be used in the vertex shader during rendering
 }
 
+// Generates the noise volume and block compresses its layers into the noise arrays, 2D array textures of BC5 layers (holding noise layers 1-2 and 3-4)
+// or a single BC4 one (holding the first noise layer alone), a quarter of the memory and bandwidth of the uncompressed texels or half of GL_R8
+// OpenGL has no block-compressed 3D textures, so the shader blends neighbouring layers itself, and the mip levels only halve each layer
+// The noise texture's levels are emptied meanwhile so it doesn't take up memory, and the arrays are deleted again when compression is turned off
+// Like the uncompressed volume, the blocks go into the noise cache, and come back from it without generating or compressing anything
+// Parameters: layerCount is # of noise layers (1 or 4)
+void uploadCompressedNoise(int layerCount) {
+    const int levelCount = TextureGenerator::mipLevelCount(NOISE_TILE_SIZE, NOISE_TILE_SIZE, 1);
+    const int partCount = (layerCount + 1) / 2;
+
+    glActiveTexture(GL_TEXTURE0 + NOISE_UNIT);
+    for (int level = 0; level < TextureGenerator::mipLevelCount(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH); level++)
+        glTexImage3D(GL_TEXTURE_3D, level, GL_R8, 0, 0, 0, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
+    for (int p = 0; p < 2; p++) {
+        glActiveTexture(GL_TEXTURE0 + NOISE_ARRAY_UNITS[p]);
+        if (p >= partCount) {
+            glDeleteTextures(1, &noiseArrays[p]);
+            noiseArrays[p] = 0;
+            continue;
+        }
+        if (noiseArrays[p] == 0) {
+            glGenTextures(1, &noiseArrays[p]);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, noiseArrays[p]);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+        }
+    }
+
+    // Uploads a part's mip level, allocating it at the same time
+    auto uploadPart = [&](int part, int level, const unsigned char* blocks, size_t byteCount) {
+        const GLenum format = std::min(2, layerCount - 2 * part) == 2 ? GL_COMPRESSED_RG_RGTC2 : GL_COMPRESSED_RED_RGTC1;
+        glActiveTexture(GL_TEXTURE0 + NOISE_ARRAY_UNITS[part]);
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, TextureGenerator::mipSize(NOISE_TILE_SIZE, level), TextureGenerator::mipSize(NOISE_TILE_SIZE, level),
+                               NOISE_TILE_DEPTH, 0, (GLsizei)byteCount, blocks);
+    };
+
+    const size_t chainBytes = TextureGenerator::compressedChainBytes(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH, layerCount);
+    const unsigned long long key = Texture->fieldVolumeKey(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH, NOISE_LAYERS, layerCount, -1, compressionQuality);
+    MappedFile cached;
+    noiseFromCache = noiseCache.load(key, chainBytes, cached);
+    if (noiseFromCache) {
+        // The entry holds each part's levels one after another
+        const unsigned char* blocks = cached.data() + NoiseCache::texelOffset();
+        for (int p = 0; p < partCount; p++) {
+            for (int level = 0; level < levelCount; level++) {
+                const size_t byteCount = BlockCompressor::compressedBytes(TextureGenerator::mipSize(NOISE_TILE_SIZE, level), TextureGenerator::mipSize(NOISE_TILE_SIZE, level),
+                                                                          std::min(2, layerCount - 2 * p)) * NOISE_TILE_DEPTH;
+                uploadPart(p, level, blocks, byteCount);
+                blocks += byteCount;
+            }
+        }
+        noiseTexelRate = 0.0f;
+    }
+    else {
+        NoiseCache::Writer entry = noiseCache.store(key, chainBytes);
+        noiseCompressor.setQuality((BlockCompressor::Quality)compressionQuality);
+        Texture->compressTileableFieldLayers(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH, NOISE_LAYERS, layerCount, NOISE_STAGING_BYTES, noiseCompressor,
+            [&](int part, int level, const unsigned char* blocks, size_t byteCount) {
+                uploadPart(part, level, blocks, byteCount);
+                entry.append(blocks, byteCount);
+            });
+        entry.commit();
+        noiseTexelRate = (float)Texture->getTexelRate();
+    }
+    glActiveTexture(GL_TEXTURE4);
+}
+
+// Generates the noise volume and its mip chain and streams them into the noise texture
+// The four noise layers are baked together into the r, g, b and a channels of the one volume, so the shader gets all of them with a single fetch
+// When no more than the first layer is used (4 octaves or fewer), the volume is a GL_R8 one holding just that layer, a quarter of the memory
+// The texture's storage is (re)allocated here in the format needed, and each slab of layers is uploaded as soon as it's generated, so only the
+// staging buffer is ever held in memory, never the whole volume. The mip levels are built on the thread pool with the filter the user picked
+// (see TextureGenerator::streamTileableFieldMips()) and uploaded along with level 0, instead of glGenerateMipmap() box filtering them afterwards
+// Each slab is also appended to the volume's noise cache entry, so the next time the same volume is needed the whole chain is uploaded straight
+// from the memory-mapped entry and nothing is generated at all
+// With progressive noise, a volume that isn't cached is generated by the noise refiner instead: only its small preview is generated here, and
+// the full-resolution chain streams in over the next frames while the fog is already rendered (any refinement still in progress is cancelled first)
+void uploadNoiseVolume() {
+    // Time the generation and upload of the noise texture, shown in the UI
+    double bakeStart = glfwGetTime();
+    noiseRefiner.cancel();
+
+    const int layerCount = noiseSingleLayer ? 1 : 4;
+    const GLenum internalFormat = noiseSingleLayer ? GL_R8 : GL_RGBA8;
+    const GLenum format = noiseSingleLayer ? GL_RED : GL_RGBA;
+    const int levelCount = TextureGenerator::mipLevelCount(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH);
+
+    if (noiseCompressed) {
+        uploadCompressedNoise(layerCount);
+        noiseBakeTime = (float)((glfwGetTime() - bakeStart) * 1000.0);
+        return;
+    }
+    for (int p = 0; p < 2; p++) {
+        glDeleteTextures(1, &noiseArrays[p]);
+        noiseArrays[p] = 0;
+    }
+
+    // Rows of the smallest levels of a GL_R8 volume are 1 or 2 bytes long, so they can't be padded to the default 4 byte alignment
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glActiveTexture(GL_TEXTURE0 + NOISE_UNIT);
+    for (int level = 0; level < levelCount; level++) {
+        glTexImage3D(GL_TEXTURE_3D, level, internalFormat, TextureGenerator::mipSize(NOISE_TILE_SIZE, level), TextureGenerator::mipSize(NOISE_TILE_SIZE, level),
+                     TextureGenerator::mipSize(NOISE_TILE_DEPTH, level), 0, format, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+
+    // Bytes of one layer of a mip level, and uploads layers of a mip level
+    auto layerBytes = [&](int level) {
+        return (size_t)TextureGenerator::mipSize(NOISE_TILE_SIZE, level) * TextureGenerator::mipSize(NOISE_TILE_SIZE, level) * layerCount;
+    };
+    auto uploadLayers = [&](int level, int firstLayer, int layers, const unsigned char* texels) {
+        glTexSubImage3D(GL_TEXTURE_3D, level, 0, 0, firstLayer, TextureGenerator::mipSize(NOISE_TILE_SIZE, level), TextureGenerator::mipSize(NOISE_TILE_SIZE, level),
+                        layers, format, GL_UNSIGNED_BYTE, texels);
+    };
+
+    const size_t chainBytes = TextureGenerator::mipChainBytes(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH, layerCount);
+    const unsigned long long key = Texture->fieldVolumeKey(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH, NOISE_LAYERS, layerCount, noiseMipFilter);
+    MappedFile cached;
+    noiseFromCache = noiseCache.load(key, chainBytes, cached);
+    if (noiseFromCache) {
+        // The entry holds the levels one after another
+        const unsigned char* texels = cached.data() + NoiseCache::texelOffset();
+        for (int level = 0; level < levelCount; level++) {
+            uploadLayers(level, 0, TextureGenerator::mipSize(NOISE_TILE_DEPTH, level), texels);
+            texels += layerBytes(level) * TextureGenerator::mipSize(NOISE_TILE_DEPTH, level);
+        }
+        noiseTexelRate = 0.0f;
+    }
+    else if (progressiveNoise) {
+        refineStart = bakeStart;
+        // The refiner's generator must take the same path as Texture's for the texels to match the cache key
+        noiseRefiner.start(Texture->usesDefaultNoise() ? nullptr : Texture->getNoiseSource(), NOISE_LAYERS, layerCount, NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH,
+                           (TextureGenerator::MipFilter)noiseMipFilter, noiseCache.store(key, chainBytes));
+        noiseTexelRate = (float)noiseRefiner.getTexelRate();
+    }
+    else {
+        NoiseCache::Writer entry = noiseCache.store(key, chainBytes);
+        Texture->streamTileableFieldMips(NOISE_TILE_SIZE, NOISE_TILE_SIZE, NOISE_TILE_DEPTH, NOISE_LAYERS, layerCount, NOISE_STAGING_BYTES,
+            (TextureGenerator::MipFilter)noiseMipFilter, [&](int level, int firstLayer, int layers, const unsigned char* texels) {
+                uploadLayers(level, firstLayer, layers, texels);
+                entry.append(texels, layerBytes(level) * layers);
+            });
+        entry.commit();
+        noiseTexelRate = (float)Texture->getTexelRate();
+    }
+    glActiveTexture(GL_TEXTURE4);
+
+    noiseBakeTime = (float)((glfwGetTime() - bakeStart) * 1000.0);
+}
+
 // Sets up the textures
 void textures() {
     // For blending, as Perlin noise has alpha channel for overlapping textures
@@ -175,85 +410,116 @@ void textures() {
 
     // BASE TEXTURE (2D)
     const float r = 0.0f, g = 0.0f, b = 200.0f; // Blue
-    unsigned char* baseData = Texture->generateSolidTexture(TEXTURE_WIDTH, TEXTURE_HEIGHT, r, g, b); // Generate the solid-colored texture, storing a pointer to it in baseData
-    glGenTextures(1, &baseTexture);                                   // Generate a new texture object, storing its identifier in noiseTexture0
+    TextureImage baseImage;
+    Texture->generateSolidTexture(TEXTURE_WIDTH, TEXTURE_HEIGHT, r, g, b, baseImage); // Generate the solid-colored texture into baseImage, whose memory goes back to the texture pool once it's uploaded
+    glActiveTexture(GL_TEXTURE0 + BASE_UNIT);
+    glGenTextures(1, &baseTexture);                                   // Generate a new texture object, storing its identifier in baseTexture
     glBindTexture(GL_TEXTURE_2D, baseTexture);                        // Bind the texture object to the texture target GL_TEXTURE_2D so that any subsequent texture commends will be applied to this texture
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);     // Set texture wrapping parameters, indicating that the texture should be repeated when the texture coordinates extend beyond the range [0,1]
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Load the texture filtering parameters for the texture, indicating that linear interpolation should be used to filter the texture   
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, TEXTURE_WIDTH, TEXTURE_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, baseData); // Set the texture unit index to the uniform variable
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, TEXTURE_WIDTH, TEXTURE_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, baseImage.data()); // Set the texture unit index to the uniform variable
     glGenerateMipmap(GL_TEXTURE_2D);                                  // Generate a set of mipmaps (smaller version of texture) for performance improvement. Graphics hardware selects an appropriate level of detail based on viewer distance
 
-    // NOISE TEXTURE 0 - 4 noise octaves
-    const int octaves0 = 4;
-    unsigned char* noiseData0 = Texture->generatePerlinTexture(TEXTURE_WIDTH, TEXTURE_HEIGHT, octaves0); // Generate the Perlin noise texture, storing a pointer to it in noiseTexture0
-    glGenTextures(1, &noiseTexture0);                                   // Generate a new texture object, storing its identifier in noiseTexture0
-    glBindTexture(GL_TEXTURE_3D, noiseTexture0);                        // Bind the texture object to the texture target GL_TEXTURE_2D so that any subsequent texture commends will be applied to this texture
+    // NOISE TEXTURE (3D) - the 4, 8, 16 and 32 octave layers, created empty here and filled by uploadNoiseVolume() once it's bound to its texture unit
+    glActiveTexture(GL_TEXTURE0 + NOISE_UNIT);
+    glGenTextures(1, &noiseTexture);                                    // Generate a new texture object, storing its identifier in noiseTexture
+    glBindTexture(GL_TEXTURE_3D, noiseTexture);                         // Bind the texture object to the texture target GL_TEXTURE_3D of its unit, where the shader samples it
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);       // Set texture wrapping parameters, indicating that the texture should be repeated when the texture coordinates extend beyond the range [0,1]
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);   // Load the texture filtering parameters for the texture, indicating that linear interpolation should be used to filter the texture   
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); 
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_DEPTH, 0, GL_RGBA, GL_UNSIGNED_BYTE, noiseData0);  // Load the texture data
-    glGenerateMipmap(GL_TEXTURE_3D);                                    // Generate a set of mipmaps (smaller version of texture) for performance improvement. Graphics hardware selects an appropriate level of detail based on viewer distance
-
-    // NOISE TEXTURE 1 - 8 noise octaves
-    const int octaves1 = 8;
-    unsigned char* noiseData1 = Texture->generatePerlinTexture(TEXTURE_WIDTH, TEXTURE_HEIGHT, octaves1);
-    glGenTextures(1, &noiseTexture1);
-    glBindTexture(GL_TEXTURE_3D, noiseTexture1);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);  // Trilinear filtering, so distant fog is sampled from the mip levels rather than aliasing
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); 
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_DEPTH, 0, GL_RGBA, GL_UNSIGNED_BYTE, noiseData1);
-    glGenerateMipmap(GL_TEXTURE_3D);
-
-    // NOISE TEXTURE 2 - 16 noise octaves
-    const int octaves2 = 16;
-    unsigned char* noiseData2 = Texture->generatePerlinTexture(TEXTURE_WIDTH, TEXTURE_HEIGHT, octaves2);
-    glGenTextures(1, &noiseTexture2);
-    glBindTexture(GL_TEXTURE_3D, noiseTexture2);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); 
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_DEPTH, 0, GL_RGBA, GL_UNSIGNED_BYTE, noiseData2);
-    glGenerateMipmap(GL_TEXTURE_3D);
-
-    // NOISE TEXTURE 3 - 32 noise octaves
-    const int octaves3 = 32;
-    unsigned char* noiseData3 = Texture->generatePerlinTexture(TEXTURE_WIDTH, TEXTURE_HEIGHT, octaves3);
-    glGenTextures(1, &noiseTexture3);
-    glBindTexture(GL_TEXTURE_3D, noiseTexture3);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_DEPTH, 0, GL_RGBA, GL_UNSIGNED_BYTE, noiseData3);
-    glGenerateMipmap(GL_TEXTURE_3D);
-
-    // Pass the textures to the fragment shader
-    glUniform1i(glGetUniformLocation(shaderProgram, "baseTexture"), 0);   // Bind to TEXTURE0
-    glUniform1i(glGetUniformLocation(shaderProgram, "noiseTexture0"), 1); // Bind to TEXTURE1
-    glUniform1i(glGetUniformLocation(shaderProgram, "noiseTexture1"), 2); // Bind to TEXTURE2
-    glUniform1i(glGetUniformLocation(shaderProgram, "noiseTexture2"), 3); // Bind to TEXTURE3
-    glUniform1i(glGetUniformLocation(shaderProgram, "noiseTexture3"), 4); // Bind to TEXTURE4
-
-    // Activate and bind the Perlin noise textures
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_3D, noiseTexture0);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_3D, noiseTexture1);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_3D, noiseTexture2);
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_3D, noiseTexture3);
+
+    // Pass the texture units to the fragment shader
+    glUniform1i(glGetUniformLocation(shaderProgram, "baseTexture"), BASE_UNIT);
+    glUniform1i(glGetUniformLocation(shaderProgram, "noiseTexture"), NOISE_UNIT);
+    glUniform1i(glGetUniformLocation(shaderProgram, "noiseLayers01"), NOISE_ARRAY_UNITS[0]);
+    glUniform1i(glGetUniformLocation(shaderProgram, "noiseLayers23"), NOISE_ARRAY_UNITS[1]);
+
+    // Unit 4 isn't used by any sampler, so it's left active for binding textures without disturbing the others
+    glActiveTexture(GL_TEXTURE4);
+
+    uploadNoiseVolume();
+}
+
+// Regenerates the noise texture with the noise algorithm the user selected, replacing the contents of the existing texture object
+void regenerateNoiseTextures() {
+    Texture->setNoiseSource(noiseSources[selectedNoise]);
+    if (animator)
+        animator->setNoiseSource(noiseSources[selectedNoise]);
+
+    uploadNoiseVolume();
+}
+
+// Switches the seeded Perlin noise to the seed the user entered and regenerates the noise textures with it
+// The animator's workers may be evaluating that noise, so they are stopped while the seed changes and the animation restarts from the new seed
+void applyFogSeed() {
+    noiseRefiner.cancel();
+    bool restartAnimator = animator && noiseSources[selectedNoise] == &seededPerlinNoise;
+    if (restartAnimator)
+        animator->shutdown();
+    seededPerlinNoise.setLatticeHash(Perlin::INTEGER_HASH, (unsigned int)fogSeed);
+    if (restartAnimator)
+        animator->init(noiseSources[selectedNoise], glfwGetTime(), 5, 6);
+    regenerateNoiseTextures();
+}
+
+// Switches Worley noise to the distance the user picked and regenerates the noise textures with it, stopping the animator's workers meanwhile like applyFogSeed()
+void applyWorleyOutput() {
+    noiseRefiner.cancel();
+    bool restartAnimator = animator && noiseSources[selectedNoise] == &worleyNoise;
+    if (restartAnimator)
+        animator->shutdown();
+    worleyNoise.setOutput((Worley::Output)worleyOutput);
+    if (restartAnimator)
+        animator->init(noiseSources[selectedNoise], glfwGetTime(), 5, 6);
+    regenerateNoiseTextures();
+}
+
+// Rebuilds the wind's velocity volume at the current wind strength, creating its texture (GL_RGB16F, bound to VELOCITY_UNIT) the first time
+void updateWindField() {
+    double bakeStart = glfwGetTime();
+    wind.setPeriod(VELOCITY_PERIOD);
+    wind.setStrength(windStrength);
+    // The volume's memory comes back from the texture pool every time the wind changes, so rebuilding it doesn't allocate
+    TextureImage velocityImage;
+    Texture->generateVelocityVolume(VELOCITY_SIZE, VELOCITY_SIZE, VELOCITY_SIZE, &wind, velocityImage);
+    const unsigned short* velocityData = velocityImage.as<unsigned short>();
+
+    glActiveTexture(GL_TEXTURE0 + VELOCITY_UNIT);
+    if (velocityTexture == 0) {
+        glGenTextures(1, &velocityTexture);
+        glBindTexture(GL_TEXTURE_3D, velocityTexture);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, VELOCITY_SIZE, VELOCITY_SIZE, VELOCITY_SIZE, 0, GL_RGB, GL_HALF_FLOAT, velocityData);
+        glUniform1i(glGetUniformLocation(shaderProgram, "velocityTexture"), VELOCITY_UNIT);
+    }
+    else {
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, VELOCITY_SIZE, VELOCITY_SIZE, VELOCITY_SIZE, GL_RGB, GL_HALF_FLOAT, velocityData);
+    }
     glActiveTexture(GL_TEXTURE4);
+    windBakeTime = (float)((glfwGetTime() - bakeStart) * 1000.0);
 }
 
-int main()
+// # of random points per input set of the --validate run
+const int VALIDATION_POINTS = 20000;
+
+int main(int argc, char** argv)
 {
+    // With --validate, check the fast noise paths against the reference noise instead of opening the window, exiting with 1 if any goes over its bound
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--validate") {
+            NoiseValidator validator(1, VALIDATION_POINTS);
+            return validator.run() == 0 ? 0 : 1;
+        }
+    }
+
     // Initialize GLFW - GLFW used to open a window and connect to your OpenGL context
     if (!glfwInit())
     {
@@ -305,6 +571,7 @@ int main()
     bufferObjects();
 
     // Set up textures: base texture (solid color) and Perlin noise textures
+    seededPerlinNoise.setLatticeHash(Perlin::INTEGER_HASH, (unsigned int)fogSeed);
     textures();
 
     // Enable depth testing for proper cube drawing (no see-through surfaces)
@@ -355,6 +622,18 @@ int main()
         view = glm::lookAt(cameraPosition, cameraPosition + cameraFront, cameraUp);
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
 
+        // Progressive noise: upload the slabs of the refined noise volume that are ready, and time the whole generation once it's complete
+        if (noiseRefiner.update()) {
+            noiseBakeTime = (float)((glfwGetTime() - refineStart) * 1000.0);
+            noiseTexelRate = (float)noiseRefiner.getTexelRate();
+        }
+
+        // Evolving fog: stream in the next time slice of 4D noise if one is due, and pass how far to blend to it
+        if (evolveFlag) {
+            animator->update(currentFrame);
+            glUniform1f(glGetUniformLocation(shaderProgram, "sliceBlend"), animator->getSliceBlend(currentFrame));
+        }
+
         // Define animation vector to pass to shader. The animation matrix is shared by all geometry in the scene, except the background
         glm::vec4 animation = glm::vec4((sin(currentFrame) * 0.02f),(cos(currentFrame) * 0.01f),(cos(currentFrame) * 0.009f),(sin(currentFrame) * 0.01f));
         glUniform4fv(animationLoc, 1, glm::value_ptr(animation));
@@ -413,9 +692,61 @@ int main()
         ImGui::ColorEdit4("Fog Color", fogColor);
         ImGui::SliderFloat("Fog Size", &fogSize, 0.05f, 0.15);
         ImGui::ColorEdit4("Geometry Color", geoColor);
-        ImGui::Combo("Number of Octaves", &selectedOctave, octaveLabels, IM_ARRAYSIZE(octaveLabels));
+        bool octavesChanged = ImGui::Checkbox("Octave Loop", &octaveLoopFlag);
+        if (octaveLoopFlag)
+            ImGui::SliderFloat("Octaves", &loopOctaves, 1.0f, (float)MAX_LOOP_OCTAVES);
+        else
+            octavesChanged |= ImGui::Combo("Number of Octaves", &selectedOctave, octaveLabels, IM_ARRAYSIZE(octaveLabels));
+        // The octave loop only reads the first layer, so it never needs the other three
+        if (octavesChanged && (octaveLoopFlag || octaveSteps[selectedOctave] <= 4) != noiseSingleLayer) {
+            noiseSingleLayer = !noiseSingleLayer;
+            uploadNoiseVolume();
+        }
+        if (!noiseCompressed && ImGui::Combo("Noise Mipmaps", &noiseMipFilter, mipFilterLabels, IM_ARRAYSIZE(mipFilterLabels)))
+            uploadNoiseVolume();
+        if (ImGui::Checkbox("Compress Noise (BC4/BC5)", &noiseCompressed))
+            uploadNoiseVolume();
+        if (noiseCompressed && ImGui::Combo("Compression Quality", &compressionQuality, compressionLabels, IM_ARRAYSIZE(compressionLabels)))
+            uploadNoiseVolume();
         int octaveVal =  octaveSteps[selectedOctave];
         ImGui::Checkbox("Animate", &animationFlag);
+        if (ImGui::Checkbox("Evolve (4D noise)", &evolveFlag) && evolveFlag && !animator) {
+            animator = new NoiseAnimator(SLICE_WIDTH, SLICE_HEIGHT, SLICE_DEPTH);
+            animator->init(noiseSources[selectedNoise], glfwGetTime(), 5, 6);
+            glUniform1i(glGetUniformLocation(shaderProgram, "previousSlice"), 5);
+            glUniform1i(glGetUniformLocation(shaderProgram, "currentSlice"), 6);
+        }
+        // The noise textures are tiles repeated over the scene, so noise that can't tile is listed greyed out rather than baked with seams
+        if (ImGui::BeginCombo("Noise Type", noiseLabels[selectedNoise])) {
+            for (int i = 0; i < IM_ARRAYSIZE(noiseLabels); i++) {
+                const bool tileable = noiseSources[i]->tiles();
+                if (ImGui::Selectable(noiseLabels[i], i == selectedNoise, tileable ? 0 : ImGuiSelectableFlags_Disabled)) {
+                    selectedNoise = i;
+                    regenerateNoiseTextures();
+                }
+                if (!tileable && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+                    ImGui::SetTooltip("%s noise doesn't tile, so it would show seams at every repeat of the noise texture", noiseSources[i]->name());
+            }
+            ImGui::EndCombo();
+        }
+        if (noiseSources[selectedNoise] == &seededPerlinNoise && ImGui::InputInt("Seed", &fogSeed))
+            applyFogSeed();
+        if (noiseSources[selectedNoise] == &worleyNoise && ImGui::Combo("Worley Distance", &worleyOutput, worleyOutputLabels, IM_ARRAYSIZE(worleyOutputLabels)))
+            applyWorleyOutput();
+        if (ImGui::Checkbox("Wind (curl noise)", &windFlag) && windFlag && velocityTexture == 0)
+            updateWindField();
+        if (windFlag && ImGui::SliderFloat("Wind Strength", &windStrength, 0.0f, 0.5f))
+            updateWindField();
+        if (ImGui::Checkbox("Progressive Noise", &progressiveNoise) && !progressiveNoise && noiseRefiner.isRefining())
+            uploadNoiseVolume();
+        if (noiseRefiner.isRefining())
+            ImGui::Text("Noise preview: %.1f ms (refining...)", noiseBakeTime);
+        else if (noiseFromCache)
+            ImGui::Text("Noise generation: %.1f ms (from cache)", noiseBakeTime);
+        else
+            ImGui::Text("Noise generation: %.1f ms (%.0f Mtexels/s)", noiseBakeTime, noiseTexelRate);
+        if (windFlag)
+            ImGui::Text("Wind field: %.1f ms", windBakeTime);
         ImGui::End();
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -426,7 +757,17 @@ int main()
         glUniform4f(glGetUniformLocation(shaderProgram, "fogColor"), fogColor[0], fogColor[1], fogColor[2], fogColor[3]);
         glUniform4f(glGetUniformLocation(shaderProgram, "geoColor"), geoColor[0], geoColor[1], geoColor[2], geoColor[3]);
         glUniform1i(glGetUniformLocation(shaderProgram, "numOctaves"), octaveVal);
-        glUniform1i(glGetUniformLocation(shaderProgram, "animationFlag"), animationFlag);
+        glUniform1i(glGetUniformLocation(shaderProgram, "octaveLoopFlag"), octaveLoopFlag);
+        glUniform1i(glGetUniformLocation(shaderProgram, "compressedFlag"), noiseCompressed);
+        glUniform1i(glGetUniformLocation(shaderProgram, "noiseDepth"), NOISE_TILE_DEPTH);
+        glUniform1i(glGetUniformLocation(shaderProgram, "noiseLayerCount"), noiseSingleLayer ? 1 : 4);
+        glUniform1f(glGetUniformLocation(shaderProgram, "octaveCount"), loopOctaves);
+        glUniform1i(glGetUniformLocation(shaderProgram, "maxLoopOctaves"), MAX_LOOP_OCTAVES);
+        glUniform1i(glGetUniformLocation(shaderProgram, "animationFlag"), animationFlag && !evolveFlag && !windFlag);  // Evolving and windy fog move on their own, without the breathing texture coordinates
+        glUniform1i(glGetUniformLocation(shaderProgram, "evolveFlag"), evolveFlag);
+        glUniform1i(glGetUniformLocation(shaderProgram, "flowFlag"), windFlag);
+        glUniform1f(glGetUniformLocation(shaderProgram, "flowTime"), currentFrame * FLOW_SPEED);
+        glUniform1f(glGetUniformLocation(shaderProgram, "flowScale"), FLOW_SCALE);
 
         // Swap buffers the back and front buffers
         glfwSwapBuffers(window);
@@ -438,11 +779,18 @@ int main()
     // Clean up
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteTextures(1, &noiseTexture0);
-    glDeleteTextures(1, &noiseTexture1);
-    glDeleteTextures(1, &noiseTexture2);
-    glDeleteTextures(1, &noiseTexture3);
+    glDeleteTextures(1, &baseTexture);
+    glDeleteTextures(1, &noiseTexture);
+    glDeleteTextures(2, noiseArrays);
+    if (velocityTexture != 0)
+        glDeleteTextures(1, &velocityTexture);
     glDeleteProgram(shaderProgram);
+    noiseRefiner.shutdown();
+    if (animator) {
+        animator->shutdown();
+        delete animator;
+    }
+    delete Texture;
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
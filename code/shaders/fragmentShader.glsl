@@ -1,8 +1,11 @@
 /* INPUTS
    Vertex position in appropriate coordinate space (relative to camera)
-   Perlin noise texture coordinates and noise textures 
+   Perlin noise texture coordinates and the noise texture 
    Base texture for geometry (if a base texture is used, and not just a plain color)
    Fog density, fog color, # of Perlin noise octaves used (based on step slider value), geometry color which user can modify
+   For the octave loop: the (possibly fractional) # of octaves summed from the first layer
+   For evolving fog: the two most recent time slices of 4D noise and how far to blend between them
+   For wind: the curl-noise velocity volume the noise is advected along, and the flow time
 */
 
 /* OUTPUTS
@@ -27,11 +30,35 @@ in vec3 noiseTexCoords3;
 out vec4 fragColor; 
 
 // Textures
+// The noise texture holds the 4, 8, 16 and 32 octave layers in r, g, b and a (or only the first layer in r, when fewer than 8 octaves are used)
 uniform sampler2D baseTexture; 
-uniform sampler3D noiseTexture0;             
-uniform sampler3D noiseTexture1;        
-uniform sampler3D noiseTexture2;        
-uniform sampler3D noiseTexture3; 
+uniform sampler3D noiseTexture;
+
+// Compressed noise: the layers of the noise volume as 2D arrays of BC5 textures (layers 1-2 in noiseLayers01, 3-4 in noiseLayers23),
+// or of one BC4 texture for the first layer alone, of noiseLayerCount layers and noiseDepth slices. Compressed formats can't be 3D textures,
+// so the slices either side of a sample are blended here, and the mip levels only shrink each slice
+uniform sampler2DArray noiseLayers01;
+uniform sampler2DArray noiseLayers23;
+uniform bool compressedFlag;
+uniform int noiseDepth;
+uniform int noiseLayerCount;
+
+// Evolving fog: time slices of 4D noise holding the 4, 8, 16 and 32 octave layers in r, g, b and a, blended by sliceBlend from the previous slice to the current one
+uniform sampler3D previousSlice;
+uniform sampler3D currentSlice;
+uniform float sliceBlend;
+uniform bool evolveFlag;
+
+// Wind: a divergence-free velocity field (curl noise) that the noise textures are advected along, sampled at flowScale times the
+// noise coordinates, and the flow time, which advances by one every flow cycle
+uniform sampler3D velocityTexture;
+uniform float flowTime;
+uniform float flowScale;
+uniform bool flowFlag;
+
+// Animation state of the vertex shader: animated fog moves each layer's coordinates at a different speed, except on the background
+uniform bool animationFlag;
+uniform bool background;
 
 // Other fog variables, which user can control
 uniform float density;
@@ -39,22 +66,125 @@ uniform vec4 fogColor;
 uniform vec4 geoColor;               
 uniform int numOctaves; 
 
+// Octave loop: instead of the fixed layers, the first layer (which tiles the texture) is sampled at twice the frequency and half the amplitude
+// for each octave, so any # of octaves costs no more texture memory than one. A fractional octaveCount fades the last octave in
+// maxLoopOctaves is the limit of the octave slider (MAX_LOOP_OCTAVES in main.cpp), past which the octaves would only alias on screen
+uniform bool octaveLoopFlag;
+uniform float octaveCount;
+uniform int maxLoopOctaves;
+
+// Samples the noise layers from the noise texture, or from the compressed arrays, blending the two slices nearest the sample and wrapping
+// around at the ends like the noise texture does
+vec4 fetchNoise(vec3 coords)
+{
+    if (compressedFlag == false)
+        return texture(noiseTexture, coords);
+
+    float slice = fract(coords.z) * float(noiseDepth) - 0.5;
+    float first = floor(slice);
+    float next = mod(first + 1.0, float(noiseDepth));
+    first = mod(first, float(noiseDepth));
+
+    vec4 below = vec4(texture(noiseLayers01, vec3(coords.xy, first)).rg, 0.0, 1.0);
+    vec4 above = vec4(texture(noiseLayers01, vec3(coords.xy, next)).rg, 0.0, 1.0);
+    if (noiseLayerCount > 2) {
+        below.zw = texture(noiseLayers23, vec3(coords.xy, first)).rg;
+        above.zw = texture(noiseLayers23, vec3(coords.xy, next)).rg;
+    }
+    return mix(below, above, fract(slice));
+}
+
+// Samples a noise texture with its coordinates advected along the wind (flow mapping)
+// Coordinates pushed further and further along the flow would stretch the noise more and more, so two copies are pushed along for one cycle each,
+// half a cycle apart, and blended so that each one fades out just before it jumps back to the start
+vec4 advect(vec3 coords, vec3 velocity)
+{
+    float phase0 = fract(flowTime);
+    float phase1 = fract(flowTime + 0.5);
+    float weight = abs(1.0 - 2.0 * phase0);
+    return mix(fetchNoise(coords - velocity * phase0), fetchNoise(coords - velocity * phase1), weight);
+}
+
+// Samples the noise layers at the given coordinates, along the wind when it's on
+vec4 sampleLayers(vec3 coords, vec3 velocity)
+{
+    if (flowFlag == true)
+        return advect(coords, velocity);
+    return fetchNoise(coords);
+}
+
+// Samples the first layer at the given coordinates, from the time slices for evolving fog
+// Parameters: frequency scales the wind velocity, so every octave is pushed the same distance along the flow as the fixed layers are
+float sampleBase(vec3 coords, vec3 velocity, float frequency)
+{
+    if (evolveFlag == true)
+        return mix(texture(previousSlice, coords), texture(currentSlice, coords), sliceBlend).x;
+    return sampleLayers(coords, velocity * frequency).x;
+}
+
+// Sums the octaves of the octave loop; the first layer at 2^i times the coordinates is exactly layer i of the fixed layers,
+// so 1, 2, 3 and 4 octaves give the same turbulence as the 4, 8, 16 and 32 choices
+float loopTurbulence(vec3 coords, vec3 velocity)
+{
+    float turbulence = 0.0f;
+    float frequency = 1.0f;
+    float amplitude = 1.0f;
+    int wholeOctaves = int(octaveCount);
+
+    for (int i = 0; i < maxLoopOctaves && i <= wholeOctaves; i++) {
+        float weight = (i < wholeOctaves) ? 1.0f : fract(octaveCount);
+        if (weight > 0.0f)
+            turbulence += amplitude * weight * sampleBase(coords * frequency, velocity, frequency);
+        frequency *= 2.0f;
+        amplitude *= 0.5f;
+    }
+    return turbulence;
+}
+
 void main()                                     
 {   
     // Makes it possible to add a 2D texture as the base layer, however we use a vec4 color instead to allow user to choose their color
     vec4 baseColor = texture(baseTexture, texCoord);
 
-    // Create the noise textures
-    vec4 noiseOctave0 = texture(noiseTexture0, noiseTexCoords0); 
-    vec4 noiseOctave1 = texture(noiseTexture1, noiseTexCoords1); 
-    vec4 noiseOctave2 = texture(noiseTexture2, noiseTexCoords2); 
-    vec4 noiseOctave3 = texture(noiseTexture3, noiseTexCoords3); 
-
-    // For each texture, get the appropriate coordinate for turbulence calculations
-    float k0 = noiseOctave0.x;
-    float k1 = noiseOctave1.y;
-    float k2 = noiseOctave2.z;
-    float k3 = noiseOctave3.w;
+    // Wind velocity at this fragment, shared by all the layers
+    vec3 velocity = vec3(0.0);
+    if (flowFlag == true)
+        velocity = texture(velocityTexture, noiseTexCoords0 * flowScale).xyz;
+
+    // The octave loop does its own fetches, all from the first layer
+    if (octaveLoopFlag == true) {
+        float turbulence = loopTurbulence(noiseTexCoords0, velocity);
+        float fogFactor = clamp(exp(-pow(distance*density*turbulence, 2.0f)), 0.0f, 1.0f);
+        fragColor = mix(fogColor, geoColor, fogFactor);
+        return;
+    }
+
+    // All four layers share their coordinates unless the fog is animated, so a single fetch gets all of them
+    // Animated fog samples each layer it uses at its own coordinates, still from the one texture
+    vec4 layers = sampleLayers(noiseTexCoords0, velocity);
+    if (animationFlag == true && background == false) {
+        if (numOctaves >= 8)
+            layers.y = sampleLayers(noiseTexCoords1, velocity).y;
+        if (numOctaves >= 16)
+            layers.z = sampleLayers(noiseTexCoords2, velocity).z;
+        if (numOctaves >= 32)
+            layers.w = sampleLayers(noiseTexCoords3, velocity).w;
+    }
+
+    // For each layer, get the appropriate coordinate for turbulence calculations
+    float k0 = layers.x;
+    float k1 = layers.y;
+    float k2 = layers.z;
+    float k3 = layers.w;
+
+    // For evolving fog the layers come from the time slices instead, all four with a single fetch per slice
+    if (evolveFlag == true) {
+        vec4 noiseSlice = mix(texture(previousSlice, noiseTexCoords0), texture(currentSlice, noiseTexCoords0), sliceBlend);
+        k0 = noiseSlice.x;
+        k1 = noiseSlice.y;
+        k2 = noiseSlice.z;
+        k3 = noiseSlice.w;
+    }
 
     // Set up variables for fog formula
     float fogFactor = 0.0f;